@@ -0,0 +1,25 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <Arduino.h>
+
+// Request classes for the web server. While a run is active, heavy requests
+// are turned away (503 + Retry-After) so they can't compete with sampling.
+enum RequestClass {
+    REQUEST_CRITICAL,   // Status, current run, stop - always served
+    REQUEST_STANDARD,   // Small reads and writes - always served
+    REQUEST_HEAVY,      // Charts, downloads, file dumps - refused during a run
+    REQUEST_CLASS_COUNT
+};
+
+// Decide whether a request may run now; counts a rejection if not
+bool admitRequest(RequestClass requestClass);
+
+// Record the start and end of an admitted request
+void requestStarted(RequestClass requestClass);
+void requestFinished(RequestClass requestClass, unsigned long elapsedMicros);
+
+// Per-class counters and latency as JSON
+String getAdmissionStats();
+
+#endif
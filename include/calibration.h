@@ -0,0 +1,52 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <Arduino.h>
+#include <vector>
+#include "load_cell.h"
+#include "json_writer.h"
+
+// Multi-point load cell calibration. A session walks through a list of known
+// weights, the unloaded stand first: for each it gives the user time to place
+// the weight, then averages conversions as the load cell delivers them
+// (handleCalibration() never waits for one). A linear or quadratic
+// least-squares fit over all points becomes the load cell curve and is saved
+// in Preferences.
+
+#define CALIBRATION_MAX_POINTS 8
+
+struct CalibrationPoint {
+    float grams;      // Known weight
+    float counts;     // Mean net counts measured
+    float noise;      // Standard deviation of the counts
+    float residual;   // Fitted minus known, grams
+};
+
+struct CalibrationFit {
+    bool ok;
+    int degree;
+    LoadCellCurve curve;
+    float rmsError;            // Grams
+    float maxError;            // Grams
+    float linearityErrorPct;   // Largest deviation from the best straight line, % of the largest weight
+};
+
+// Least-squares fit of grams against counts (degree 1 or 2); fills in the residuals
+CalibrationFit fitCalibration(std::vector<CalibrationPoint>& points, int degree);
+
+// Start a session; 0 g is added if missing. A quadratic fit needs 3 distinct weights.
+// False if the weights or degree are unusable.
+bool startCalibration(const std::vector<float>& weights, int degree);
+
+// Advance the session (call in loop)
+void handleCalibration();
+
+bool isCalibrationRunning();
+
+// Session progress and, once finished, the fit: {"step":..,"message":..,"complete":..,"success":..,...}
+void writeCalibrationStatus(JsonWriter& json);
+
+// Apply the saved curve (or a factor saved by older firmware) to the load cell
+bool loadCalibration();
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// Measurement channels: thrust from the load cell, plus optional torque from
+// a second HX711 and RPM from an optical sensor on the pulse counter. All of
+// them are read on the sampler's tick, so each logged row holds one
+// timestamp's values: thrust is the conversion read at the tick, torque the
+// latest conversion of its amplifier (both HX711s convert at the same rate,
+// so they are at most one conversion apart) and RPM the pulses counted over
+// the last RPM_WINDOW_SAMPLES ticks.
+
+enum Channel {
+    CHANNEL_THRUST,   // Grams
+    CHANNEL_TORQUE,   // N·mm
+    CHANNEL_RPM,
+    CHANNEL_COUNT
+};
+
+#define CHANNEL_BIT(channel) (1u << (channel))
+
+struct ChannelSample {
+    float value[CHANNEL_COUNT];
+};
+
+struct ChannelConfig {
+    bool torqueEnabled;
+    float torqueFactor;      // Counts per N·mm
+    bool rpmEnabled;
+    uint8_t pulsesPerRev;    // Marks on the hub the sensor sees per revolution
+};
+
+// Load the saved channel settings and start the enabled inputs (tares torque)
+bool initChannels();
+
+const ChannelConfig& getChannelConfig();
+
+// Apply and save settings
+bool setChannelConfig(const ChannelConfig& config);
+
+// CHANNEL_BIT mask of the channels runs are logged with; thrust is always on
+uint8_t enabledChannels();
+
+// CSV column name
+const char* channelColumn(Channel channel);
+
+// Read every enabled channel for one sample (call once per sampler tick)
+void readChannels(ChannelSample& sample);
+
+// Switch the sources of the extra channels (e.g. to the simulator); restarts them
+bool setChannelSources(LoadCellDriver& torque, PulseCounter& pulses);
+
+#endif
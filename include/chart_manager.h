@@ -2,8 +2,28 @@
 #define CHART_MANAGER_H
 
 #include <Arduino.h>
+#include "json_writer.h"
 
-// Generate chart data JSON from multiple CSV files
-String generateChartData(const String* fileNames, int fileCount);
+// What a chart plots: a logged channel (channels.h), or one derived from them
+enum ChartChannel {
+    CHART_THRUST,
+    CHART_TORQUE,
+    CHART_RPM,
+    CHART_POWER,        // Shaft power, W: torque x angular speed
+    CHART_EFFICIENCY    // Thrust per shaft watt, g/W
+};
+
+// Parse "thrust", "torque", "rpm", "power" or "efficiency"
+bool parseChartChannel(const String& name, ChartChannel& channel);
+
+// Generate chart data JSON from multiple CSV files into the request arena
+// (see request_arena.h); nullptr when it does not fit in memory. Files
+// without the columns a channel needs give an empty dataset.
+const char* generateChartData(const String* fileNames, int fileCount, size_t& length,
+                              ChartChannel channel = CHART_THRUST);
+
+// The same dataset written point by point to json, for output that has to
+// stream in constant memory (the ZIP export)
+void writeChartData(JsonWriter& json, const String* fileNames, int fileCount, ChartChannel channel);
 
 #endif
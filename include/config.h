@@ -12,12 +12,79 @@
 #define RUNS_DIR "/data/runs"
 #define CHARTS_DIR "/data/charts"
 #define CONFIGS_DIR "/data/configs"
+#define CATALOG_FILE "/data/catalog.bin"
+#define ARCHIVE_DIR "/data/archive"
+#define CATALOG_TOMBSTONES_MAX 64  // Removals remembered for /api/sync
+#define CATALOG_REBUILD_STEP_FILES 8     // Directory entries read per catalog rebuild job step
+#define CATALOG_SUMMARY_STEP_BYTES 2048  // CSV bytes scanned for file stats per job step
+#define COMPRESS_TMP_FILE "/data/compress.tmp"
+#define COMPRESS_MIN_BYTES 4096    // Smaller run files are left raw: they fit one flash block anyway
+#define COMPRESS_KEEP_PERCENT 85   // Compressed copies larger than this share of the CSV are dropped
+#define COMPRESS_STEP_BYTES 1024   // CSV bytes compressed or checked per job step
+#define RUN_JOURNAL_FILE "/data/run.journal"
+#define RUN_JOURNAL_CHECKPOINT_MS 5000   // Between syncs of the recording file and its journal record
+#define RUN_RECOVERY_SCAN_BYTES 16384    // Tail of an interrupted file read at boot; > rows per checkpoint
+
+// Storage management (storage_manager.h)
+#define STORAGE_DEFAULT_MAX_RUN_S 300        // Run length room is made for
+#define STORAGE_MIN_RUN_S 30                 // Runs with room for less are refused
+#define STORAGE_DEFAULT_RESERVE_BYTES 65536  // Kept free for configs, the catalog and compression
+#define STORAGE_WEAR_SAVE_BYTES 65536        // Bytes written between saves of the wear counter
+#define FLASH_RATED_ERASE_CYCLES 100000      // Per block, for the wear estimate
+
+// Background work
+#define FILE_BATCH_INLINE_MAX 16  // Larger batches (or any batch during a run) go to the background
+#define JOB_SLICE_MS 10           // Time budget per loop for background jobs
+
+// Headless recording (BOOT button / thrust trigger)
+#define TRIGGER_DEFAULT_RUN "Headless"   // Run config that triggered recordings go to
+#define TRIGGER_DEFAULT_START_GRAMS 20.0 // Filtered thrust that starts an armed run; 0 = button starts at once
+#define TRIGGER_DEFAULT_STOP_GRAMS 5.0   // Smoothed thrust below which a run is ending
+#define TRIGGER_DEFAULT_STOP_HOLD_MS 2000 // ...for this long before it is stopped
+#define TRIGGER_FILTER_ALPHA 0.3         // Weight of each new reading in the trigger's smoothed thrust
+#define TRIGGER_HOLDBACK_MAX 200         // Samples of a possible tail kept in RAM (16 bytes each) before being written
+#define BUTTON_DEBOUNCE_MS 50
+#define TIME_VALID_EPOCH 1577836800      // 2020-01-01; an earlier clock has not been set by NTP
 
 // Load cell configuration
 #define LOAD_CELL_CALIBRATION_FACTOR 661.41  // Adjust during calibration
-#define SAMPLE_RATE_MS 100  // 10 samples per second
+#define ZERO_TRACK_WINDOW 20           // Idle readings per zero estimate
+#define ZERO_TRACK_SETTLE_MS 3000      // Idle time after a run before tracking resumes
+#define ZERO_TRACK_BAND_GRAMS 3.0      // Larger offsets are a load on the stand, not drift
+#define ZERO_TRACK_MAX_NOISE_GRAMS 0.5 // Windows noisier than this are not idle
+#define ZERO_TRACK_GAIN 0.5            // Fraction of each estimate applied to the tare
+
+#ifndef SAMPLE_RATE_MS
+#define SAMPLE_RATE_MS 100  // 10 samples per second (override with -DSAMPLE_RATE_MS=12 for 80 SPS)
+#endif
+
+// Extra channels (torque and RPM, see channels.h)
+#define TORQUE_DOUT_PIN 17
+#define TORQUE_SCK_PIN 5
+#define TORQUE_CALIBRATION_FACTOR 100.0  // Counts per N·mm; set through /api/channels
+#define RPM_PIN 18
+#define RPM_WINDOW_SAMPLES 5             // Sample periods the RPM is counted over
+
+// USB serial: debug prints and the binary sample stream (serial_stream.h)
+#define SERIAL_BAUD 921600
+
+// UDP sample stream to a collector (udp_stream.h)
+#define UDP_BATCH_SAMPLES 20     // Samples per datagram (16 bytes each with all channels)
+#define UDP_BATCH_MAX_MS 500     // Longest a sample waits for its batch to fill
+#define UDP_DEFAULT_STAND "thrustplotter"
+
+// Tracing
+#define TRACE_RING_SIZE 512  // Events kept for /api/debug/trace (16 bytes each)
+#define TRACE_MAX_NAMES 48   // Distinct dynamic names (HTTP routes)
+
+// Metrics
+#define METRICS_MAX_ROUTES 48  // HTTP routes with their own latency histogram
 
 // Web server
 #define WEB_SERVER_PORT 80
+#define BUSY_RETRY_AFTER_S 10  // Retry-After sent when heavy requests are refused during a run
+#define JSON_RESPONSE_BUFFER 512  // Stack buffer of JsonResponse; larger responses go out chunked
+#define REQUEST_ARENA_CHUNK 8192  // Allocation unit of the per-request arena (PSRAM when fitted)
+#define EXPORT_MAX_ENTRIES 64     // Files in one ZIP export (zip_stream.h)
 
 #endif
@@ -145,8 +145,14 @@ const char CONFIG_PAGE[] PROGMEM = R"=====(
             </div>
             
             <div id='calibrationForm'>
-                <label for='knownWeight'>Known Weight (grams):</label>
-                <input type='number' id='knownWeight' step='0.1' min='1' placeholder='e.g., 100.0' required>
+                <label for='knownWeight'>Known Weights (grams, comma separated):</label>
+                <input type='text' id='knownWeight' placeholder='e.g., 100, 200, 500' required>
+                
+                <label for='calDegree'>Fit:</label>
+                <select id='calDegree'>
+                    <option value='1'>Linear</option>
+                    <option value='2'>Quadratic (3+ weights)</option>
+                </select>
                 
                 <button type='button' id='calibrateBtn' class='btn-secondary'>Start Calibration</button>
             </div>
@@ -155,8 +161,8 @@ const char CONFIG_PAGE[] PROGMEM = R"=====(
                 <strong>Calibration Steps:</strong>
                 <ol class='instructionsText'>
                     <li>Remove all weight from the load cell, then wait for tare to complete (5 seconds)</li>
-                    <li>Place your known weight on the load cell, then wait for measurements to complete</li>
-                    <li>Calibration factor will be calculated and saved</li>
+                    <li>Place each known weight on the load cell when asked, lightest first, then wait for its measurements to complete</li>
+                    <li>A curve is fitted through all the points and saved</li>
                 </ol>
             </div>
             
@@ -233,17 +239,23 @@ const char CONFIG_PAGE[] PROGMEM = R"=====(
         let calibrationTimer = null;
 
         document.getElementById('calibrateBtn').addEventListener('click', function() {
-            const knownWeight = parseFloat(document.getElementById('knownWeight').value);
+            const weights = document.getElementById('knownWeight').value.split(',')
+                .map(w => w.trim()).filter(w => w.length > 0).map(parseFloat);
+            const degree = parseInt(document.getElementById('calDegree').value);
             
-            if (!knownWeight || knownWeight <= 0) {
-                showCalibrationStatus('Please enter a valid weight', 'error');
+            if (weights.length === 0 || weights.some(w => !w || w <= 0)) {
+                showCalibrationStatus('Please enter valid weights', 'error');
+                return;
+            }
+            if (degree === 2 && new Set(weights).size < 3) {
+                showCalibrationStatus('A quadratic fit needs at least 3 weights', 'error');
                 return;
             }
 
-            startCalibration(knownWeight);
+            startCalibration(weights, degree);
         });
 
-        function startCalibration(knownWeight) {
+        function startCalibration(weights, degree) {
             const btn = document.getElementById('calibrateBtn');
             const instructions = document.getElementById('calibrationInstructions');
             const progress = document.getElementById('calibrationProgress');
@@ -257,14 +269,14 @@ const char CONFIG_PAGE[] PROGMEM = R"=====(
             fetch('/api/calibration/start', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/json'},
-                body: JSON.stringify({knownWeight: knownWeight})
+                body: JSON.stringify({weights: weights, degree: degree})
             })
             .then(response => response.json())
             .then(data => {
                 if (data.success) {
                     pollCalibrationStatus();
                 } else {
-                    showCalibrationStatus('Failed to start calibration', 'error');
+                    showCalibrationStatus('Failed to start calibration: ' + (data.message || ''), 'error');
                     resetCalibrationUI();
                 }
             })
@@ -288,7 +300,9 @@ const char CONFIG_PAGE[] PROGMEM = R"=====(
                             
                             if (data.success) {
                                 document.getElementById('currentCalibration').textContent = data.calibrationFactor.toFixed(2);
-                                showCalibrationStatus('Calibration complete! Factor: ' + data.calibrationFactor.toFixed(2), 'success');
+                                showCalibrationStatus('Calibration complete! Factor: ' + data.calibrationFactor.toFixed(2) +
+                                    ', RMS error: ' + data.rmsError.toFixed(2) + 'g, nonlinearity: ' +
+                                    data.linearityErrorPct.toFixed(3) + '%', 'success');
                             } else {
                                 showCalibrationStatus('Calibration failed: ' + data.message, 'error');
                             }
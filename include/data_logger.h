@@ -2,26 +2,45 @@
 #define DATA_LOGGER_H
 
 #include <Arduino.h>
+#include "fixed_string.h"
+#include "channels.h"
+
+struct DataFileStats {
+    uint32_t samples;
+    uint32_t durationMs;
+    float peakThrust;
+};
 
 // Initialize data logger
 bool initDataLogger();
 
-// Create a new CSV file for logging
-bool createDataFile(const String& fileName);
+// Full path of a data file: names are taken relative to RUNS_DIR, full paths are kept
+PathString runFilePath(const String& fileName);
+
+// Create a new CSV file for logging, with a column for each of the channels
+// (CHANNEL_BIT mask); a comment becomes a "# " line after the column header
+bool createDataFile(const String& fileName, const char* comment = nullptr,
+                    uint8_t channels = CHANNEL_BIT(CHANNEL_THRUST));
+
+// Log a sample to the current file: the channels it was created with
+bool logSample(const ChannelSample& sample, unsigned long timestamp);
 
-// Log a thrust sample to the current file
+// Log a thrust-only sample (other channels 0)
 bool logSample(float thrust, unsigned long timestamp);
 
+// Flush the current file to flash; returns the bytes it now holds
+size_t syncDataFile();
+
 // Close the current data file
 void closeDataFile();
 
-// Read CSV file contents
+// Read CSV file contents (compressed files are expanded, see run_compression.h)
 String readDataFile(const String& fileName);
 
 // Delete a data file
 bool deleteDataFile(const String& fileName);
 
-// Get file size
+// Get file size: that of the CSV, for compressed files too
 size_t getFileSize(const String& fileName);
 
 // List all CSV files in a directory
@@ -30,5 +49,22 @@ String listDataFiles(const String& directory);
 // Get sample count
 int getSampleCount();
 
+// Get stats of the file currently being logged
+DataFileStats getCurrentFileStats();
+
+// Bytes written to the file currently (or last) being logged
+size_t getCurrentFileBytes();
+
+// Layout of the file currently being logged: its channels and header comment
+uint8_t getCurrentFileChannels();
+const char* getCurrentFileComment();
+
+// Compute stats of an existing CSV file by reading it through once
+bool scanDataFileStats(const String& fileName, DataFileStats& stats);
+
+// Add the rows in about the next maxBytes of an open CSV to stats, for
+// scanning a file a piece at a time; returns false once it is at the end
+bool scanDataFileRows(Stream& file, size_t maxBytes, DataFileStats& stats);
+
 #endif
 
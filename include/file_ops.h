@@ -0,0 +1,41 @@
+#ifndef FILE_OPS_H
+#define FILE_OPS_H
+
+#include <Arduino.h>
+#include <vector>
+
+enum FileOpType {
+    FILE_OP_DELETE,
+    FILE_OP_RENAME,
+    FILE_OP_ARCHIVE   // Move into ARCHIVE_DIR, keeping the file name
+};
+
+struct FileOp {
+    FileOpType type;
+    String path;
+    String target;    // Destination path for FILE_OP_RENAME
+    bool done;
+    bool ok;
+    String error;
+    bool afterSuccess = false;  // In a batch, skipped if an earlier operation failed
+};
+
+// Parse an operation name ("delete", "rename", "archive"); returns false if unknown
+bool parseFileOpType(const String& name, FileOpType& type);
+
+// Run a single operation immediately, filling in its result fields
+void runFileOp(FileOp& op);
+
+// Queue a batch as a background job, one operation per step; returns its id
+int submitFileBatch(const std::vector<FileOp>& ops);
+
+// Run the remaining operations of a batch right away
+void finishFileBatch(int batchId);
+
+// Whether a batch still has operations to run (false once finished or cancelled)
+bool isFileBatchActive(int batchId);
+
+// Get progress and per-item results of a batch as JSON ("" if the id is unknown)
+String getFileBatchStatus(int batchId);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+// Fixed-capacity string kept inline (stack or static storage), for paths and
+// other short text built on hot paths. Appends past the capacity are cut off
+// and flagged instead of allocating.
+template <size_t N>
+class FixedString {
+public:
+    FixedString() { clear(); }
+    FixedString(const char* s) {
+        clear();
+        append(s);
+    }
+
+    void clear() {
+        len = 0;
+        buf[0] = '\0';
+        overflow = false;
+    }
+
+    FixedString& append(const char* s, size_t n) {
+        if (len + n > N) {
+            n = N - len;
+            overflow = true;
+        }
+        memcpy(buf + len, s, n);
+        len += n;
+        buf[len] = '\0';
+        return *this;
+    }
+
+    FixedString& append(const char* s) { return s ? append(s, strlen(s)) : *this; }
+    FixedString& append(const String& s) { return append(s.c_str(), s.length()); }
+    FixedString& append(char c) { return append(&c, 1); }
+
+    FixedString& appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf + len, N + 1 - len, format, args);
+        va_end(args);
+        if (n < 0) return *this;
+        if (len + n > N) {
+            len = N;
+            overflow = true;
+        } else {
+            len += n;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    FixedString& operator+=(const T& s) { return append(s); }
+
+    const char* c_str() const { return buf; }
+    operator const char*() const { return buf; }
+    size_t length() const { return len; }
+    bool truncated() const { return overflow; }
+    static size_t capacity() { return N; }
+
+    bool operator==(const char* s) const { return strcmp(buf, s) == 0; }
+    bool operator!=(const char* s) const { return strcmp(buf, s) != 0; }
+    bool startsWith(const char* prefix) const { return strncmp(buf, prefix, strlen(prefix)) == 0; }
+
+private:
+    char buf[N + 1];
+    size_t len;
+    bool overflow;
+};
+
+// Long enough for any LittleFS path this firmware builds
+#define PATH_MAX_LEN 128
+typedef FixedString<PATH_MAX_LEN> PathString;
+
+#endif
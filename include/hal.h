@@ -0,0 +1,64 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+// Hardware abstraction layer.
+//
+// The clock (millis/micros), filesystem (LittleFS / fs::FS) and HTTP transport
+// (WebServer) are used through their Arduino-ESP32 APIs. The ESP32 build gets
+// them from the core; [env:native] gets POSIX implementations of the same
+// APIs from lib/native_hal. Everything else that touches hardware goes
+// through the interfaces below, implemented in src/hal_esp32.cpp and
+// src/native/hal_native.cpp.
+
+// Bridge amplifier delivering raw signed ADC counts
+class LoadCellDriver {
+public:
+    virtual ~LoadCellDriver() {}
+    virtual bool begin(uint8_t doutPin, uint8_t sckPin) = 0;
+    virtual bool isReady() = 0;
+    virtual long readRaw() = 0;   // Waits for the next conversion
+    virtual const char* name() const = 0;
+};
+
+// The load cell hardware of this build (HX711 on ESP32). Each index is its
+// own amplifier: 0 is thrust, further ones are extra channels (torque).
+#define HARDWARE_LOAD_CELLS 2
+LoadCellDriver& hardwareLoadCellDriver(uint8_t index = 0);
+
+// Counts rising edges on a pin without CPU involvement (PCNT on ESP32)
+class PulseCounter {
+public:
+    virtual ~PulseCounter() {}
+    virtual bool begin(uint8_t pin) = 0;
+    virtual uint32_t takeCount() = 0;   // Pulses since the previous call
+    virtual const char* name() const = 0;
+};
+
+PulseCounter& hardwarePulseCounter();
+
+// Heap and PSRAM state (zeros where the platform has no equivalent)
+struct HeapInfo {
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;        // Low-water mark since boot
+    uint32_t largestFreeBlock;
+    uint32_t psramSize;
+    uint32_t psramFree;
+};
+HeapInfo heapInfo();
+
+// Memory for large transient buffers: PSRAM when the module has it, the
+// internal heap otherwise. Release with largeFree().
+void* largeAlloc(size_t size);
+void* largeRealloc(void* ptr, size_t size);
+void largeFree(void* ptr);
+
+// Cut a LittleFS file down to its first size bytes (fs::File cannot)
+bool truncateFile(const char* path, size_t size);
+
+// Free-running cycle counter for tracing (CPU cycles on ESP32, wraps)
+uint32_t cycleCount();
+uint32_t cyclesPerMicrosecond();
+
+#endif
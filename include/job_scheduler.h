@@ -0,0 +1,52 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <Arduino.h>
+#include <functional>
+
+// Cooperative background jobs for maintenance work (catalog rebuilds,
+// batch file operations, ...). Each call to a job's step function must do a
+// small bounded amount of work. Jobs never run while a run is active.
+
+enum JobPriority {
+    JOB_PRIORITY_LOW,
+    JOB_PRIORITY_NORMAL,
+    JOB_PRIORITY_HIGH
+};
+
+enum JobState {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_CANCELLED
+};
+
+struct JobStatus {
+    int id;
+    String name;
+    JobPriority priority;
+    JobState state;
+    uint32_t done;      // Progress in job-defined units
+    uint32_t total;
+    String message;
+};
+
+// Do one step of work; return true while there is more to do
+typedef std::function<bool(JobStatus& status)> JobStep;
+
+// Queue a job; returns its id
+int scheduleJob(const String& name, JobPriority priority, JobStep step);
+
+// Check whether a job with this name is queued or running
+bool isJobPending(const String& name);
+
+// Cancel a queued or running job
+bool cancelJob(int jobId);
+
+// Run job steps for up to JOB_SLICE_MS (call in loop)
+void handleJobs();
+
+// Get all current and recently finished jobs as JSON
+String getJobsStatus();
+
+#endif
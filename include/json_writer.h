@@ -0,0 +1,74 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+// Streaming JSON writer over a caller-provided buffer (normally on the
+// stack), for responses that are built often and should not touch the heap.
+// With a sink the buffer is handed over whenever it fills, so output of any
+// size can be produced; without one, output that does not fit sets
+// overflowed().
+typedef void (*JsonSink)(void* context, const char* data, size_t length);
+
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t capacity, JsonSink sink = nullptr, void* sinkContext = nullptr);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(const char* s);
+    JsonWriter& value(const String& s) { return value(s.c_str()); }
+    JsonWriter& value(bool b);
+    JsonWriter& value(int n) { return value((long long)n); }
+    JsonWriter& value(unsigned int n) { return value((unsigned long long)n); }
+    JsonWriter& value(long n) { return value((long long)n); }
+    JsonWriter& value(unsigned long n) { return value((unsigned long long)n); }
+    JsonWriter& value(long long n);
+    JsonWriter& value(unsigned long long n);
+    JsonWriter& value(double n, int decimals = -1);   // -1: shortest round-trip-ish (%.9g)
+    JsonWriter& null();
+
+    template <typename T>
+    JsonWriter& field(const char* name, const T& v) { return key(name).value(v); }
+    JsonWriter& field(const char* name, double v, int decimals) { return key(name).value(v, decimals); }
+
+    // Hand buffered output to the sink now
+    void flush();
+
+    const char* c_str() const { return buf; }
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+
+private:
+    void separator();
+    void quoted(const char* s);
+    void raw(const char* s, size_t n);
+    void raw(const char* s) { raw(s, strlen(s)); }
+
+    char* buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+    JsonSink sink;
+    void* sinkContext;
+    uint32_t hasItems;   // Bit per nesting level: a comma is due before the next item
+    uint8_t depth;
+    bool afterKey;
+};
+
+// JsonWriter with its own buffer of N bytes
+template <size_t N>
+class StackJsonWriter : public JsonWriter {
+public:
+    explicit StackJsonWriter(JsonSink sink = nullptr, void* sinkContext = nullptr)
+        : JsonWriter(storage, N, sink, sinkContext) {}
+
+private:
+    char storage[N];
+};
+
+#endif
@@ -2,6 +2,15 @@
 #define LOAD_CELL_H
 
 #include <Arduino.h>
+#include "hal.h"
+
+// Grams from net ADC counts (raw reading minus tare): c0 + c1*x + c2*x^2.
+// A plain calibration factor f is {0, 1/f, 0}.
+struct LoadCellCurve {
+    float c0;
+    float c1;
+    float c2;
+};
 
 // Initialize the load cell
 bool initLoadCell(uint8_t doutPin, uint8_t sckPin);
@@ -16,7 +25,27 @@ void tareLoadCell();
 //void calibrateLoadCell(float knownWeight);
 void setLoadCellCalibration(float calibrationFactor);
 
+// Calibration curve fitted by calibration.h
+void setLoadCellCurve(const LoadCellCurve& curve);
+const LoadCellCurve& getLoadCellCurve();
+
+// Thrust in grams of a net reading
+float netCountsToThrust(long counts);
+
+// Current zero, in raw counts
+long getTareOffset();
+
+// Net counts of the next conversion if one is ready; never waits
+bool readNetCounts(long& counts);
+
+// Move the zero by netCounts, e.g. to an unloaded reading averaged elsewhere
+void adjustTare(long netCounts);
+
 // Check if load cell is ready
 bool isLoadCellReady();
 
+// Switch the source of readings (e.g. to simLoadCellDriver()); re-initializes and tares
+bool setLoadCellDriver(LoadCellDriver& newDriver);
+const char* getLoadCellDriverName();
+
 #endif
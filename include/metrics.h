@@ -0,0 +1,44 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Runtime metrics for GET /metrics (Prometheus text format). Recording is a
+// few relaxed atomic increments, so it is safe on the sampling path.
+// Histograms use power-of-4 microsecond buckets from 1 us to ~4.2 s.
+
+enum MetricHistogram {
+    METRIC_LOOP_US,              // One main loop iteration
+    METRIC_SAMPLE_INTERVAL_US,   // Between consecutive logged samples
+    METRIC_FILE_WRITE_US,        // logSample() including any flush
+    METRIC_FLASH_FLUSH_US,       // Flushing the data file to flash
+    METRIC_HISTOGRAM_COUNT
+};
+
+enum MetricCounter {
+    METRIC_SAMPLES_LOGGED,
+    METRIC_LOADCELL_NOT_READY,   // Reads skipped because no conversion was ready
+    METRIC_COUNTER_COUNT
+};
+
+// Boot milestones, exported as seconds since boot once reached
+enum MetricMoment {
+    METRIC_BOOT_READY,           // setup() finished; sampling and logging work
+    METRIC_WIFI_CONNECTED,       // First time the station link came up
+    METRIC_TIME_SYNCED,          // First NTP fix
+    METRIC_MOMENT_COUNT
+};
+
+void metricObserve(MetricHistogram histogram, uint32_t micros);
+void metricCount(MetricCounter counter);
+
+// Records millis() the first time it is called for a moment
+void metricMark(MetricMoment moment);
+
+// HTTP latency per route; route must be a stable pointer (see traceName())
+void metricObserveRoute(const char* route, uint32_t micros);
+
+// Prometheus exposition text in pieces: call with 0, 1, 2... until it returns ""
+String metricsChunk(size_t index);
+
+#endif
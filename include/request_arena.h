@@ -0,0 +1,47 @@
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Memory for large transient data (JSON documents, response bodies) kept out
+// of internal DRAM, which WiFi and LittleFS need.
+//
+// psramAllocator() is a plain heap allocator preferring PSRAM (see
+// largeAlloc()). The request arena is a bump allocator over PSRAM chunks
+// that is released in one go when the outermost RequestArenaScope ends;
+// runAdmitted() opens one around every HTTP handler.
+
+ArduinoJson::Allocator* psramAllocator();
+
+// Allocator for JsonDocuments that live no longer than the current request.
+// Outside a request scope it is psramAllocator(), so callers need not care.
+ArduinoJson::Allocator* arenaAllocator();
+
+// Raw arena memory, valid until the scope ends; nullptr outside a scope or
+// when out of memory
+void* arenaAlloc(size_t size);
+
+class RequestArenaScope {
+public:
+    RequestArenaScope();
+    ~RequestArenaScope();
+};
+
+struct ArenaStats {
+    size_t chunkBytes;    // Reserved by the current request
+    size_t peakBytes;     // Most reserved by any request since boot
+    uint32_t requests;    // Scopes that used the arena
+};
+ArenaStats arenaStats();
+
+// Serialize doc into the arena; nullptr when out of memory
+template <typename TDocument>
+const char* serializeJsonToArena(const TDocument& doc, size_t& length) {
+    length = measureJson(doc);
+    char* buffer = (char*)arenaAlloc(length + 1);
+    if (buffer) serializeJson(doc, buffer, length + 1);
+    return buffer;
+}
+
+#endif
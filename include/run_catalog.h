@@ -0,0 +1,107 @@
+#ifndef RUN_CATALOG_H
+#define RUN_CATALOG_H
+
+#include <Arduino.h>
+#include <vector>
+#include "data_logger.h"
+#include "run_compression.h"
+
+// In-RAM index of run configs and their data files. Built once at boot
+// (from the snapshot file when present) and kept current by run_manager,
+// so listing requests never have to walk LittleFS.
+
+struct RunFileInfo {
+    String name;
+    size_t size;      // Of the CSV, however it is stored
+    DataFileStats stats;
+    bool hasStats;    // False until the summary job has scanned the file
+    uint32_t changed = 0;  // Sync cursor of the last change
+    size_t storedSize = 0;  // Bytes on flash; 0 when put = size (a raw file)
+    RunFileStorage storage = STORAGE_RAW;
+    bool recovered = false;  // Cut short by a reset and repaired at boot (run_journal.h)
+};
+
+struct RunListing {
+    String name;
+    String notes;
+    String created;
+    std::vector<RunFileInfo> files;
+    size_t totalBytes;
+    uint32_t changed = 0;  // Sync cursor of the last change to the config
+    bool starred = false;  // Kept by the retention policy (storage_manager.h)
+};
+
+// Change feed for replication (/api/sync). Each change to a run or data file
+// entry takes the next cursor value and stamps it on the entry; removals
+// leave a tombstone. Only the last CATALOG_TOMBSTONES_MAX tombstones are
+// kept, so a client whose cursor is older than the horizon, or from another
+// epoch (every rebuild starts one), has to compare full listings instead.
+struct CatalogTombstone {
+    String name;      // Run name, or data file name relative to RUNS_DIR
+    bool isRun;
+    uint32_t changed;
+};
+
+struct CatalogSyncState {
+    uint32_t epoch;
+    uint32_t cursor;    // Latest change
+    uint32_t horizon;   // Changes after this are all known
+};
+
+// Load the catalog snapshot, or rescan the filesystem if there isn't a usable one
+bool initRunCatalog();
+
+// Discard the catalog and rebuild it from /data/configs and /data/runs.
+// File stats are filled in afterwards by a background job.
+void rebuildRunCatalog();
+
+// The same as a background job, a few directory entries per step. The new
+// catalog replaces the old one once complete; returns the job id.
+int scheduleCatalogRebuild();
+
+// All runs, in no particular order
+const std::vector<RunListing>& catalogRuns();
+
+// Find a run by its original (unsanitized) name, or nullptr
+const RunListing* catalogFindRun(const String& runName);
+
+// Add or replace a run config entry
+void catalogPutRun(const String& name, const String& notes, const String& created);
+
+// Update the notes of an existing run
+void catalogSetNotes(const String& runName, const String& notes);
+
+// Star or unstar an existing run
+void catalogSetStarred(const String& runName, bool starred);
+
+// Remove a run and all of its file entries
+void catalogRemoveRun(const String& runName);
+
+// Add or update a data file entry (fileName is relative to RUNS_DIR). Entries
+// without stats get them from a background job.
+void catalogPutFile(const String& fileName, const RunFileInfo& info);
+
+// Remove a data file entry (fileName is relative to RUNS_DIR)
+void catalogRemoveFile(const String& fileName);
+
+// Find a data file entry, or nullptr
+const RunFileInfo* catalogFindFile(const String& fileName);
+
+// Record that a file was compressed in place (or found not worth it). Its
+// content is unchanged, so this is not a change for /api/sync.
+void catalogSetStorage(const String& fileName, size_t storedSize, RunFileStorage storage);
+
+// Keep the catalog in sync after an arbitrary filesystem change (explorer delete/rename)
+void catalogPathChanged(const String& path);
+
+// Group a series of changes: the snapshot is written once, by the outermost
+// catalogCommit(), instead of after every change. Batches nest.
+void catalogBeginBatch();
+void catalogCommit();
+
+CatalogSyncState catalogSyncState();
+
+// Removals after the horizon, oldest first
+const std::vector<CatalogTombstone>& catalogTombstones();
+
+#endif
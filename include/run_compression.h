@@ -0,0 +1,102 @@
+#ifndef RUN_COMPRESSION_H
+#define RUN_COMPRESSION_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <memory>
+
+// Finished run files are compressed in place by a background job, keeping
+// their names, so the catalog, /api/sync and downloads see the same files
+// as before. A compressed file starts with a 12-byte header (magic, CSV
+// size, CRC-32 of the CSV) followed by LZSS tokens over a 2 KB window: a
+// flag byte per 8 items, 1 = match, stored as the u16 (distance - 1) << 5 |
+// (length - 3). Raw CSVs start with their column names, so the two can
+// always be told apart.
+//
+// Everything that reads run data goes through RunFileReader, which serves
+// raw and compressed files alike as the original CSV.
+
+#define RUN_FILE_MAGIC 0x315A5054  // "TPZ1"
+#define RUN_FILE_HEADER_SIZE 12
+#define RUN_FILE_WINDOW 2048
+
+enum RunFileStorage : uint8_t {
+    STORAGE_RAW,            // Not compressed (yet)
+    STORAGE_COMPRESSED,
+    STORAGE_INCOMPRESSIBLE  // Compression saved too little; kept raw
+};
+
+class RunFileReader : public Stream {
+public:
+    RunFileReader() {}
+    explicit RunFileReader(const char* path) { open(path); }
+    RunFileReader(const RunFileReader&) = delete;
+    RunFileReader& operator=(const RunFileReader&) = delete;
+
+    bool open(const char* path);
+    bool open(File file);
+    void close();
+    explicit operator bool() const { return (bool)file; }
+
+    bool isCompressed() const { return compressed; }
+    bool isDirectory() { return file.isDirectory(); }
+    size_t size() const { return rawSize; }            // Size of the CSV
+    size_t storedSize() const { return file.size(); }  // Bytes on flash
+    uint32_t storedCrc() const { return crc; }         // CRC-32 of the CSV, compressed files only
+    size_t position() const { return peeked >= 0 ? pos - 1 : pos; }
+
+    // Compressed files can only be read forwards; seeking back starts over
+    bool seek(size_t position);
+
+    size_t read(uint8_t* buffer, size_t length);
+    int read() override;
+    int peek() override;
+    int available() override { return rawSize - position(); }
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    int nextInput();
+    int decode();
+    int truncated();
+    void restart();
+
+    File file;
+    bool compressed = false;
+    size_t rawSize = 0;
+    size_t pos = 0;       // Bytes decoded, including a peeked one
+    uint32_t crc = 0;
+    int peeked = -1;
+
+    // Decoder state (compressed files only)
+    std::unique_ptr<uint8_t[]> window;
+    uint16_t windowPos = 0;
+    uint16_t matchDistance = 0;
+    uint8_t matchRemaining = 0;
+    uint8_t flags = 0;
+    uint8_t flagBits = 0;
+    uint8_t input[64];
+    uint8_t inputPos = 0;
+    uint8_t inputLength = 0;
+};
+
+struct RunStorageStats {
+    uint32_t files;
+    uint32_t compressedFiles;
+    uint32_t pendingFiles;       // Raw files the job will still try
+    uint32_t dataBytes;          // CSV size of every run file
+    uint32_t storedBytes;        // What they take on flash
+    uint32_t compressedDataBytes;    // CSV size of the compressed ones...
+    uint32_t compressedStoredBytes;  // ...and their size on flash
+};
+
+// Queue compression of any finished run files that are still raw
+void initRunCompression();
+void scheduleRunCompression();
+
+// One step of the compression job, for the job that makes room for runs
+// (storage_manager.h); returns false once no pending files are left
+bool compressRunFilesStep();
+
+RunStorageStats getRunStorageStats();
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <Arduino.h>
+
+// Crash recovery for the run being recorded. startRun writes a journal
+// record naming its data file to RUN_JOURNAL_FILE; while it records, the
+// file is flushed and the record checkpointed with the bytes and stats now
+// on flash every RUN_JOURNAL_CHECKPOINT_MS; stopRun removes the journal.
+//
+// A journal found at boot belongs to a run a reset or power cut ended.
+// Only the tail of its file past the checkpoint is read (at most
+// RUN_RECOVERY_SCAN_BYTES, so recovery takes the same time for any file
+// size): the file is cut after its last complete row, its stats are the
+// checkpoint's plus those rows, and its catalog entry is marked recovered.
+// LittleFS writes files copy-on-write, so a rewritten journal record is
+// either the old one or the new one.
+
+// Recover the run a reset interrupted, if any (call once the catalog is loaded)
+void initRunJournal();
+
+// The run that just started is recording to fileName
+void journalRunStarted(const String& fileName, const String& runName);
+
+// Checkpoint the active run (call in loop)
+void handleRunJournal();
+
+// The active run was stopped and its file closed
+void journalRunStopped();
+
+#endif
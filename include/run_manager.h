@@ -2,6 +2,9 @@
 #define RUN_MANAGER_H
 
 #include <Arduino.h>
+#include <vector>
+#include "run_catalog.h"
+#include "storage_manager.h"
 
 struct RunConfig {
     String name;
@@ -17,17 +20,24 @@ bool initRunManager();
 // Create a new run configuration
 bool createRunConfig(const String& name, const String& notes);
 
-// Start a run (creates CSV file and begins logging)
-bool startRun(const String& runName);
+// Start a run (creates CSV file and begins logging) if there is room for it
+// (storage_manager.h); the outcome of that check goes to storageCheck when given.
+bool startRun(const String& runName, StorageCheck* storageCheck = nullptr);
 
 // Stop the current run
 bool stopRun();
 
-// Delete a run configuration and all its data files
+// Delete a run configuration and all its data files. Runs with data files
+// are deleted by a file batch, config last (and only if every data file
+// went), and count as deleting until then.
 bool deleteRun(const String& runName);
 
-// Get current run status
-RunConfig getCurrentRun();
+// Whether deleteRun's file batch for this run is still going; it stops
+// counting once the batch finishes or its job is cancelled
+bool isRunDeleting(const String& runName);
+
+// Get current run status (valid until the next startRun/stopRun)
+const RunConfig& getCurrentRun();
 
 // Check if a run is currently active
 bool isRunActive();
@@ -38,10 +48,37 @@ String getRunConfigsList();
 // Get list of all data files for a run
 String getRunDataFiles(const String& runName);
 
+// Get all runs with their data files grouped under them, sorted by creation date
+std::vector<const RunListing*> listRunsWithFiles(bool newestFirst);
+
 // Update run notes
 bool updateRunNotes(const String& runName, const String& notes);
 
+// Star a run, so retention never deletes its files (storage_manager.h)
+bool setRunStarred(const String& runName, bool starred);
+
+// Convert a run name into the form used for config and data file names
+String sanitizeFilename(const String& input);
+
 // Reset StartTime - this is so we can trim zeros off the front of the file.
 void resetStartTime(unsigned long millis);
 
+// True once the wall clock has been set (by NTP)
+bool isClockSet();
+
+// "%y-%m-%d_%T" in local time, as run files and configs are dated
+String formatTimestamp(time_t when);
+
+// Sample timestamps are millis() since the run started, so they are right
+// with or without a wall clock. Files and run configs dated before the clock
+// was set get boot-relative timestamps ("boot<N>+<ms>"); once it is, this
+// renames this boot's files to their wall-clock start time and dates its
+// configs (call in loop). millis() starts over at every boot, so those of a
+// boot that never had the clock keep their boot-relative timestamps.
+void reconcileRunTimestamps();
+
+// Wall-clock start of the first boot after this one that had the clock set;
+// what is left boot-relative from this boot is older. 0 if there is none.
+time_t clockedBootAfter(uint32_t boot);
+
 #endif
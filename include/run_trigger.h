@@ -0,0 +1,59 @@
+#ifndef RUN_TRIGGER_H
+#define RUN_TRIGGER_H
+
+#include <Arduino.h>
+
+// Starting and stopping runs without the web UI, for the field where there
+// is no network: a short press of the BOOT button, or thrust crossing a
+// threshold once armed. The end of a run is detected the same way, on the
+// same smoothed signal: thrust staying below the stop threshold. Runs started
+// or stopped through the web UI move the same state machine.
+
+enum TriggerState {
+    TRIGGER_IDLE,
+    TRIGGER_ARMED,       // Waiting for the smoothed thrust to reach the start threshold
+    TRIGGER_RECORDING,
+    TRIGGER_ENDING       // Below the stop threshold; the run ends unless thrust returns
+};
+
+struct RunTriggerConfig {
+    String runName;         // Run config triggered recordings go to (created if missing)
+    float startThreshold;   // Grams; 0 = a button press starts the run at once
+    bool armAtBoot;         // Arm on power-up, so a stand with no network records unattended
+    bool autoStop;          // End runs when thrust stays below stopThreshold for stopHoldMs
+    float stopThreshold;    // Grams
+    uint32_t stopHoldMs;
+};
+
+// What the sampler should do with a sample of the active run
+enum TriggerVerdict {
+    TRIGGER_KEEP_SAMPLE,    // Write it (and any held samples before it)
+    TRIGGER_HOLD_SAMPLE,    // Possibly the tail; keep it back until thrust returns or the run ends
+    TRIGGER_END_RUN         // Run is over: drop the held tail and stop
+};
+
+// Load the saved trigger settings (and arm if configured to)
+bool initRunTrigger();
+
+// Advance the trigger (call in loop, before handleSampler())
+void handleRunTrigger();
+
+// Short button press: stops a run, cancels an armed trigger, otherwise arms
+// (or starts right away when the thrust trigger is off)
+void runTriggerButton();
+
+// Feed a sample of the active run (from the sampler) to end-of-run detection
+TriggerVerdict runTriggerObserve(float thrust, unsigned long timestamp);
+
+bool armRunTrigger();
+void disarmRunTrigger();
+
+TriggerState getTriggerState();
+const char* triggerStateName(TriggerState state);
+
+const RunTriggerConfig& getRunTriggerConfig();
+
+// Apply and save settings
+bool setRunTriggerConfig(const RunTriggerConfig& config);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <Arduino.h>
+
+// Take a thrust sample when one is due and log it to the active run (call in loop)
+void handleSampler();
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SERIAL_STREAM_H
+#define SERIAL_STREAM_H
+
+#include <Arduino.h>
+#include "channels.h"
+
+// Binary sample stream over the USB serial port, for a bench PC that wants
+// every sample as it is taken without WiFi (frames in stream_protocol.h,
+// receiver in tools/serial_receiver.cpp). While streaming is on, each sample
+// written to the active run's file is also sent, framed and CRC-protected,
+// between run start and stop frames. The same port takes start, stop and
+// config commands. Debug prints keep going to the port; receivers skip them.
+
+// Load the saved setting
+bool initSerialStream();
+
+// Take commands from the port and close out stopped runs (call in loop)
+void handleSerialStream();
+
+// Send a sample of the active run (from the sampler, once it is in the file)
+void serialStreamSample(const ChannelSample& sample, unsigned long timestamp);
+
+bool isSerialStreaming();
+
+// Apply and save
+void setSerialStreaming(bool enabled);
+
+#endif
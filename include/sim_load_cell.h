@@ -0,0 +1,59 @@
+#ifndef SIM_LOAD_CELL_H
+#define SIM_LOAD_CELL_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// Simulated load cell: a LoadCellDriver that produces HX711-style raw counts
+// from a recorded run or a synthetic thrust curve. Output is repeatable for a
+// given config - noise and dropouts are derived from the conversion index.
+// The same curve drives a simulated torque amplifier and RPM pulse input, so
+// the extra channels (channels.h) can be exercised without hardware.
+
+enum SimCurve {
+    SIM_CURVE_STEP,    // amplitude from delayMs for durationMs
+    SIM_CURVE_DECAY,   // amplitude at delayMs, decaying with decayTauMs, cut at durationMs
+    SIM_CURVE_REPLAY   // replayFile (timestamp_ms,thrust_grams) starting at delayMs
+};
+
+struct SimLoadCellConfig {
+    SimCurve curve;
+    float amplitude;             // Grams
+    unsigned long delayMs;       // Idle time before the curve starts
+    unsigned long durationMs;    // Length of the step/decay
+    float decayTauMs;
+    float noiseGrams;            // Gaussian noise, standard deviation
+    float humGrams;              // Mains hum amplitude
+    float humHz;
+    float driftGramsPerMin;      // Zero drift, as a warming load cell shows
+    float torquePerGram;         // Torque channel: N·mm per gram of thrust
+    float rpmPerRootGram;        // RPM channel: RPM = this * sqrt(thrust), one pulse per revolution
+    float dropoutRate;           // Fraction of conversions that never become ready
+    uint16_t samplesPerSecond;   // Conversion rate (HX711 runs at 10 or 80)
+    bool repeat;                 // Start over after the curve ends
+    uint32_t seed;
+    String replayFile;           // Data file name or full path
+};
+
+// Defaults: 1 kg step after 2 s for 5 s, light noise, 80 SPS
+SimLoadCellConfig defaultSimLoadCellConfig();
+
+// Parse "step", "decay" or "replay"
+bool parseSimCurve(const String& name, SimCurve& curve);
+const char* simCurveName(SimCurve curve);
+
+// Configure the simulated driver (loads the replay file); restarts the curve
+bool configureSimLoadCell(const SimLoadCellConfig& config);
+const SimLoadCellConfig& getSimLoadCellConfig();
+
+// Restart the curve from t = 0
+void restartSimLoadCell();
+
+// The simulated driver; install it with setLoadCellDriver()
+LoadCellDriver& simLoadCellDriver();
+
+// Simulated extra channels; install them with setChannelSources()
+LoadCellDriver& simTorqueDriver();
+PulseCounter& simPulseCounter();
+
+#endif
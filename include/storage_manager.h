@@ -0,0 +1,83 @@
+#ifndef STORAGE_MANAGER_H
+#define STORAGE_MANAGER_H
+
+#include <Arduino.h>
+
+// Free-space checks for runs, a quota and retention policy for run files,
+// and fill/wear figures for /api/storage.
+//
+// A run needs room for maxRunSeconds of rows for its channels at the sample
+// rate, free above the reserve and under the quota. That room is made in
+// the background while the stand is idle (at boot, when a run stops, when
+// the trigger is armed or the settings change): pending run files are
+// compressed first if compressFirst is set, then with retention "oldest"
+// the oldest run files are deleted (never those of starred runs when
+// keepStarred is set). Starting a run only checks the room there is: a
+// run with room for less than STORAGE_MIN_RUN_S is refused; one with less
+// than maxRunSeconds starts with a warning. A running run is stopped once
+// it has written the room it was given.
+
+enum RetentionMode {
+    RETENTION_OFF,      // Never delete anything; refuse runs that do not fit
+    RETENTION_OLDEST    // Delete the oldest run files to make room
+};
+
+struct StorageConfig {
+    uint32_t maxRunSeconds;   // Longest run to make room for
+    uint32_t quotaBytes;      // Flash run files may take; 0 = no quota
+    uint32_t reserveBytes;    // Kept free for configs, the catalog and uploads
+    RetentionMode retention;
+    bool compressFirst;       // Compress pending run files before deleting any
+    bool keepStarred;         // Never delete files of starred runs
+};
+
+struct StorageCheck {
+    bool ok;                  // The run may start
+    bool warning;             // ...but may run out of room before maxRunSeconds
+    uint32_t neededBytes;
+    uint32_t availableBytes;
+    String message;
+};
+
+// Flash wear is estimated from the bytes the firmware has written (run
+// files, compressed copies, catalog snapshots) over the partition's life;
+// LittleFS spreads them over all blocks, so total / partition size is the
+// average erase count. Metadata and copy-on-write overhead come on top.
+struct StorageStats {
+    uint32_t totalBytes;
+    uint32_t usedBytes;
+    uint32_t runStoredBytes;  // Flash taken by run files
+    uint32_t availableBytes;  // Room for the next run
+    uint32_t roomSeconds;     // ...in seconds at the current channels and rate
+    uint64_t bytesWritten;
+    float eraseCycles;
+    uint32_t runsRefused;
+    uint32_t runsWarned;
+    uint32_t runsStoppedFull;
+    uint32_t filesDeleted;
+};
+
+bool initStorageManager();
+
+const StorageConfig& getStorageConfig();
+bool setStorageConfig(const StorageConfig& config);
+
+bool parseRetentionMode(const String& name, RetentionMode& mode);
+const char* retentionModeName(RetentionMode mode);
+
+// Check there is room for a run logging these channels (CHANNEL_BIT mask).
+// The run gets checked.availableBytes to write.
+StorageCheck checkRunStorage(uint8_t channels);
+
+// Make room for the next run with a background job
+void scheduleStorageCleanup();
+
+// Stop the run once it has used its room (call in loop)
+void handleStorage();
+
+// Count bytes written to flash, for the wear estimate
+void storageNoteWrite(size_t bytes);
+
+StorageStats getStorageStats();
+
+#endif
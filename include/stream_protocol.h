@@ -0,0 +1,201 @@
+#ifndef STREAM_PROTOCOL_H
+#define STREAM_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Binary sample stream framing, shared by the firmware (serial_stream.h,
+// udp_stream.h) and the receivers in tools/. Plain C++, so the tools build
+// without the Arduino core.
+//
+// Frame: A5 5A | type (1) | length (2) | payload (length) | CRC (2)
+//
+// The CRC is CRC-16/CCITT-FALSE over type, length and payload. Integers and
+// floats are little-endian, as both the ESP32 and x86/ARM hosts store them.
+// Bytes outside frames are skipped, so the debug text that shares the serial
+// port with the stream does no harm.
+//
+// Over UDP each datagram is exactly one STREAM_UDP_BATCH frame. A batch
+// repeats the run's identity, so a collector can file samples from any
+// datagram it receives; the sequence number (per run, from 0) shows which
+// ones it did not.
+
+#define STREAM_SYNC0 0xA5
+#define STREAM_SYNC1 0x5A
+#define STREAM_VERSION 1
+#define STREAM_MAX_PAYLOAD 255
+#define STREAM_FRAME_OVERHEAD 7
+#define STREAM_UDP_MAX_PAYLOAD 1024  // Keeps a datagram inside one Ethernet/WiFi frame
+#define STREAM_UDP_PORT 5005         // Default collector port
+#define STREAM_UDP_FLAG_END 0x01     // Last batch of the run (sent twice, may hold no samples)
+
+enum StreamFrameType : uint8_t {
+    // Device to host
+    STREAM_HELLO = 0x01,       // version u8, sample period ms u16, channel mask u8, streaming u8
+    STREAM_RUN_START = 0x02,   // channel mask u8, file name (u8 length + text), header comment (u8 length + text)
+    STREAM_SAMPLE = 0x03,      // timestamp ms u32, then a float per channel in the run's mask, thrust first
+    STREAM_RUN_STOP = 0x04,    // samples sent u32
+    STREAM_ACK = 0x05,         // command type u8, ok u8, message (rest of payload)
+    STREAM_UDP_BATCH = 0x06,   // stand (text), boot id u32, run u32, sequence u32, flags u8, channel mask u8,
+                               // file name (text), header comment (text), first sample index u32, count u8,
+                               // then count SAMPLE payloads
+
+    // Host to device
+    STREAM_CMD_PING = 0x10,    // Answered with HELLO
+    STREAM_CMD_START = 0x11,   // Run name (whole payload)
+    STREAM_CMD_STOP = 0x12,
+    STREAM_CMD_CONFIG = 0x13   // streaming u8, torque u8, rpm u8: 0 off, 1 on, 0xFF unchanged
+};
+
+inline uint16_t streamCrc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Frame a payload into out (length + STREAM_FRAME_OVERHEAD bytes); returns the frame size
+inline size_t encodeStreamFrame(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out) {
+    out[0] = STREAM_SYNC0;
+    out[1] = STREAM_SYNC1;
+    out[2] = type;
+    out[3] = length & 0xFF;
+    out[4] = length >> 8;
+    memcpy(out + 5, payload, length);
+    uint16_t crc = streamCrc16(out + 2, length + 3);
+    out[5 + length] = crc & 0xFF;
+    out[6 + length] = crc >> 8;
+    return length + STREAM_FRAME_OVERHEAD;
+}
+
+// Check a whole frame received at once (a datagram); points payload into it
+inline bool decodeStreamFrame(const uint8_t* frame, size_t size, uint8_t& type, const uint8_t*& payload,
+                              uint16_t& length) {
+    if (size < STREAM_FRAME_OVERHEAD || frame[0] != STREAM_SYNC0 || frame[1] != STREAM_SYNC1) return false;
+    length = frame[3] | (frame[4] << 8);
+    if (size != length + (size_t)STREAM_FRAME_OVERHEAD) return false;
+    uint16_t crc = frame[5 + length] | (frame[6 + length] << 8);
+    if (crc != streamCrc16(frame + 2, length + 3)) return false;
+    type = frame[2];
+    payload = frame + 5;
+    return true;
+}
+
+// Builds a payload field by field
+template <size_t Capacity>
+struct StreamPayloadBuffer {
+    uint8_t data[Capacity];
+    size_t length = 0;
+
+    void put(const void* value, size_t size) {
+        if (length + size > sizeof(data)) size = sizeof(data) - length;
+        memcpy(data + length, value, size);
+        length += size;
+    }
+    void putU8(uint8_t value) { put(&value, 1); }
+    void putU16(uint16_t value) { put(&value, 2); }
+    void putU32(uint32_t value) { put(&value, 4); }
+    void putFloat(float value) { put(&value, 4); }
+    // u8 length + text, cut to fit
+    void putText(const char* text) {
+        size_t n = strlen(text);
+        if (n > 255) n = 255;
+        putU8((uint8_t)n);
+        put(text, n);
+    }
+};
+
+typedef StreamPayloadBuffer<STREAM_MAX_PAYLOAD> StreamPayload;
+typedef StreamPayloadBuffer<STREAM_UDP_MAX_PAYLOAD> StreamUdpPayload;
+
+// Reads a received payload field by field; reads past the end give zeros
+struct StreamReader {
+    const uint8_t* data;
+    size_t length;
+    size_t pos = 0;
+
+    StreamReader(const uint8_t* payload, size_t size) : data(payload), length(size) {}
+
+    void get(void* value, size_t size) {
+        memset(value, 0, size);
+        if (pos + size <= length) memcpy(value, data + pos, size);
+        pos += size;
+    }
+    uint8_t getU8() { uint8_t v; get(&v, 1); return v; }
+    uint16_t getU16() { uint16_t v; get(&v, 2); return v; }
+    uint32_t getU32() { uint32_t v; get(&v, 4); return v; }
+    float getFloat() { float v; get(&v, 4); return v; }
+    // Copies u8 length + text into out (NUL-terminated, cut to size)
+    void getText(char* out, size_t size) {
+        size_t n = getU8();
+        size_t available = pos < length ? length - pos : 0;
+        size_t copy = n < available ? n : available;
+        if (copy > size - 1) copy = size - 1;
+        memcpy(out, data + pos, copy);
+        out[copy] = '\0';
+        pos += n;
+    }
+};
+
+// Incremental decoder: feed it received bytes one at a time
+class StreamDecoder {
+public:
+    uint8_t type = 0;
+    uint16_t length = 0;
+    uint8_t payload[STREAM_MAX_PAYLOAD];
+    uint32_t frames = 0;
+    uint32_t crcErrors = 0;
+
+    // True when byte completes a frame with a good CRC (then in type/length/payload)
+    bool feed(uint8_t byte) {
+        switch (state) {
+            case WAIT_SYNC0:
+                if (byte == STREAM_SYNC0) state = WAIT_SYNC1;
+                return false;
+            case WAIT_SYNC1:
+                state = byte == STREAM_SYNC1 ? READ_HEADER : (byte == STREAM_SYNC0 ? WAIT_SYNC1 : WAIT_SYNC0);
+                received = 0;
+                return false;
+            case READ_HEADER:
+                header[received++] = byte;
+                if (received == 3) {
+                    type = header[0];
+                    length = header[1] | (header[2] << 8);
+                    received = 0;
+                    state = length > STREAM_MAX_PAYLOAD ? WAIT_SYNC0 : (length ? READ_PAYLOAD : READ_CRC);
+                }
+                return false;
+            case READ_PAYLOAD:
+                payload[received++] = byte;
+                if (received == length) {
+                    received = 0;
+                    state = READ_CRC;
+                }
+                return false;
+            case READ_CRC:
+                crcBytes[received++] = byte;
+                if (received < 2) return false;
+                state = WAIT_SYNC0;
+                if ((crcBytes[0] | (crcBytes[1] << 8)) != streamCrc16(payload, length, streamCrc16(header, 3))) {
+                    crcErrors++;
+                    return false;
+                }
+                frames++;
+                return true;
+        }
+        return false;
+    }
+
+private:
+    enum State { WAIT_SYNC0, WAIT_SYNC1, READ_HEADER, READ_PAYLOAD, READ_CRC };
+    State state = WAIT_SYNC0;
+    uint16_t received = 0;
+    uint8_t header[3];
+    uint8_t crcBytes[2];
+};
+
+#endif
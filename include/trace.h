@@ -0,0 +1,44 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// Hot-path tracing. TRACE_SCOPE("name") records the enclosing block as one
+// complete event (cycle-counter start + duration) in a RAM ring of
+// TRACE_RING_SIZE events; the oldest are overwritten. Names are stored as
+// pointers, so use string literals or traceName().
+
+// Record one event; cycles from cycleCount()
+void traceRecord(const char* name, uint32_t startCycles, uint32_t endCycles);
+
+// Stable pointer for a dynamic name (e.g. an HTTP route), or "other" once TRACE_MAX_NAMES are in use
+const char* traceName(const String& name);
+
+// Recording on/off (on at boot)
+void setTraceEnabled(bool enabled);
+bool isTraceEnabled();
+
+void clearTrace();
+
+// Number of events in the ring
+size_t traceEventCount();
+
+// Chrome trace_event objects for events [from, from + count), oldest first, comma separated
+String traceEventsJson(size_t from, size_t count);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(cycleCount()) {}
+    ~TraceScope() { traceRecord(name, start, cycleCount()); }
+
+private:
+    const char* name;
+    uint32_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif
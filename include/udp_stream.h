@@ -0,0 +1,43 @@
+#ifndef UDP_STREAM_H
+#define UDP_STREAM_H
+
+#include <Arduino.h>
+#include "channels.h"
+
+// Optional UDP sender for collecting runs from several stands on one PC
+// (datagram layout in stream_protocol.h, collector in
+// tools/udp_collector.cpp). While it is on, the samples of each run are
+// batched and sent as sequence-numbered datagrams, a batch every
+// UDP_BATCH_SAMPLES samples or UDP_BATCH_MAX_MS, whichever comes first. There
+// is no retransmission: the run's file on the stand stays complete, and the
+// collector reports what it missed.
+
+struct UdpStreamConfig {
+    bool enabled;
+    String host;      // Collector address (an IP address saves a DNS lookup per datagram)
+    uint16_t port;
+    String stand;     // Names this stand to the collector
+};
+
+struct UdpStreamStats {
+    uint32_t datagrams;
+    uint32_t sendErrors;
+};
+
+// Load the saved settings
+bool initUdpStream();
+
+// Send batches that are due and end stopped runs (call in loop)
+void handleUdpStream();
+
+// Queue a sample of the active run (from the sampler, once it is in the file)
+void udpStreamSample(const ChannelSample& sample, unsigned long timestamp);
+
+const UdpStreamConfig& getUdpStreamConfig();
+
+// Apply and save; false if enabled without a host
+bool setUdpStreamConfig(const UdpStreamConfig& config);
+
+UdpStreamStats getUdpStreamStats();
+
+#endif
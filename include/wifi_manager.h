@@ -10,8 +10,26 @@ void initWiFiManager(uint8_t buttonPin, uint8_t ledPin);
 // Main handler - call this in loop()
 void handleWiFiManager();
 
-// Connect to saved WiFi credentials
-bool connectToSavedWiFi();
+// Station link state, advanced by handleWiFiManager()
+enum WiFiLinkState {
+    WIFI_LINK_NO_CREDENTIALS,   // Nothing saved; hold the button for config mode
+    WIFI_LINK_CONNECTING,
+    WIFI_LINK_UP,
+    WIFI_LINK_RETRY_WAIT,       // Attempt failed or link lost; waiting to retry
+    WIFI_LINK_CONFIG_MODE
+};
+
+// Start connecting with the saved credentials and return at once (false if
+// none are saved). mDNS and NTP are started when the link comes up.
+bool startWiFi();
+
+WiFiLinkState getWiFiLinkState();
+
+// True once NTP has set the clock
+bool isTimeSynced();
+
+// True once per short press of the config button (held less than the config-mode time)
+bool takeButtonPress();
 
 // Check if currently in config mode
 bool isInConfigMode();
@@ -0,0 +1,29 @@
+#ifndef ZERO_TRACKER_H
+#define ZERO_TRACKER_H
+
+#include <Arduino.h>
+
+// Follows thermal drift of the load cell's zero between runs. While the stand
+// is idle (no run, and settled for a while after one) readings are collected
+// in windows; a quiet window whose mean is within a few grams of zero moves
+// the tare part of the way towards it. A load resting on the stand is outside
+// that band and never tared away. Readings are taken only as conversions
+// become ready, so tracking never waits on the load cell.
+
+struct ZeroTrackerStatus {
+    bool tracking;             // Idle and collecting readings
+    uint32_t updates;          // Tare corrections since boot
+    long driftCounts;          // Sum of the corrections
+    float driftGrams;
+    unsigned long lastUpdateMs;
+};
+
+// Collect idle readings and correct the tare (call in loop, after handleSampler())
+void handleZeroTracker();
+
+// Feed a reading some other module took while idle (the armed trigger)
+void zeroTrackerObserve(long netCounts);
+
+ZeroTrackerStatus getZeroTrackerStatus();
+
+#endif
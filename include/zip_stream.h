@@ -0,0 +1,56 @@
+#ifndef ZIP_STREAM_H
+#define ZIP_STREAM_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Streaming ZIP writer for exports. Each entry goes out in one pass as its
+// data is written: the local header has the data-descriptor flag set, and the
+// CRC-32 and sizes follow the data, so nothing is buffered or staged on
+// flash. Entries are stored, not deflated: a deflate window would not fit
+// next to the web server, and run CSVs are small. Memory is the output
+// buffer plus a name and three words per entry for the central directory.
+typedef void (*ZipSink)(void* context, const uint8_t* data, size_t length);
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length);
+
+class ZipStreamWriter {
+public:
+    ZipStreamWriter(ZipSink sink, void* sinkContext);
+
+    // Start an entry (ends the previous one); false if there are too many
+    bool beginEntry(const char* name);
+    void write(const uint8_t* data, size_t length);
+    void write(const char* text) { write((const uint8_t*)text, strlen(text)); }
+    void endEntry();
+
+    // Write the central directory and hand everything to the sink
+    void finish();
+
+    uint32_t bytesWritten() const { return offset; }
+
+private:
+    struct Entry {
+        String name;
+        uint32_t crc;
+        uint32_t size;
+        uint32_t headerOffset;
+    };
+
+    void put(const void* data, size_t length);
+    void putU16(uint16_t value) { put(&value, 2); }
+    void putU32(uint32_t value) { put(&value, 4); }
+    void flush();
+
+    ZipSink sink;
+    void* sinkContext;
+    std::vector<Entry> entries;
+    bool entryOpen;
+    uint32_t offset;       // Bytes of the archive so far
+    uint16_t dosTime;
+    uint16_t dosDate;
+    uint8_t buffer[1024];
+    size_t buffered;
+};
+
+#endif
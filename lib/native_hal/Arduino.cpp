@@ -0,0 +1,74 @@
+// Arduino.cpp - POSIX implementation of the Arduino core subset
+#include "Arduino.h"
+#include "native_hal.h"
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+static uint8_t pinStates[64];
+
+// Scaled time is accumulated at each rate change so the clock never jumps
+static TimePoint rateChangedAt = std::chrono::steady_clock::now();
+static double microsAtRateChange = 0;
+static float clockRate = 1.0;
+
+void nativeSetClockRate(float rate) {
+    if (rate <= 0) return;
+    TimePoint now = std::chrono::steady_clock::now();
+    microsAtRateChange += std::chrono::duration<double, std::micro>(now - rateChangedAt).count() * clockRate;
+    rateChangedAt = now;
+    clockRate = rate;
+}
+
+float nativeClockRate() {
+    return clockRate;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+unsigned long micros() {
+    auto elapsed = std::chrono::steady_clock::now() - rateChangedAt;
+    return (unsigned long)(microsAtRateChange + std::chrono::duration<double, std::micro>(elapsed).count() * clockRate);
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms / clockRate));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(us / clockRate));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    // Pulled-up inputs idle high, like the BOOT button
+    if (pin < sizeof(pinStates)) pinStates[pin] = (mode == INPUT_PULLUP) ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < sizeof(pinStates)) pinStates[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinStates) ? pinStates[pin] : LOW;
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    (void)ms;
+    time_t now = time(nullptr);
+    return localtime_r(&now, info) != nullptr;
+}
+
+uint32_t esp_random() {
+    static std::random_device device;
+    return device();
+}
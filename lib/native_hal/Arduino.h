@@ -0,0 +1,65 @@
+// Arduino.h - POSIX stand-in for the Arduino core subset ThrustPlotter uses
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Clock - monotonic time since program start (see native_hal.h for time scaling)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO - pins are simulated in memory
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// Wall clock (the ESP32 core gets this from SNTP)
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+// Hardware random number generator (ESP-IDF's esp_random)
+uint32_t esp_random();
+
+// Serial goes to stderr so stdout stays free for tool output
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stderr); }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stderr); }
+    void flush() override { fflush(stderr); }
+    operator bool() const { return true; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,208 @@
+// FS.cpp - ESP32 fs::FS / fs::File API over a host directory
+#include "FS.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs {
+
+class FileImpl {
+public:
+    FileImpl(const String& fsPath, const String& hostPath, FILE* fp, bool append = false)
+        : fsPath(fsPath), hostPath(hostPath), fp(fp), length(0), offset(0), append(append), dirIndex(0) {
+        int slash = fsPath.lastIndexOf('/');
+        baseName = fsPath.substring(slash + 1);
+
+        struct stat st;
+        if (fp && fstat(fileno(fp), &st) == 0) length = st.st_size;
+        if (append) offset = length;
+    }
+
+    ~FileImpl() {
+        if (fp) fclose(fp);
+    }
+
+    String fsPath;
+    String hostPath;
+    String baseName;
+    FILE* fp;                        // nullptr for directories
+    size_t length;                   // Size and position are tracked here so that
+    size_t offset;                   // available() costs no system calls per byte
+    bool append;
+    std::vector<String> dirEntries;  // Directory listing, read when opened
+    size_t dirIndex;
+};
+
+// Directory listings are taken once at open time, like LittleFS iterates a snapshot
+static void readDirectory(FileImpl& impl) {
+    DIR* dir = opendir(impl.hostPath.c_str());
+    if (!dir) return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        impl.dirEntries.push_back(entry->d_name);
+    }
+    closedir(dir);
+}
+
+static bool isHostDirectory(const String& hostPath) {
+    struct stat st;
+    return stat(hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    size_t written = fwrite(buf, 1, size, _impl->fp);
+    if (_impl->append) _impl->offset = _impl->length;
+    _impl->offset += written;
+    if (_impl->offset > _impl->length) _impl->length = _impl->offset;
+    return written;
+}
+
+int File::available() {
+    if (!_impl || !_impl->fp) return 0;
+    return (int)(_impl->length - _impl->offset);
+}
+
+int File::read() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    if (c == EOF) return -1;
+    _impl->offset++;
+    return c;
+}
+
+int File::peek() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    if (c == EOF) return -1;
+    ungetc(c, _impl->fp);
+    return c;
+}
+
+void File::flush() {
+    if (_impl && _impl->fp) fflush(_impl->fp);
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    size_t n = fread(buf, 1, size, _impl->fp);
+    _impl->offset += n;
+    return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_impl || !_impl->fp) return false;
+    int whence = (mode == SeekSet) ? SEEK_SET : (mode == SeekCur) ? SEEK_CUR : SEEK_END;
+    if (fseek(_impl->fp, pos, whence) != 0) return false;
+    _impl->offset = ftell(_impl->fp);
+    return true;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->fp) return 0;
+    return _impl->offset;
+}
+
+size_t File::size() const {
+    if (!_impl) return 0;
+    if (_impl->fp) return _impl->length;
+    struct stat st;
+    return stat(_impl->hostPath.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close() {
+    _impl.reset();
+}
+
+File::operator bool() const {
+    return _impl != nullptr;
+}
+
+time_t File::getLastWrite() {
+    struct stat st;
+    return (_impl && stat(_impl->hostPath.c_str(), &st) == 0) ? st.st_mtime : 0;
+}
+
+const char* File::path() const {
+    return _impl ? _impl->fsPath.c_str() : nullptr;
+}
+
+const char* File::name() const {
+    return _impl ? _impl->baseName.c_str() : nullptr;
+}
+
+bool File::isDirectory() const {
+    return _impl && !_impl->fp;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!isDirectory() || _impl->dirIndex >= _impl->dirEntries.size()) {
+        return File();
+    }
+
+    const String& entry = _impl->dirEntries[_impl->dirIndex++];
+    String childFsPath = (_impl->fsPath == "/") ? "/" + entry : _impl->fsPath + "/" + entry;
+    String childHostPath = _impl->hostPath + "/" + entry;
+
+    if (isHostDirectory(childHostPath)) {
+        auto impl = std::make_shared<FileImpl>(childFsPath, childHostPath, nullptr);
+        readDirectory(*impl);
+        return File(impl);
+    }
+
+    FILE* fp = fopen(childHostPath.c_str(), "rb");
+    return fp ? File(std::make_shared<FileImpl>(childFsPath, childHostPath, fp)) : File();
+}
+
+void File::rewindDirectory() {
+    if (isDirectory()) _impl->dirIndex = 0;
+}
+
+File FS::open(const char* path, const char* mode, const bool create) {
+    (void)create;
+    String host = hostPath(path);
+
+    if (isHostDirectory(host)) {
+        auto impl = std::make_shared<FileImpl>(path, host, nullptr);
+        readDirectory(*impl);
+        return File(impl);
+    }
+
+    // Binary modes so byte counts match the device
+    String hostMode = String(mode);
+    if (hostMode.indexOf('b') < 0) hostMode += "b";
+
+    FILE* fp = fopen(host.c_str(), hostMode.c_str());
+    if (!fp) return File();
+    return File(std::make_shared<FileImpl>(path, host, fp, hostMode.indexOf('a') >= 0));
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    String host = hostPath(path);
+    return !isHostDirectory(host) && unlink(host.c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+    return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0 || isHostDirectory(hostPath(path));
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+}  // namespace fs
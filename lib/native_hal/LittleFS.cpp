@@ -0,0 +1,75 @@
+// LittleFS.cpp - LittleFS mapped onto a host directory
+#include "LittleFS.h"
+#include "native_hal.h"
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define NATIVE_FS_BLOCK_SIZE 4096
+#define NATIVE_FS_TOTAL_BYTES 0x160000  // Size of the spiffs partition in default.csv
+
+fs::LittleFSFS LittleFS;
+
+static String fsRoot = "native_fs";
+
+void nativeSetFsRoot(const String& dir) {
+    fsRoot = dir;
+}
+
+String nativeFsRoot() {
+    return fsRoot;
+}
+
+// Sum of file sizes rounded up to whole blocks, which is roughly how LittleFS accounts for space
+static size_t usedBlocks(const String& hostDir) {
+    size_t blocks = 1;
+    DIR* dir = opendir(hostDir.c_str());
+    if (!dir) return 0;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        String child = hostDir + "/" + entry->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            blocks += usedBlocks(child);
+        } else {
+            blocks += (st.st_size + NATIVE_FS_BLOCK_SIZE - 1) / NATIVE_FS_BLOCK_SIZE;
+        }
+    }
+    closedir(dir);
+    return blocks;
+}
+
+namespace fs {
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+
+    struct stat st;
+    if (stat(fsRoot.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return formatOnFail && ::mkdir(fsRoot.c_str(), 0755) == 0;
+}
+
+bool LittleFSFS::format() {
+    return false;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return NATIVE_FS_TOTAL_BYTES;
+}
+
+size_t LittleFSFS::usedBytes() {
+    return usedBlocks(fsRoot) * NATIVE_FS_BLOCK_SIZE;
+}
+
+String LittleFSFS::hostPath(const char* path) const {
+    if (!path || path[0] != '/') return fsRoot + "/" + (path ? path : "");
+    return (strcmp(path, "/") == 0) ? fsRoot : fsRoot + path;
+}
+
+}  // namespace fs
@@ -0,0 +1,26 @@
+// LittleFS.h - LittleFS mapped onto a host directory (see native_hal.h)
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+               uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+
+protected:
+    String hostPath(const char* path) const override;
+};
+
+}  // namespace fs
+
+extern fs::LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,74 @@
+// Preferences.cpp - ESP32 NVS preferences kept in memory for native builds
+#include "Preferences.h"
+#include <map>
+
+// namespace -> key -> value; lives for the life of the process
+static std::map<String, std::map<String, String>> store;
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    _namespace = name;
+    _readOnly = readOnly;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (_readOnly) return false;
+    store[_namespace].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (_readOnly) return false;
+    return store[_namespace].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return store[_namespace].count(key) > 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    if (_readOnly) return 0;
+    store[_namespace][key] = value;
+    return value.length();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (_readOnly) return 0;
+    store[_namespace][key] = String((const char*)value, len);
+    return len;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    auto& ns = store[_namespace];
+    auto it = ns.find(key);
+    return it == ns.end() ? defaultValue : it->second;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    return isKey(key) ? getString(key).toFloat() : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    return isKey(key) ? getString(key).toInt() : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    return isKey(key) ? strtoul(getString(key).c_str(), nullptr, 10) : defaultValue;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    return isKey(key) ? getString(key) == "1" : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    return isKey(key) ? getString(key).length() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!isKey(key)) return 0;
+    String value = getString(key);
+    size_t len = value.length() < maxLen ? value.length() : maxLen;
+    memcpy(buf, value.c_str(), len);
+    return len;
+}
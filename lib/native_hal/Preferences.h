@@ -0,0 +1,39 @@
+// Preferences.h - ESP32 NVS preferences kept in memory for native builds
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end() {}
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    size_t putFloat(const char* key, float value) { return putString(key, String(value, 9)); }
+    size_t putInt(const char* key, int32_t value) { return putString(key, String(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putString(key, String(value)); }
+    size_t putLong(const char* key, int32_t value) { return putInt(key, value); }
+    size_t putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+    size_t putBool(const char* key, bool value) { return putString(key, value ? "1" : "0"); }
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    String getString(const char* key, const String& defaultValue = String());
+    float getFloat(const char* key, float defaultValue = NAN);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    int32_t getLong(const char* key, int32_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0) { return getUInt(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    String _namespace;
+    bool _readOnly = false;
+};
+
+#endif
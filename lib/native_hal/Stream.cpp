@@ -0,0 +1,45 @@
+// Stream.cpp - Arduino Stream for native builds
+#include "Stream.h"
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+// The terminator is consumed but not stored
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0 || c == terminator) break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    int c = read();
+    while (c >= 0 && c != terminator) {
+        ret += (char)c;
+        c = read();
+    }
+    return ret;
+}
+
+String Stream::readString() {
+    String ret;
+    int c = read();
+    while (c >= 0) {
+        ret += (char)c;
+        c = read();
+    }
+    return ret;
+}
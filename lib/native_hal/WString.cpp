@@ -0,0 +1,160 @@
+// WString.cpp - Arduino String for native builds
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+template <typename T>
+static std::string formatInteger(T value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+
+    bool negative = value < 0;
+    unsigned long long magnitude = negative ? (unsigned long long)(-(long long)value) : (unsigned long long)value;
+
+    std::string digits;
+    do {
+        int digit = magnitude % base;
+        digits.insert(digits.begin(), (char)(digit < 10 ? '0' + digit : 'a' + digit - 10));
+        magnitude /= base;
+    } while (magnitude);
+
+    // Like Arduino, only base 10 shows a sign
+    if (negative && base == 10) digits.insert(digits.begin(), '-');
+    return digits;
+}
+
+static std::string formatFloat(double value, unsigned int decimalPlaces) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    return buf;
+}
+
+String::String(unsigned char value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(int value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(unsigned int value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(long value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(unsigned long value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(long long value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : buffer(formatInteger(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : buffer(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : buffer(formatFloat(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (length() != s.length()) return false;
+    for (unsigned int i = 0; i < length(); i++) {
+        if (tolower((unsigned char)buffer[i]) != tolower((unsigned char)s.buffer[i])) return false;
+    }
+    return true;
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+    if (offset + prefix.length() > length()) return false;
+    return buffer.compare(offset, prefix.length(), prefix.buffer) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    if (suffix.length() > length()) return false;
+    return buffer.compare(length() - suffix.length(), suffix.length(), suffix.buffer) == 0;
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+    if (!bufsize || !buf) return;
+    if (index >= length()) {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = length() - index;
+    if (n > bufsize - 1) n = bufsize - 1;
+    memcpy(buf, buffer.data() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = buffer.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = buffer.find(str.buffer, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t pos = buffer.rfind(ch);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = buffer.rfind(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = buffer.rfind(str.buffer);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = buffer.rfind(str.buffer, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int tmp = beginIndex;
+        beginIndex = endIndex;
+        endIndex = tmp;
+    }
+    if (beginIndex >= length()) return String();
+    if (endIndex > length()) endIndex = length();
+    return String(buffer.data() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace) {
+    for (char& c : buffer) {
+        if (c == find) c = replace;
+    }
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find.length() == 0) return;
+    size_t pos = 0;
+    while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+        buffer.replace(pos, find.length(), replace.buffer);
+        pos += replace.length();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= length()) return;
+    buffer.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (char& c : buffer) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : buffer) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = 0;
+    while (begin < buffer.length() && isspace((unsigned char)buffer[begin])) begin++;
+    size_t end = buffer.length();
+    while (end > begin && isspace((unsigned char)buffer[end - 1])) end--;
+    buffer = buffer.substr(begin, end - begin);
+}
+
+long String::toInt() const {
+    return atol(buffer.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(buffer.c_str());
+}
+
+double String::toDouble() const {
+    return atof(buffer.c_str());
+}
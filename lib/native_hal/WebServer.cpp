@@ -0,0 +1,267 @@
+// WebServer.cpp - ESP32 WebServer API with an in-process loopback transport
+#include "WebServer.h"
+#include "native_hal.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static uint16_t httpPort = 0;
+
+void nativeSetHttpPort(uint16_t port) {
+    httpPort = port;
+}
+
+static String urlDecode(const String& text) {
+    String decoded;
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '+') {
+            decoded += ' ';
+        } else if (c == '%' && i + 2 < text.length() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            decoded += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += c;
+        }
+    }
+    return decoded;
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    _routes.push_back({uri, method, fn, ufn});
+}
+
+String WebServer::arg(const String& name) const {
+    for (const auto& a : _args) {
+        if (a.first == name) return a.second;
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const auto& a : _args) {
+        if (a.first == name) return true;
+    }
+    return false;
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    _collectedHeaders.assign(headerKeys, headerKeys + headerKeysCount);
+}
+
+String WebServer::header(const String& name) const {
+    for (const auto& h : _headers) {
+        if (strcasecmp(h.first.c_str(), name.c_str()) == 0) return h.second;
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const auto& h : _headers) {
+        if (strcasecmp(h.first.c_str(), name.c_str()) == 0) return true;
+    }
+    return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    if (first) {
+        _pendingHeaders.insert(_pendingHeaders.begin(), {name, value});
+    } else {
+        _pendingHeaders.push_back({name, value});
+    }
+}
+
+void WebServer::send(int code, const String& contentType, const String& content) {
+    _response.code = code;
+    _response.contentType = contentType;
+    _response.headers = _pendingHeaders;
+    _pendingHeaders.clear();
+    _response.body += content;
+}
+
+void WebServer::sendContent(const char* content, size_t size) {
+    _response.body += String(content, size);
+}
+
+NativeResponse WebServer::handleRequest(HTTPMethod method, const String& uri, const String& body,
+                                        const std::vector<std::pair<String, String>>& headers) {
+    _currentMethod = method;
+    _args.clear();
+    _headers.clear();
+    for (const auto& h : headers) {
+        for (const String& key : _collectedHeaders) {
+            if (strcasecmp(h.first.c_str(), key.c_str()) == 0) _headers.push_back(h);
+        }
+    }
+    _pendingHeaders.clear();
+    _contentLength = CONTENT_LENGTH_UNKNOWN;
+    _response = NativeResponse();
+    _response.code = 0;
+
+    int query = uri.indexOf('?');
+    _currentUri = (query >= 0) ? uri.substring(0, query) : uri;
+
+    if (query >= 0) {
+        String params = uri.substring(query + 1);
+        while (params.length() > 0) {
+            int amp = params.indexOf('&');
+            String pair = (amp >= 0) ? params.substring(0, amp) : params;
+            params = (amp >= 0) ? params.substring(amp + 1) : String();
+
+            int eq = pair.indexOf('=');
+            String name = (eq >= 0) ? pair.substring(0, eq) : pair;
+            String value = (eq >= 0) ? pair.substring(eq + 1) : String();
+            _args.push_back({urlDecode(name), urlDecode(value)});
+        }
+    }
+    if (body.length() > 0) {
+        _args.push_back({"plain", body});
+    }
+
+    for (const Route& route : _routes) {
+        if (route.uri == _currentUri && (route.method == HTTP_ANY || route.method == method)) {
+            route.handler();
+            return _response;
+        }
+    }
+
+    if (_notFoundHandler) {
+        _notFoundHandler();
+    } else {
+        send(404, "text/plain", "Not found");
+    }
+    return _response;
+}
+
+void WebServer::begin() {
+    if (httpPort == 0 || _listenFd >= 0) return;
+
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(httpPort);
+    if (bind(_listenFd, (sockaddr*)&local, sizeof(local)) != 0 || listen(_listenFd, 4) != 0) {
+        fprintf(stderr, "WebServer: cannot listen on port %u\n", httpPort);
+        ::close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    fcntl(_listenFd, F_SETFL, O_NONBLOCK);
+}
+
+void WebServer::stop() {
+    if (_listenFd >= 0) {
+        ::close(_listenFd);
+        _listenFd = -1;
+    }
+}
+
+static const char* reasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 206: return "Partial Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 416: return "Range Not Satisfiable";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+static HTTPMethod parseMethod(const String& name) {
+    if (name == "GET") return HTTP_GET;
+    if (name == "HEAD") return HTTP_HEAD;
+    if (name == "POST") return HTTP_POST;
+    if (name == "PUT") return HTTP_PUT;
+    if (name == "PATCH") return HTTP_PATCH;
+    if (name == "DELETE") return HTTP_DELETE;
+    if (name == "OPTIONS") return HTTP_OPTIONS;
+    return HTTP_ANY;
+}
+
+// Reads until the connection has delivered the headers and Content-Length bytes of body
+static bool readRequest(int fd, std::string& head, std::string& body) {
+    std::string data;
+    char buf[4096];
+    size_t headerEnd = std::string::npos;
+    size_t contentLength = 0;
+    while (true) {
+        pollfd waiting = {fd, POLLIN, 0};
+        if (poll(&waiting, 1, 2000) <= 0) return false;
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) return false;
+        data.append(buf, n);
+
+        if (headerEnd == std::string::npos) {
+            headerEnd = data.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) continue;
+            head = data.substr(0, headerEnd);
+            std::string lower = head;
+            for (char& c : lower) c = tolower((unsigned char)c);
+            size_t at = lower.find("\r\ncontent-length:");
+            if (at != std::string::npos) contentLength = strtoul(head.c_str() + at + 17, nullptr, 10);
+        }
+        if (data.size() >= headerEnd + 4 + contentLength) {
+            body = data.substr(headerEnd + 4, contentLength);
+            return true;
+        }
+    }
+}
+
+void WebServer::handleClient() {
+    if (_listenFd < 0) return;
+    int fd = accept(_listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+
+    std::string head, body;
+    if (readRequest(fd, head, body)) {
+        // Request line, then "Name: value" lines
+        std::vector<std::pair<String, String>> headers;
+        size_t lineEnd = head.find("\r\n");
+        std::string requestLine = head.substr(0, lineEnd);
+        while (lineEnd != std::string::npos) {
+            size_t next = head.find("\r\n", lineEnd + 2);
+            std::string line = head.substr(lineEnd + 2, next == std::string::npos ? std::string::npos : next - lineEnd - 2);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                size_t value = line.find_first_not_of(' ', colon + 1);
+                headers.push_back({String(line.substr(0, colon).c_str()),
+                                   String(value == std::string::npos ? "" : line.substr(value).c_str())});
+            }
+            lineEnd = next;
+        }
+        size_t space1 = requestLine.find(' ');
+        size_t space2 = requestLine.find(' ', space1 + 1);
+        String method = requestLine.substr(0, space1).c_str();
+        String uri = requestLine.substr(space1 + 1, space2 - space1 - 1).c_str();
+
+        NativeResponse response = handleRequest(parseMethod(method), uri, String(body.c_str(), body.size()), headers);
+        bool headOnly = method == "HEAD";
+
+        std::string out = "HTTP/1.1 " + std::to_string(response.code) + " " + reasonPhrase(response.code) + "\r\n";
+        if (response.contentType.length() > 0) out += std::string("Content-Type: ") + response.contentType.c_str() + "\r\n";
+        for (const auto& h : response.headers) {
+            out += std::string(h.first.c_str()) + ": " + h.second.c_str() + "\r\n";
+        }
+        out += "Content-Length: " + std::to_string(response.body.length()) + "\r\nConnection: close\r\n\r\n";
+        if (!headOnly) out.append(response.body.c_str(), response.body.length());
+
+        for (size_t sent = 0; sent < out.size();) {
+            ssize_t n = write(fd, out.data() + sent, out.size() - sent);
+            if (n <= 0) break;
+            sent += n;
+        }
+    }
+    ::close(fd);
+}
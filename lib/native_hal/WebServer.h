@@ -0,0 +1,129 @@
+// WebServer.h - ESP32 WebServer API with an in-process loopback transport,
+// optionally served over TCP as well (nativeSetHttpPort in native_hal.h)
+#ifndef NATIVE_WEBSERVER_H
+#define NATIVE_WEBSERVER_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include "FS.h"
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+enum HTTPUploadStatus {
+    UPLOAD_FILE_START,
+    UPLOAD_FILE_WRITE,
+    UPLOAD_FILE_END,
+    UPLOAD_FILE_ABORTED
+};
+
+#define HTTP_UPLOAD_BUFLEN 1436
+#define CONTENT_LENGTH_UNKNOWN ((size_t) - 1)
+
+struct HTTPUpload {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+// Response captured by the loopback transport
+struct NativeResponse {
+    int code;
+    String contentType;
+    std::vector<std::pair<String, String>> headers;
+    String body;
+};
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : _port(port) {}
+
+    ~WebServer() { stop(); }
+
+    void begin();
+    void close() { stop(); }
+    void stop();
+    // Serves at most one TCP request per call; does nothing without an HTTP port
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, nullptr); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void onNotFound(THandlerFunction fn) { _notFoundHandler = fn; }
+
+    String uri() const { return _currentUri; }
+    HTTPMethod method() const { return _currentMethod; }
+    HTTPUpload& upload() { return _upload; }
+
+    String arg(const String& name) const;
+    bool hasArg(const String& name) const;
+    int args() const { return _args.size(); }
+
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t contentLength) { _contentLength = contentLength; }
+    void send(int code, const String& contentType = String(), const String& content = String());
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t size);
+
+    template <typename T>
+    size_t streamFile(T& file, const String& contentType, const int code = 200) {
+        send(code, contentType, String());
+        uint8_t buf[1024];
+        size_t total = 0;
+        size_t n;
+        while ((n = file.read(buf, sizeof(buf))) > 0) {
+            sendContent((const char*)buf, n);
+            total += n;
+        }
+        return total;
+    }
+
+    // Loopback transport: dispatch one request through the registered handlers.
+    // The query string in uri is split into args; body becomes arg("plain").
+    // Of headers, only the collected ones are kept, as on the ESP32.
+    NativeResponse handleRequest(HTTPMethod method, const String& uri, const String& body = String(),
+                                 const std::vector<std::pair<String, String>>& headers = {});
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+        THandlerFunction uploadHandler;
+    };
+
+    int _port;
+    std::vector<Route> _routes;
+    THandlerFunction _notFoundHandler;
+    String _currentUri;
+    HTTPMethod _currentMethod = HTTP_GET;
+    std::vector<std::pair<String, String>> _args;
+    std::vector<String> _collectedHeaders;
+    std::vector<std::pair<String, String>> _headers;
+    int _listenFd = -1;
+    HTTPUpload _upload;
+    size_t _contentLength = CONTENT_LENGTH_UNKNOWN;
+    std::vector<std::pair<String, String>> _pendingHeaders;
+    NativeResponse _response;
+};
+
+#endif
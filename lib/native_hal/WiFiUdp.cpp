@@ -0,0 +1,70 @@
+// WiFiUdp.cpp - ESP32 WiFiUDP sending side over a POSIX UDP socket for native builds
+#include "WiFiUdp.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool WiFiUDP::openSocket() {
+    if (_fd < 0) {
+        _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    }
+    return _fd >= 0;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    if (!openSocket()) return 0;
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(_fd, (sockaddr*)&local, sizeof(local)) != 0) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _packet.clear();
+    _haveDestination = false;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port) {
+    _packet.clear();
+    _haveDestination = false;
+    if (!openSocket()) return 0;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return 0;
+
+    _destination = *(sockaddr_in*)found->ai_addr;
+    _destination.sin_port = htons(port);
+    freeaddrinfo(found);
+    _haveDestination = true;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size) {
+    if (!_haveDestination) return 0;
+    _packet.insert(_packet.end(), buffer, buffer + size);
+    return size;
+}
+
+int WiFiUDP::endPacket() {
+    if (!_haveDestination) return 0;
+    ssize_t sent = sendto(_fd, _packet.data(), _packet.size(), 0, (const sockaddr*)&_destination, sizeof(_destination));
+    bool ok = sent == (ssize_t)_packet.size();
+    _packet.clear();
+    _haveDestination = false;
+    return ok ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+// WiFiUdp.h - ESP32 WiFiUDP sending side over a POSIX UDP socket for native builds
+#ifndef NATIVE_WIFIUDP_H
+#define NATIVE_WIFIUDP_H
+
+#include "Arduino.h"
+#include <netinet/in.h>
+#include <vector>
+
+class WiFiUDP {
+public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port);
+    void stop();
+
+    // Host names are resolved on every packet, as on the ESP32
+    int beginPacket(const char* host, uint16_t port);
+    size_t write(uint8_t byte) { return write(&byte, 1); }
+    size_t write(const uint8_t* buffer, size_t size);
+    int endPacket();
+
+private:
+    bool openSocket();
+
+    int _fd = -1;
+    bool _haveDestination = false;
+    sockaddr_in _destination;
+    std::vector<uint8_t> _packet;
+};
+
+#endif
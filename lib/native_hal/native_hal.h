@@ -0,0 +1,20 @@
+// native_hal.h - controls that only exist in the native (host) build
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include "WString.h"
+
+// Directory that LittleFS is mapped onto (default ./native_fs)
+void nativeSetFsRoot(const String& dir);
+String nativeFsRoot();
+
+// Clock rate: millis()/micros() advance rate times faster than real time and
+// delay() sleeps 1/rate as long, so the firmware loop runs accelerated (default 1)
+void nativeSetClockRate(float rate);
+float nativeClockRate();
+
+// Also serve WebServer over TCP on this port, so HTTP clients on the host can
+// use the native build as a device (set before begin(); 0 = loopback only)
+void nativeSetHttpPort(uint16_t port);
+
+#endif
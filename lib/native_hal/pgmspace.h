@@ -0,0 +1,9 @@
+// pgmspace.h - flash-resident data is ordinary memory on the host
+#ifndef NATIVE_PGMSPACE_H
+#define NATIVE_PGMSPACE_H
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const unsigned char*)(addr))
+
+#endif
@@ -0,0 +1,70 @@
+// src/admission.cpp
+#include "admission.h"
+#include "run_manager.h"
+#include <ArduinoJson.h>
+
+struct ClassStats {
+    uint32_t served;
+    uint32_t rejected;
+    uint32_t inFlight;
+    uint32_t peakInFlight;
+    uint64_t totalMicros;
+    uint32_t maxMicros;
+};
+
+static ClassStats stats[REQUEST_CLASS_COUNT] = {};
+
+static const char* className(RequestClass requestClass) {
+    switch (requestClass) {
+        case REQUEST_CRITICAL: return "critical";
+        case REQUEST_STANDARD: return "standard";
+        case REQUEST_HEAVY: return "heavy";
+        default: return "unknown";
+    }
+}
+
+bool admitRequest(RequestClass requestClass) {
+    if (requestClass == REQUEST_HEAVY && isRunActive()) {
+        stats[requestClass].rejected++;
+        return false;
+    }
+    return true;
+}
+
+void requestStarted(RequestClass requestClass) {
+    ClassStats& s = stats[requestClass];
+    s.inFlight++;
+    if (s.inFlight > s.peakInFlight) {
+        s.peakInFlight = s.inFlight;
+    }
+}
+
+void requestFinished(RequestClass requestClass, unsigned long elapsedMicros) {
+    ClassStats& s = stats[requestClass];
+    s.inFlight--;
+    s.served++;
+    s.totalMicros += elapsedMicros;
+    if (elapsedMicros > s.maxMicros) {
+        s.maxMicros = elapsedMicros;
+    }
+}
+
+String getAdmissionStats() {
+    JsonDocument doc;
+    doc["runActive"] = isRunActive();
+
+    for (int i = 0; i < REQUEST_CLASS_COUNT; i++) {
+        const ClassStats& s = stats[i];
+        JsonObject obj = doc[className((RequestClass)i)].to<JsonObject>();
+        obj["served"] = s.served;
+        obj["rejected"] = s.rejected;
+        obj["inFlight"] = s.inFlight;
+        obj["peakInFlight"] = s.peakInFlight;
+        obj["avgLatencyUs"] = s.served ? (uint32_t)(s.totalMicros / s.served) : 0;
+        obj["maxLatencyUs"] = s.maxMicros;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,294 @@
+// src/calibration.cpp
+#include "calibration.h"
+#include "config.h"
+#include <Preferences.h>
+#include <algorithm>
+
+#define CALIBRATION_SETTLE_MS 5000       // Time to place each weight
+#define CALIBRATION_READINGS 40          // Conversions averaged per point
+#define CALIBRATION_READ_TIMEOUT_MS 2000 // Without a conversion the load cell is considered gone
+
+enum CalibrationPhase {
+    CAL_IDLE,
+    CAL_SETTLING,
+    CAL_MEASURING,
+    CAL_DONE,
+    CAL_FAILED
+};
+
+static CalibrationPhase phase = CAL_IDLE;
+static std::vector<CalibrationPoint> points;
+static int fitDegree = 1;
+static size_t currentPoint = 0;
+static unsigned long phaseStart = 0;
+static unsigned long lastReading = 0;
+static int readings = 0;
+static double sum = 0;
+static double sumSquares = 0;
+static String message = "";
+static CalibrationFit fit = {false, 1, {0, 0, 0}, 0, 0, 0};
+
+// Normal equations over counts scaled to [-1, 1], so they stay well conditioned
+// even for the quadratic term of counts in the hundreds of thousands
+static bool solveLeastSquares(const std::vector<CalibrationPoint>& pts, int degree, double coeffs[3]) {
+    double scale = 0;
+    for (const CalibrationPoint& p : pts) {
+        scale = std::max(scale, fabs((double)p.counts));
+    }
+    if (scale == 0) return false;
+
+    int n = degree + 1;
+    double a[3][4] = {{0}};
+    for (const CalibrationPoint& p : pts) {
+        double u = p.counts / scale;
+        double powers[5] = {1, u, u * u, u * u * u, u * u * u * u};
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                a[i][j] += powers[i + j];
+            }
+            a[i][n] += powers[i] * p.grams;
+        }
+    }
+
+    // Gauss-Jordan with partial pivoting
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+        }
+        if (fabs(a[pivot][col]) < 1e-12) return false;
+        for (int k = 0; k <= n; k++) std::swap(a[col][k], a[pivot][k]);
+
+        for (int r = 0; r < n; r++) {
+            if (r == col) continue;
+            double f = a[r][col] / a[col][col];
+            for (int k = col; k <= n; k++) a[r][k] -= f * a[col][k];
+        }
+    }
+
+    double unscale = 1;
+    for (int i = 0; i < 3; i++) {
+        coeffs[i] = i < n ? a[i][n] / a[i][i] / unscale : 0;
+        unscale *= scale;
+    }
+    return true;
+}
+
+static double evaluate(const double c[3], double x) {
+    return c[0] + x * (c[1] + x * c[2]);
+}
+
+CalibrationFit fitCalibration(std::vector<CalibrationPoint>& pts, int degree) {
+    CalibrationFit result = {false, degree, {0, 0, 0}, 0, 0, 0};
+    double c[3];
+    if (degree < 1 || degree > 2 || (int)pts.size() < degree + 1 || !solveLeastSquares(pts, degree, c) || c[1] == 0) {
+        return result;
+    }
+
+    double squares = 0;
+    for (CalibrationPoint& p : pts) {
+        p.residual = evaluate(c, p.counts) - p.grams;
+        squares += p.residual * p.residual;
+        result.maxError = std::max(result.maxError, fabsf(p.residual));
+    }
+    result.rmsError = sqrt(squares / pts.size());
+
+    // Nonlinearity as load cell data sheets give it: worst deviation from a straight line, % of full scale
+    double line[3];
+    float fullScale = 0;
+    for (const CalibrationPoint& p : pts) fullScale = std::max(fullScale, p.grams);
+    if (fullScale > 0 && solveLeastSquares(pts, 1, line)) {
+        double worst = 0;
+        for (const CalibrationPoint& p : pts) {
+            worst = std::max(worst, fabs(evaluate(line, p.counts) - p.grams));
+        }
+        result.linearityErrorPct = 100.0 * worst / fullScale;
+    }
+
+    result.curve = LoadCellCurve{(float)c[0], (float)c[1], (float)c[2]};
+    result.ok = true;
+    return result;
+}
+
+static void saveCalibration(const LoadCellCurve& curve) {
+    Preferences prefs;
+    prefs.begin("wifi-config", false);
+    prefs.putFloat("cal_c0", curve.c0);
+    prefs.putFloat("cal_c1", curve.c1);
+    prefs.putFloat("cal_c2", curve.c2);
+    // Counts per gram, still shown by the config page
+    prefs.putFloat("cal_factor", 1.0f / curve.c1);
+    prefs.end();
+}
+
+bool loadCalibration() {
+    Preferences prefs;
+    prefs.begin("wifi-config", true);  // Read-only
+    bool hasCurve = prefs.isKey("cal_c1");
+    LoadCellCurve curve = {prefs.getFloat("cal_c0", 0.0), prefs.getFloat("cal_c1", 0.0), prefs.getFloat("cal_c2", 0.0)};
+    float calibrationFactor = prefs.getFloat("cal_factor", LOAD_CELL_CALIBRATION_FACTOR);
+    prefs.end();
+
+    if (hasCurve && curve.c1 != 0.0) {
+        setLoadCellCurve(curve);
+        return true;
+    }
+    if (calibrationFactor != 0.0) {
+        setLoadCellCalibration(calibrationFactor);
+        return true;
+    }
+    return false;
+}
+
+bool startCalibration(const std::vector<float>& weights, int degree) {
+    std::vector<float> sorted = weights;
+    sorted.push_back(0.0);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // A quadratic fit through 0 g and two weights always fits exactly, leaving nothing to check it by
+    size_t minWeights = degree == 2 ? 3 : 1;
+    if (sorted.front() < 0 || sorted.size() > CALIBRATION_MAX_POINTS || sorted.size() < minWeights + 1 ||
+        degree < 1 || degree > 2) {
+        return false;
+    }
+
+    points.clear();
+    for (float grams : sorted) {
+        points.push_back(CalibrationPoint{grams, 0, 0, 0});
+    }
+    fitDegree = degree;
+    fit = CalibrationFit{false, degree, {0, 0, 0}, 0, 0, 0};
+    currentPoint = 0;
+    phase = CAL_SETTLING;
+    phaseStart = millis();
+
+    Serial.printf("Starting %s calibration with %u points\n", degree == 2 ? "quadratic" : "linear", (unsigned)points.size());
+    return true;
+}
+
+bool isCalibrationRunning() {
+    return phase == CAL_SETTLING || phase == CAL_MEASURING;
+}
+
+static void finishCalibration() {
+    fit = fitCalibration(points, fitDegree);
+    if (!fit.ok) {
+        phase = CAL_FAILED;
+        message = "Fit failed: the readings did not change with the weights";
+        Serial.println(message);
+        return;
+    }
+
+    setLoadCellCurve(fit.curve);
+    saveCalibration(fit.curve);
+    phase = CAL_DONE;
+    message = "Calibration complete!";
+    Serial.printf("Calibration saved: rms %.2f g, max %.2f g, linearity %.3f%%\n", fit.rmsError, fit.maxError,
+                  fit.linearityErrorPct);
+}
+
+void handleCalibration() {
+    if (!isCalibrationRunning()) return;
+
+    unsigned long elapsed = millis() - phaseStart;
+    CalibrationPoint& point = points[currentPoint];
+    char text[96];
+
+    switch (phase) {
+        case CAL_SETTLING:
+            if (elapsed < CALIBRATION_SETTLE_MS) {
+                unsigned long secondsLeft = (CALIBRATION_SETTLE_MS - elapsed + 999) / 1000;
+                if (point.grams == 0) {
+                    snprintf(text, sizeof(text), "Step %u/%u: Remove all weight... (%lus)", (unsigned)currentPoint + 1,
+                             (unsigned)points.size(), secondsLeft);
+                } else {
+                    snprintf(text, sizeof(text), "Step %u/%u: Place %.1fg weight... (%lus)", (unsigned)currentPoint + 1,
+                             (unsigned)points.size(), point.grams, secondsLeft);
+                }
+                message = text;
+                break;
+            }
+            phase = CAL_MEASURING;
+            phaseStart = millis();
+            lastReading = millis();
+            readings = 0;
+            sum = 0;
+            sumSquares = 0;
+            break;
+
+        case CAL_MEASURING: {
+            long counts;
+            if (readNetCounts(counts)) {
+                sum += counts;
+                sumSquares += (double)counts * counts;
+                readings++;
+                lastReading = millis();
+            } else if (millis() - lastReading > CALIBRATION_READ_TIMEOUT_MS) {
+                phase = CAL_FAILED;
+                message = "Load cell not ready";
+                Serial.println("Calibration failed: load cell not ready");
+                break;
+            }
+
+            snprintf(text, sizeof(text), "Step %u/%u: Measuring %.1fg (%d/%d)...", (unsigned)currentPoint + 1,
+                     (unsigned)points.size(), point.grams, readings, CALIBRATION_READINGS);
+            message = text;
+            if (readings < CALIBRATION_READINGS) break;
+
+            double mean = sum / readings;
+            point.counts = mean;
+            point.noise = sqrt(std::max(0.0, sumSquares / readings - mean * mean));
+            Serial.printf("Calibration point %.1f g: %.1f counts (noise %.1f)\n", point.grams, point.counts, point.noise);
+
+            // The unloaded point (always first) becomes the tare, so the fitted
+            // offset stays valid after the next tare at boot
+            if (currentPoint == 0) {
+                long zero = lround(mean);
+                adjustTare(zero);
+                point.counts -= zero;
+            }
+
+            if (++currentPoint < points.size()) {
+                phase = CAL_SETTLING;
+                phaseStart = millis();
+            } else {
+                finishCalibration();
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void writeCalibrationStatus(JsonWriter& json) {
+    bool finished = phase == CAL_DONE;
+    json.beginObject()
+        .field("step", isCalibrationRunning() ? (int)currentPoint + 1 : 0)
+        .field("steps", (int)points.size())
+        .field("message", message)
+        .field("complete", !isCalibrationRunning())
+        .field("success", finished);
+
+    if (finished) {
+        json.field("calibrationFactor", 1.0 / fit.curve.c1, 2)
+            .field("degree", fit.degree)
+            .field("rmsError", fit.rmsError, 3)
+            .field("maxError", fit.maxError, 3)
+            .field("linearityErrorPct", fit.linearityErrorPct, 4);
+        json.key("coefficients").beginArray().value(fit.curve.c0).value(fit.curve.c1).value(fit.curve.c2).endArray();
+        json.key("points").beginArray();
+        for (const CalibrationPoint& p : points) {
+            json.beginObject()
+                .field("grams", p.grams, 1)
+                .field("counts", p.counts, 1)
+                .field("noise", p.noise, 1)
+                .field("residual", p.residual, 3)
+                .endObject();
+        }
+        json.endArray();
+    }
+    json.endObject();
+}
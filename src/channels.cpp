@@ -0,0 +1,163 @@
+// src/channels.cpp
+#include "channels.h"
+#include "config.h"
+#include "load_cell.h"
+#include <Preferences.h>
+
+#define TORQUE_TARE_READINGS 10
+
+static ChannelConfig config = {false, TORQUE_CALIBRATION_FACTOR, false, 1};
+static LoadCellDriver* torqueDriver = &hardwareLoadCellDriver(1);
+static PulseCounter* pulseCounter = &hardwarePulseCounter();
+static bool torqueFound = false;    // Answered and tared
+static long torqueTare = 0;
+static float lastTorque = 0.0;
+
+// Pulses and elapsed time of the last RPM_WINDOW_SAMPLES ticks
+static uint32_t windowPulses[RPM_WINDOW_SAMPLES];
+static unsigned long windowMicros[RPM_WINDOW_SAMPLES];
+static size_t windowPos = 0;
+static size_t windowFill = 0;
+static uint32_t pulseSum = 0;
+static unsigned long microsSum = 0;
+static unsigned long lastTick = 0;
+
+static void startTorque() {
+    torqueFound = false;
+    lastTorque = 0.0;
+    if (!config.torqueEnabled) {
+        return;
+    }
+    torqueDriver->begin(TORQUE_DOUT_PIN, TORQUE_SCK_PIN);
+    if (!torqueDriver->isReady()) {
+        // Logged as 0 until it is started again
+        Serial.println(String(torqueDriver->name()) + " torque amplifier not found. Check wiring.");
+        return;
+    }
+
+    // Like the thrust load cell, zeroed once at startup
+    long long sum = 0;
+    for (int i = 0; i < TORQUE_TARE_READINGS; i++) {
+        sum += torqueDriver->readRaw();
+    }
+    torqueTare = sum / TORQUE_TARE_READINGS;
+    torqueFound = true;
+}
+
+static void restartRpmWindow() {
+    windowPos = 0;
+    windowFill = 0;
+    pulseSum = 0;
+    microsSum = 0;
+    lastTick = micros();
+    pulseCounter->takeCount();  // Discard what was counted before
+}
+
+static void startRpm() {
+    if (config.rpmEnabled) {
+        pulseCounter->begin(RPM_PIN);
+        restartRpmWindow();
+    }
+}
+
+bool initChannels() {
+    Preferences prefs;
+    prefs.begin("channels", true);  // Read-only
+    config.torqueEnabled = prefs.getBool("torque", false);
+    config.torqueFactor = prefs.getFloat("torque_f", TORQUE_CALIBRATION_FACTOR);
+    config.rpmEnabled = prefs.getBool("rpm", false);
+    config.pulsesPerRev = prefs.getUInt("ppr", 1);
+    prefs.end();
+
+    startTorque();
+    startRpm();
+    return true;
+}
+
+const ChannelConfig& getChannelConfig() {
+    return config;
+}
+
+bool setChannelConfig(const ChannelConfig& newConfig) {
+    if (newConfig.torqueFactor == 0 || newConfig.pulsesPerRev == 0) {
+        return false;
+    }
+    bool torqueStarted = newConfig.torqueEnabled && !config.torqueEnabled;
+    bool rpmStarted = newConfig.rpmEnabled && !config.rpmEnabled;
+    config = newConfig;
+
+    Preferences prefs;
+    prefs.begin("channels", false);
+    prefs.putBool("torque", config.torqueEnabled);
+    prefs.putFloat("torque_f", config.torqueFactor);
+    prefs.putBool("rpm", config.rpmEnabled);
+    prefs.putUInt("ppr", config.pulsesPerRev);
+    prefs.end();
+
+    if (torqueStarted) startTorque();
+    if (rpmStarted) startRpm();
+    return true;
+}
+
+uint8_t enabledChannels() {
+    uint8_t channels = CHANNEL_BIT(CHANNEL_THRUST);
+    if (config.torqueEnabled) channels |= CHANNEL_BIT(CHANNEL_TORQUE);
+    if (config.rpmEnabled) channels |= CHANNEL_BIT(CHANNEL_RPM);
+    return channels;
+}
+
+const char* channelColumn(Channel channel) {
+    switch (channel) {
+        case CHANNEL_TORQUE: return "torque_nmm";
+        case CHANNEL_RPM: return "rpm";
+        default: return "thrust_grams";
+    }
+}
+
+static float readRpm() {
+    unsigned long now = micros();
+    unsigned long elapsed = now - lastTick;
+
+    // Ticks stop between runs; a window spanning that gap says nothing about this run
+    if (elapsed > (unsigned long)RPM_WINDOW_SAMPLES * SAMPLE_RATE_MS * 1000UL) {
+        restartRpmWindow();
+        return 0.0;
+    }
+    lastTick = now;
+
+    if (windowFill == RPM_WINDOW_SAMPLES) {
+        pulseSum -= windowPulses[windowPos];
+        microsSum -= windowMicros[windowPos];
+    } else {
+        windowFill++;
+    }
+    windowPulses[windowPos] = pulseCounter->takeCount();
+    windowMicros[windowPos] = elapsed;
+    pulseSum += windowPulses[windowPos];
+    microsSum += elapsed;
+    windowPos = (windowPos + 1) % RPM_WINDOW_SAMPLES;
+
+    if (microsSum == 0) {
+        return 0.0;
+    }
+    return pulseSum * 60000000.0f / ((float)config.pulsesPerRev * microsSum);
+}
+
+void readChannels(ChannelSample& sample) {
+    sample.value[CHANNEL_THRUST] = readThrust();
+
+    // Sample-and-hold: the torque conversion may land just after the thrust one
+    if (config.torqueEnabled && torqueFound && torqueDriver->isReady()) {
+        lastTorque = (torqueDriver->readRaw() - torqueTare) / config.torqueFactor;
+    }
+    sample.value[CHANNEL_TORQUE] = config.torqueEnabled ? lastTorque : 0.0f;
+    sample.value[CHANNEL_RPM] = config.rpmEnabled ? readRpm() : 0.0f;
+}
+
+bool setChannelSources(LoadCellDriver& torque, PulseCounter& pulses) {
+    torqueDriver = &torque;
+    pulseCounter = &pulses;
+    startTorque();
+    startRpm();
+    return true;
+}
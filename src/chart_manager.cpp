@@ -1,18 +1,137 @@
 #include "chart_manager.h"
 #include "config.h"
-#include <LittleFS.h>
+#include "data_logger.h"
+#include "channels.h"
+#include "request_arena.h"
+#include "run_compression.h"
 #include <ArduinoJson.h>
 
-String generateChartData(const String* fileNames, int fileCount) {
-    JsonDocument doc;
+#define CHART_MIN_POWER_W 0.05  // Below this efficiency is noise over a near-zero divisor
+#define CHART_MAX_COLUMNS 4
+
+struct ChartChannelInfo {
+    const char* name;
+    const char* label;
+};
+
+static const ChartChannelInfo channelInfo[] = {
+    {"thrust", "Thrust (grams)"},
+    {"torque", "Torque (N·mm)"},
+    {"rpm", "RPM"},
+    {"power", "Shaft power (W)"},
+    {"efficiency", "Efficiency (g/W)"},
+};
+
+bool parseChartChannel(const String& name, ChartChannel& channel) {
+    for (size_t i = 0; i < sizeof(channelInfo) / sizeof(channelInfo[0]); i++) {
+        if (name == channelInfo[i].name) {
+            channel = (ChartChannel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Column of each logged channel in a file's header line; -1 when absent
+static void findColumns(const String& header, int columns[CHANNEL_COUNT]) {
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        columns[channel] = -1;
+    }
+    int column = 0;
+    int start = 0;
+    while (start <= (int)header.length()) {
+        int end = header.indexOf(',', start);
+        if (end < 0) end = header.length();
+        String name = header.substring(start, end);
+        name.trim();
+        for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+            if (name == channelColumn((Channel)channel)) columns[channel] = column;
+        }
+        column++;
+        start = end + 1;
+    }
+}
+
+static float shaftPowerWatts(float torqueNmm, float rpm) {
+    return torqueNmm / 1000.0f * rpm * 2.0f * (float)M_PI / 60.0f;
+}
+
+// Open a data file for charting: false if it cannot be read, usable false
+// if it lacks the columns the channel needs
+static bool openChartFile(RunFileReader& file, const String& fileName, ChartChannel channel,
+                          int columns[CHANNEL_COUNT], bool& usable) {
+    PathString filePath = runFilePath(fileName);
+    if (!file.open(filePath.c_str())) {
+        Serial.printf("Failed to open file: %s\n", filePath.c_str());
+        return false;
+    }
+    
+    // Header line names the columns; older files are timestamp,thrust
+    findColumns(file.readStringUntil('\n'), columns);
+    usable = columns[CHANNEL_THRUST] >= 0;
+    if (channel == CHART_TORQUE || channel == CHART_POWER || channel == CHART_EFFICIENCY) {
+        usable = usable && columns[CHANNEL_TORQUE] >= 0;
+    }
+    if (channel == CHART_RPM || channel == CHART_POWER || channel == CHART_EFFICIENCY) {
+        usable = usable && columns[CHANNEL_RPM] >= 0;
+    }
+    return true;
+}
+
+// Next point of a file: its timestamp and the channel's value, or a gap
+// (hasValue false). False at the end of the file.
+static bool nextChartPoint(RunFileReader& file, const int columns[CHANNEL_COUNT], ChartChannel channel,
+                           float& timestamp, float& value, bool& hasValue) {
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        
+        if (line.length() == 0 || line.indexOf(',') <= 0) continue;
+        
+        // Split in place: timestamp first, then the channel columns
+        float values[CHART_MAX_COLUMNS] = {0};
+        const char* p = line.c_str();
+        for (int column = 0; column < CHART_MAX_COLUMNS && *p; column++) {
+            char* end;
+            values[column] = strtof(p, &end);
+            p = *end == ',' ? end + 1 : "";
+        }
+        
+        ChannelSample sample = {{0.0f, 0.0f, 0.0f}};
+        for (int c = 0; c < CHANNEL_COUNT; c++) {
+            if (columns[c] > 0 && columns[c] < CHART_MAX_COLUMNS) sample.value[c] = values[columns[c]];
+        }
+        
+        timestamp = values[0];
+        hasValue = true;
+        float power = shaftPowerWatts(sample.value[CHANNEL_TORQUE], sample.value[CHANNEL_RPM]);
+        switch (channel) {
+            case CHART_THRUST: value = sample.value[CHANNEL_THRUST]; break;
+            case CHART_TORQUE: value = sample.value[CHANNEL_TORQUE]; break;
+            case CHART_RPM: value = sample.value[CHANNEL_RPM]; break;
+            case CHART_POWER: value = power; break;
+            case CHART_EFFICIENCY:
+                // A gap rather than a spike while the prop is (nearly) stopped
+                hasValue = power >= CHART_MIN_POWER_W;
+                value = hasValue ? sample.value[CHANNEL_THRUST] / power : 0.0f;
+                break;
+        }
+        return true;
+    }
+    return false;
+}
+
+const char* generateChartData(const String* fileNames, int fileCount, size_t& length, ChartChannel channel) {
+    JsonDocument doc(arenaAllocator());
+    doc["channel"] = channelInfo[channel].name;
+    doc["label"] = channelInfo[channel].label;
     JsonArray datasets = doc["datasets"].to<JsonArray>();
     
     for (int i = 0; i < fileCount; i++) {
-        String filePath = String(RUNS_DIR) + "/" + fileNames[i];
-        
-        File file = LittleFS.open(filePath, "r");
-        if (!file) {
-            Serial.println("Failed to open file: " + filePath);
+        RunFileReader file;
+        int columns[CHANNEL_COUNT];
+        bool usable;
+        if (!openChartFile(file, fileNames[i], channel, columns, usable)) {
             continue;
         }
         
@@ -20,29 +139,53 @@ String generateChartData(const String* fileNames, int fileCount) {
         dataset["name"] = fileNames[i];
         JsonArray data = dataset["data"].to<JsonArray>();
         
-        // Skip header line
-        String line = file.readStringUntil('\n');
-        
-        // Read data points
-        while (file.available()) {
-            line = file.readStringUntil('\n');
-            line.trim();
-            
-            if (line.length() == 0) continue;
-            
-            int commaPos = line.indexOf(',');
-            if (commaPos > 0) {
-                JsonArray point = data.add<JsonArray>();
-                point.add(line.substring(0, commaPos).toFloat());  // timestamp
-                point.add(line.substring(commaPos + 1).toFloat()); // thrust
-            }
+        float timestamp, value;
+        bool hasValue;
+        while (usable && nextChartPoint(file, columns, channel, timestamp, value, hasValue)) {
+            JsonArray point = data.add<JsonArray>();
+            point.add(timestamp);
+            if (hasValue) point.add(value);
+            else point.add(nullptr);
         }
         
         file.close();
     }
     
-    String output;
-    serializeJson(doc, output);
-    return output;
+    if (doc.overflowed()) {
+        Serial.println("Chart data: out of memory");
+        return nullptr;
+    }
+    return serializeJsonToArena(doc, length);
 }
 
+void writeChartData(JsonWriter& json, const String* fileNames, int fileCount, ChartChannel channel) {
+    json.beginObject()
+        .field("channel", channelInfo[channel].name)
+        .field("label", channelInfo[channel].label);
+    json.key("datasets").beginArray();
+    
+    for (int i = 0; i < fileCount; i++) {
+        RunFileReader file;
+        int columns[CHANNEL_COUNT];
+        bool usable;
+        if (!openChartFile(file, fileNames[i], channel, columns, usable)) {
+            continue;
+        }
+        
+        json.beginObject().field("name", fileNames[i]);
+        json.key("data").beginArray();
+        float timestamp, value;
+        bool hasValue;
+        while (usable && nextChartPoint(file, columns, channel, timestamp, value, hasValue)) {
+            json.beginArray().value((unsigned long)timestamp);
+            if (hasValue) json.value(value, 2);
+            else json.null();
+            json.endArray();
+        }
+        json.endArray().endObject();
+        
+        file.close();
+    }
+    
+    json.endArray().endObject();
+}
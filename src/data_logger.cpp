@@ -1,11 +1,18 @@
 #include "data_logger.h"
+#include "trace.h"
+#include "metrics.h"
 #include "config.h"
+#include "run_compression.h"
 #include <LittleFS.h>
 
 static File currentFile;
-static String currentFileName = "";
+static PathString currentFileName;
 static bool fileOpen = false;
 static int sampleCount = 0;
+static uint8_t fileChannels = CHANNEL_BIT(CHANNEL_THRUST);
+static FixedString<96> fileComment;
+static DataFileStats currentStats = {0, 0, 0.0};
+static size_t fileBytes = 0;
 
 bool initDataLogger() {
     // Create data directories if they don't exist
@@ -27,30 +34,52 @@ bool initDataLogger() {
     return true;
 }
 
-bool createDataFile(const String& fileName) {
+PathString runFilePath(const String& fileName) {
+    if (fileName.startsWith("/")) {
+        return PathString(fileName.c_str());
+    }
+    PathString path(RUNS_DIR "/");
+    path += fileName;
+    return path;
+}
+
+bool createDataFile(const String& fileName, const char* comment, uint8_t channels) {
     // Close any existing file
     if (fileOpen) {
         closeDataFile();
     }
     
     // Open new file for writing
-    String fullPath = String(RUNS_DIR) + "/" + fileName;
+    PathString fullPath = runFilePath(fileName);
     currentFile = LittleFS.open(fullPath, "w");
     
     if (!currentFile) {
-        Serial.println("Failed to create data file: " + fullPath);
+        Serial.printf("Failed to create data file: %s\n", fullPath.c_str());
         return false;
     }
 
-    // Write CSV header
-    currentFile.println("timestamp_ms,thrust_grams");
+    // Write CSV header: thrust stays the second column, so two-column readers
+    // work on any file. Readers skip the comment: it has no comma.
+    fileChannels = channels | CHANNEL_BIT(CHANNEL_THRUST);
+    FixedString<64> header("timestamp_ms");
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (fileChannels & CHANNEL_BIT(channel)) {
+            header.appendf(",%s", channelColumn((Channel)channel));
+        }
+    }
+    fileBytes = currentFile.println(header.c_str());
+    fileComment = comment ? comment : "";
+    if (comment) {
+        fileBytes += currentFile.printf("# %s\r\n", comment);
+    }
     currentFile.flush();
     
     currentFileName = fullPath;
     fileOpen = true;
     sampleCount = 0;
+    currentStats = {0, 0, 0.0};
     
-    Serial.println("Created data file: " + fullPath);
+    Serial.printf("Created data file: %s\n", fullPath.c_str());
     return true;
 }
 
@@ -58,49 +87,104 @@ int getSampleCount() {
     return sampleCount;
 }
 
+DataFileStats getCurrentFileStats() {
+    return currentStats;
+}
+
+size_t getCurrentFileBytes() {
+    return fileBytes;
+}
+
+uint8_t getCurrentFileChannels() {
+    return fileChannels;
+}
+
+const char* getCurrentFileComment() {
+    return fileComment.c_str();
+}
+
 bool logSample(float thrust, unsigned long timestamp) {
+    ChannelSample sample = {{thrust, 0.0f, 0.0f}};
+    return logSample(sample, timestamp);
+}
+
+bool logSample(const ChannelSample& sample, unsigned long timestamp) {
     if (!fileOpen || !currentFile) {
         Serial.println("No file open for logging");
         return false;
     }
     
-    // Write CSV row: timestamp,thrust
-    currentFile.print(timestamp);
-    currentFile.print(",");
-    currentFile.println(thrust, 2);  // 2 decimal places
+    TRACE_SCOPE("file.write");
+    unsigned long writeStart = micros();
+    
+    // Write CSV row: timestamp,thrust (2 decimal places)[,torque][,rpm] as one write
+    float thrust = sample.value[CHANNEL_THRUST];
+    FixedString<64> row;
+    row.appendf("%lu,%.2f", timestamp, thrust);
+    if (fileChannels & CHANNEL_BIT(CHANNEL_TORQUE)) {
+        row.appendf(",%.2f", sample.value[CHANNEL_TORQUE]);
+    }
+    if (fileChannels & CHANNEL_BIT(CHANNEL_RPM)) {
+        row.appendf(",%.0f", sample.value[CHANNEL_RPM]);
+    }
+    row.append("\r\n");
+    fileBytes += currentFile.write((const uint8_t*)row.c_str(), row.length());
+    
+    currentStats.samples++;
+    currentStats.durationMs = timestamp;
+    if (thrust > currentStats.peakThrust) {
+        currentStats.peakThrust = thrust;
+    }
     
     // Flush every 10 samples to balance performance and safety
     //static int sampleCount = 0;
     if (++sampleCount % 10 == 0) {
+        TRACE_SCOPE("file.flush");
+        unsigned long flushStart = micros();
         currentFile.flush();
+        metricObserve(METRIC_FLASH_FLUSH_US, micros() - flushStart);
         //sampleCount = 0;
     }
     
+    metricCount(METRIC_SAMPLES_LOGGED);
+    metricObserve(METRIC_FILE_WRITE_US, micros() - writeStart);
     return true;
 }
 
+size_t syncDataFile() {
+    if (fileOpen && currentFile) {
+        TRACE_SCOPE("file.flush");
+        currentFile.flush();
+    }
+    return fileBytes;
+}
+
 void closeDataFile() {
     if (fileOpen && currentFile) {
         currentFile.flush();
         currentFile.close();
-        Serial.println("Closed data file: " + currentFileName);
+        Serial.printf("Closed data file: %s\n", currentFileName.c_str());
     }
     fileOpen = false;
-    currentFileName = "";
+    currentFileName.clear();
 }
 
 String readDataFile(const String& fileName) {
-    String fullPath = fileName.startsWith("/") ? fileName : String(RUNS_DIR) + "/" + fileName;
+    PathString fullPath = runFilePath(fileName);
     
-    File file = LittleFS.open(fullPath, "r");
+    RunFileReader file(fullPath.c_str());
     if (!file) {
-        Serial.println("Failed to open file for reading: " + fullPath);
+        Serial.printf("Failed to open file for reading: %s\n", fullPath.c_str());
         return "";
     }
     
-    String content = "";
-    while (file.available()) {
-        content += (char)file.read();
+    // One allocation of the final size instead of regrowing per byte
+    String content;
+    content.reserve(file.size());
+    char buffer[256];
+    size_t n;
+    while ((n = file.read((uint8_t*)buffer, sizeof(buffer))) > 0) {
+        content.concat(buffer, n);
     }
     file.close();
     
@@ -108,26 +192,61 @@ String readDataFile(const String& fileName) {
 }
 
 bool deleteDataFile(const String& fileName) {
-    String fullPath = fileName.startsWith("/") ? fileName : String(RUNS_DIR) + "/" + fileName;
+    PathString fullPath = runFilePath(fileName);
     
     if (!LittleFS.exists(fullPath)) {
-        Serial.println("File does not exist: " + fullPath);
+        Serial.printf("File does not exist: %s\n", fullPath.c_str());
         return false;
     }
     
     if (LittleFS.remove(fullPath)) {
-        Serial.println("Deleted file: " + fullPath);
+        Serial.printf("Deleted file: %s\n", fullPath.c_str());
         return true;
     }
     
-    Serial.println("Failed to delete file: " + fullPath);
+    Serial.printf("Failed to delete file: %s\n", fullPath.c_str());
     return false;
 }
 
+bool scanDataFileStats(const String& fileName, DataFileStats& stats) {
+    PathString fullPath = runFilePath(fileName);
+    stats = {0, 0, 0.0};
+    
+    RunFileReader file(fullPath.c_str());
+    if (!file) {
+        return false;
+    }
+    
+    scanDataFileRows(file, SIZE_MAX, stats);
+    file.close();
+    return true;
+}
+
+bool scanDataFileRows(Stream& file, size_t maxBytes, DataFileStats& stats) {
+    // Lines are parsed in place; the header has no digits before its comma and is skipped
+    char line[48];
+    size_t scanned = 0;
+    while (scanned < maxBytes && file.available()) {
+        size_t n = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        scanned += n + 1;
+        line[n] = '\0';
+        char* comma = strchr(line, ',');
+        if (!comma || comma == line || line[0] < '0' || line[0] > '9') continue;
+        
+        float thrust = strtof(comma + 1, nullptr);
+        stats.samples++;
+        stats.durationMs = strtoul(line, nullptr, 10);
+        if (thrust > stats.peakThrust) {
+            stats.peakThrust = thrust;
+        }
+    }
+    return file.available() > 0;
+}
+
 size_t getFileSize(const String& fileName) {
-    String fullPath = fileName.startsWith("/") ? fileName : String(RUNS_DIR) + "/" + fileName;
+    PathString fullPath = runFilePath(fileName);
     
-    File file = LittleFS.open(fullPath, "r");
+    RunFileReader file(fullPath.c_str());
     if (!file) {
         return 0;
     }
@@ -0,0 +1,201 @@
+// src/file_ops.cpp
+#include "file_ops.h"
+#include "config.h"
+#include "run_catalog.h"
+#include "run_manager.h"
+#include "data_logger.h"
+#include "job_scheduler.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+
+#define MAX_KEPT_BATCHES 4
+
+struct FileBatch {
+    int id;
+    std::vector<FileOp> ops;
+    size_t next;      // Index of the next operation to run
+};
+
+static std::vector<FileBatch> batches;
+static int nextBatchId = 1;
+
+bool parseFileOpType(const String& name, FileOpType& type) {
+    if (name == "delete") {
+        type = FILE_OP_DELETE;
+    } else if (name == "rename") {
+        type = FILE_OP_RENAME;
+    } else if (name == "archive") {
+        type = FILE_OP_ARCHIVE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isRecordingFile(const String& path) {
+    return isRunActive() && runFilePath(getCurrentRun().currentFileName) == path.c_str();
+}
+
+void runFileOp(FileOp& op) {
+    op.done = true;
+    op.ok = false;
+
+    if (op.path == "" || !LittleFS.exists(op.path)) {
+        op.error = "Path not found";
+        return;
+    }
+    if (isRecordingFile(op.path)) {
+        op.error = "File is being recorded";
+        return;
+    }
+
+    switch (op.type) {
+        case FILE_OP_DELETE:
+            // rmdir only works if the directory is empty
+            op.ok = LittleFS.remove(op.path) || LittleFS.rmdir(op.path);
+            if (!op.ok) op.error = "Delete failed";
+            break;
+
+        case FILE_OP_RENAME:
+            if (op.target == "") {
+                op.error = "Missing target";
+                return;
+            }
+            op.ok = LittleFS.rename(op.path, op.target);
+            if (!op.ok) op.error = "Rename failed";
+            break;
+
+        case FILE_OP_ARCHIVE: {
+            if (!LittleFS.exists(ARCHIVE_DIR) && !LittleFS.mkdir(ARCHIVE_DIR)) {
+                op.error = "Failed to create archive directory";
+                return;
+            }
+            op.target = String(ARCHIVE_DIR) + op.path.substring(op.path.lastIndexOf('/'));
+            op.ok = LittleFS.rename(op.path, op.target);
+            if (!op.ok) op.error = "Archive failed";
+            break;
+        }
+    }
+
+    if (op.ok) {
+        catalogBeginBatch();
+        catalogPathChanged(op.path);
+        if (op.type == FILE_OP_RENAME) {
+            catalogPathChanged(op.target);
+        }
+        catalogCommit();
+    }
+}
+
+// Run the next operation of a batch
+static void runBatchOp(FileBatch& batch) {
+    FileOp& op = batch.ops[batch.next++];
+    for (size_t i = 0; op.afterSuccess && i + 1 < batch.next; i++) {
+        if (!batch.ops[i].ok) {
+            op.done = true;
+            op.ok = false;
+            op.error = "Skipped: an earlier operation failed";
+            return;
+        }
+    }
+    runFileOp(op);
+}
+
+static FileBatch* findBatch(int batchId) {
+    for (FileBatch& batch : batches) {
+        if (batch.id == batchId) return &batch;
+    }
+    return nullptr;
+}
+
+static String batchJobName(int batchId) {
+    return "file-batch-" + String(batchId);
+}
+
+// Finished, or its job was cancelled so it never will be
+static bool isBatchOver(const FileBatch& batch) {
+    return batch.next >= batch.ops.size() || !isJobPending(batchJobName(batch.id));
+}
+
+int submitFileBatch(const std::vector<FileOp>& ops) {
+    // Forget the oldest batches that are over so results don't pile up; ones
+    // still running are kept wherever they are
+    size_t over = std::count_if(batches.begin(), batches.end(), isBatchOver);
+    for (auto it = batches.begin(); it != batches.end() && over >= MAX_KEPT_BATCHES;) {
+        if (isBatchOver(*it)) {
+            it = batches.erase(it);
+            over--;
+        } else {
+            ++it;
+        }
+    }
+
+    FileBatch batch;
+    batch.id = nextBatchId++;
+    batch.ops = ops;
+    batch.next = 0;
+    batches.push_back(batch);
+
+    // One operation per job step
+    int batchId = batch.id;
+    scheduleJob(batchJobName(batchId), JOB_PRIORITY_NORMAL, [batchId](JobStatus& status) {
+        FileBatch* batch = findBatch(batchId);
+        if (!batch) {
+            return false;
+        }
+        if (batch->next < batch->ops.size()) {
+            runBatchOp(*batch);
+        }
+        status.done = batch->next;
+        status.total = batch->ops.size();
+        return batch->next < batch->ops.size();
+    });
+
+    Serial.println("Queued file batch " + String(batchId) + " (" + String(ops.size()) + " ops)");
+    return batchId;
+}
+
+void finishFileBatch(int batchId) {
+    FileBatch* batch = findBatch(batchId);
+    if (batch) {
+        catalogBeginBatch();
+        while (batch->next < batch->ops.size()) {
+            runBatchOp(*batch);
+        }
+        catalogCommit();
+    }
+}
+
+bool isFileBatchActive(int batchId) {
+    FileBatch* batch = findBatch(batchId);
+    return batch && !isBatchOver(*batch);
+}
+
+String getFileBatchStatus(int batchId) {
+    for (const FileBatch& batch : batches) {
+        if (batch.id != batchId) continue;
+
+        JsonDocument doc;
+        doc["id"] = batch.id;
+        doc["total"] = batch.ops.size();
+        doc["completed"] = batch.next;
+        doc["done"] = batch.next >= batch.ops.size();
+        doc["cancelled"] = isBatchOver(batch) && batch.next < batch.ops.size();
+
+        JsonArray results = doc["results"].to<JsonArray>();
+        for (size_t i = 0; i < batch.next; i++) {
+            const FileOp& op = batch.ops[i];
+            JsonObject result = results.add<JsonObject>();
+            result["path"] = op.path;
+            result["ok"] = op.ok;
+            if (op.target != "") result["target"] = op.target;
+            if (!op.ok) result["error"] = op.error;
+        }
+
+        String output;
+        serializeJson(doc, output);
+        return output;
+    }
+    return "";
+}
@@ -0,0 +1,126 @@
+// src/hal_esp32.cpp - ESP32 implementation of hal.h (excluded from [env:native])
+#include "hal.h"
+#include <HX711.h>
+#include <esp_heap_caps.h>
+#include <driver/pcnt.h>
+#include <unistd.h>
+
+class HX711Driver : public LoadCellDriver {
+public:
+    bool begin(uint8_t doutPin, uint8_t sckPin) override {
+        scale.begin(doutPin, sckPin);
+        return true;
+    }
+
+    bool isReady() override {
+        return scale.is_ready();
+    }
+
+    long readRaw() override {
+        return scale.read();
+    }
+
+    const char* name() const override {
+        return "hx711";
+    }
+
+private:
+    HX711 scale;
+};
+
+LoadCellDriver& hardwareLoadCellDriver(uint8_t index) {
+    static HX711Driver drivers[HARDWARE_LOAD_CELLS];
+    return drivers[index < HARDWARE_LOAD_CELLS ? index : 0];
+}
+
+// PCNT unit 0 counting rising edges, glitch-filtered. The unit wraps to 0 at
+// its high limit; deltas are taken modulo that, never cleared, so no edge is
+// lost between reading and clearing.
+#define PULSE_COUNTER_LIMIT 32767
+#define PULSE_FILTER_APB_TICKS 1000  // 12.5 us at 80 MHz
+
+class PcntPulseCounter : public PulseCounter {
+public:
+    bool begin(uint8_t pin) override {
+        pcnt_config_t config = {};
+        config.pulse_gpio_num = pin;
+        config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+        config.channel = PCNT_CHANNEL_0;
+        config.unit = PCNT_UNIT_0;
+        config.pos_mode = PCNT_COUNT_INC;
+        config.neg_mode = PCNT_COUNT_DIS;
+        config.lctrl_mode = PCNT_MODE_KEEP;
+        config.hctrl_mode = PCNT_MODE_KEEP;
+        config.counter_h_lim = PULSE_COUNTER_LIMIT;
+        config.counter_l_lim = 0;
+        if (pcnt_unit_config(&config) != ESP_OK) {
+            return false;
+        }
+        pcnt_set_filter_value(PCNT_UNIT_0, PULSE_FILTER_APB_TICKS);
+        pcnt_filter_enable(PCNT_UNIT_0);
+        pcnt_counter_pause(PCNT_UNIT_0);
+        pcnt_counter_clear(PCNT_UNIT_0);
+        pcnt_counter_resume(PCNT_UNIT_0);
+        last = 0;
+        return true;
+    }
+
+    uint32_t takeCount() override {
+        int16_t value = 0;
+        pcnt_get_counter_value(PCNT_UNIT_0, &value);
+        uint32_t delta = (value - last + PULSE_COUNTER_LIMIT) % PULSE_COUNTER_LIMIT;
+        last = value;
+        return delta;
+    }
+
+    const char* name() const override {
+        return "pcnt";
+    }
+
+private:
+    int16_t last = 0;
+};
+
+PulseCounter& hardwarePulseCounter() {
+    static PcntPulseCounter counter;
+    return counter;
+}
+
+// LittleFS is mounted in the VFS at its default base path
+bool truncateFile(const char* path, size_t size) {
+    String vfsPath = String("/littlefs") + path;
+    return truncate(vfsPath.c_str(), size) == 0;
+}
+
+uint32_t cycleCount() {
+    return ESP.getCycleCount();
+}
+
+uint32_t cyclesPerMicrosecond() {
+    return getCpuFrequencyMhz();
+}
+
+HeapInfo heapInfo() {
+    HeapInfo info;
+    info.freeHeap = ESP.getFreeHeap();
+    info.minFreeHeap = ESP.getMinFreeHeap();
+    info.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    info.psramSize = ESP.getPsramSize();
+    info.psramFree = ESP.getFreePsram();
+    return info;
+}
+
+// Modules without PSRAM (WROOM-32) fail the SPIRAM request at once and use internal RAM
+void* largeAlloc(size_t size) {
+    void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return ptr ? ptr : malloc(size);
+}
+
+void* largeRealloc(void* ptr, size_t size) {
+    void* moved = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return moved ? moved : realloc(ptr, size);
+}
+
+void largeFree(void* ptr) {
+    heap_caps_free(ptr);
+}
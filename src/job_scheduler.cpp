@@ -0,0 +1,152 @@
+// src/job_scheduler.cpp
+#include "job_scheduler.h"
+#include "config.h"
+#include "run_manager.h"
+#include <ArduinoJson.h>
+#include <vector>
+
+#define MAX_KEPT_FINISHED_JOBS 8
+
+struct Job {
+    JobStatus status;
+    JobStep step;
+};
+
+static std::vector<Job> jobs;
+static int nextJobId = 1;
+
+static bool isFinished(const Job& job) {
+    return job.status.state == JOB_DONE || job.status.state == JOB_CANCELLED;
+}
+
+static const char* stateName(JobState state) {
+    switch (state) {
+        case JOB_QUEUED: return "queued";
+        case JOB_RUNNING: return "running";
+        case JOB_DONE: return "done";
+        case JOB_CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+static Job* findJob(int jobId) {
+    for (Job& job : jobs) {
+        if (job.status.id == jobId) return &job;
+    }
+    return nullptr;
+}
+
+// Highest priority unfinished job, oldest first within a priority
+static Job* nextRunnableJob() {
+    Job* best = nullptr;
+    for (Job& job : jobs) {
+        if (!isFinished(job) && (!best || job.status.priority > best->status.priority)) {
+            best = &job;
+        }
+    }
+    return best;
+}
+
+static void pruneFinishedJobs() {
+    size_t finished = 0;
+    for (const Job& job : jobs) {
+        if (isFinished(job)) finished++;
+    }
+
+    for (size_t i = 0; i < jobs.size() && finished > MAX_KEPT_FINISHED_JOBS; ) {
+        if (isFinished(jobs[i])) {
+            jobs.erase(jobs.begin() + i);
+            finished--;
+        } else {
+            i++;
+        }
+    }
+}
+
+int scheduleJob(const String& name, JobPriority priority, JobStep step) {
+    pruneFinishedJobs();
+
+    Job job;
+    job.status.id = nextJobId++;
+    job.status.name = name;
+    job.status.priority = priority;
+    job.status.state = JOB_QUEUED;
+    job.status.done = 0;
+    job.status.total = 0;
+    job.status.message = "";
+    job.step = step;
+    jobs.push_back(job);
+
+    Serial.println("Scheduled job " + String(job.status.id) + ": " + name);
+    return job.status.id;
+}
+
+bool isJobPending(const String& name) {
+    for (const Job& job : jobs) {
+        if (!isFinished(job) && job.status.name == name) return true;
+    }
+    return false;
+}
+
+bool cancelJob(int jobId) {
+    Job* job = findJob(jobId);
+    if (!job || isFinished(*job)) {
+        return false;
+    }
+    job->status.state = JOB_CANCELLED;
+    job->step = nullptr;
+    return true;
+}
+
+void handleJobs() {
+    // Heavy work never overlaps a run
+    if (isRunActive()) {
+        return;
+    }
+
+    unsigned long start = millis();
+    while (millis() - start < JOB_SLICE_MS) {
+        Job* job = nextRunnableJob();
+        if (!job) {
+            return;
+        }
+
+        // Run the step on copies - it may schedule more jobs and reallocate the list
+        JobStatus status = job->status;
+        JobStep step = job->step;
+        status.state = JOB_RUNNING;
+        bool more = step(status);
+
+        job = findJob(status.id);
+        if (!job || isFinished(*job)) {
+            continue;  // Cancelled from inside its own step
+        }
+        job->status = status;
+        if (!more) {
+            job->status.state = JOB_DONE;
+            job->step = nullptr;
+            Serial.println("Job " + String(status.id) + " finished: " + status.name);
+        }
+    }
+}
+
+String getJobsStatus() {
+    JsonDocument doc;
+    doc["paused"] = isRunActive();
+    JsonArray list = doc["jobs"].to<JsonArray>();
+
+    for (const Job& job : jobs) {
+        JsonObject obj = list.add<JsonObject>();
+        obj["id"] = job.status.id;
+        obj["name"] = job.status.name;
+        obj["priority"] = (int)job.status.priority;
+        obj["state"] = stateName(job.status.state);
+        obj["done"] = job.status.done;
+        obj["total"] = job.status.total;
+        if (job.status.message.length() > 0) obj["message"] = job.status.message;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
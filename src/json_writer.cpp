@@ -0,0 +1,159 @@
+// src/json_writer.cpp
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity, JsonSink sink, void* sinkContext)
+    : buf(buffer), cap(capacity), len(0), overflow(false), sink(sink), sinkContext(sinkContext),
+      hasItems(0), depth(0), afterKey(false) {
+    if (cap > 0) buf[0] = '\0';
+}
+
+void JsonWriter::flush() {
+    if (sink && len > 0) {
+        sink(sinkContext, buf, len);
+        len = 0;
+        buf[0] = '\0';
+    }
+}
+
+void JsonWriter::raw(const char* s, size_t n) {
+    while (n > 0) {
+        // Keep one byte for the terminator
+        size_t room = cap - 1 - len;
+        if (room == 0) {
+            if (!sink) {
+                overflow = true;
+                return;
+            }
+            flush();
+            continue;
+        }
+        size_t chunk = n < room ? n : room;
+        memcpy(buf + len, s, chunk);
+        len += chunk;
+        buf[len] = '\0';
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+// Comma before every item after the first at this level, except a value after its key
+void JsonWriter::separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    uint32_t bit = 1UL << depth;
+    if (hasItems & bit) raw(",", 1);
+    hasItems |= bit;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    raw("{", 1);
+    depth++;
+    hasItems &= ~(1UL << depth);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    if (depth > 0) depth--;
+    raw("}", 1);
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    raw("[", 1);
+    depth++;
+    hasItems &= ~(1UL << depth);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    if (depth > 0) depth--;
+    raw("]", 1);
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    separator();
+    quoted(name ? name : "");
+    raw(":", 1);
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* s) {
+    if (!s) return null();
+
+    separator();
+    quoted(s);
+    return *this;
+}
+
+void JsonWriter::quoted(const char* s) {
+    raw("\"", 1);
+    const char* run = s;
+    for (const char* p = s; *p; p++) {
+        unsigned char c = *p;
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+        raw(run, p - run);
+        char escape[8];
+        switch (c) {
+            case '"': raw("\\\"", 2); break;
+            case '\\': raw("\\\\", 2); break;
+            case '\n': raw("\\n", 2); break;
+            case '\r': raw("\\r", 2); break;
+            case '\t': raw("\\t", 2); break;
+            default:
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                raw(escape);
+        }
+        run = p + 1;
+    }
+    raw(run, strlen(run));
+    raw("\"", 1);
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+    separator();
+    raw(b ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long n) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lld", n);
+    separator();
+    raw(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long long n) {
+    char text[24];
+    snprintf(text, sizeof(text), "%llu", n);
+    separator();
+    raw(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double n, int decimals) {
+    if (isnan(n) || isinf(n)) return null();
+
+    char text[32];
+    if (decimals >= 0) {
+        snprintf(text, sizeof(text), "%.*f", decimals, n);
+    } else {
+        snprintf(text, sizeof(text), "%.9g", n);
+    }
+    separator();
+    raw(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separator();
+    raw("null", 4);
+    return *this;
+}
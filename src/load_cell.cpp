@@ -1,41 +1,68 @@
 // ===== src/load_cell.cpp =====
 #include "load_cell.h"
 #include "config.h"
-#include <HX711.h>
+#include "hal.h"
+#include "sim_load_cell.h"
+#include "trace.h"
+#include "metrics.h"
 
-static HX711 scale;
+#define TARE_READINGS 10
+
+// Build with -DLOAD_CELL_SIMULATED to start on the simulated load cell
+#ifdef LOAD_CELL_SIMULATED
+static LoadCellDriver* driver = &simLoadCellDriver();
+#else
+static LoadCellDriver* driver = &hardwareLoadCellDriver();
+#endif
 static bool initialized = false;
+static uint8_t driverDoutPin = HX711_DOUT_PIN;
+static uint8_t driverSckPin = HX711_SCK_PIN;
+static long tareOffset = 0;
+static LoadCellCurve curve = {0.0f, 1.0f / LOAD_CELL_CALIBRATION_FACTOR, 0.0f};
+
+// Branch-free: the same multiply-adds for linear (c2 = 0) and quadratic curves
+static inline float countsToGrams(float x) {
+    return curve.c0 + x * (curve.c1 + x * curve.c2);
+}
 
 bool initLoadCell(uint8_t doutPin, uint8_t sckPin) {
-    scale.begin(doutPin, sckPin);
+    driverDoutPin = doutPin;
+    driverSckPin = sckPin;
+    initialized = false;
+    driver->begin(doutPin, sckPin);
     
-    if (!scale.is_ready()) {
-        Serial.println("HX711 not found. Check wiring.");
+    if (!driver->isReady()) {
+        Serial.println(String(driver->name()) + " not found. Check wiring.");
         return false;
     }
     
-    // Set calibration factor (adjust this during calibration)
-    scale.set_scale(LOAD_CELL_CALIBRATION_FACTOR);
+    initialized = true;
     
     // Tare the scale on startup
-    Serial.println("Taring load cell...");
-    scale.tare();
+    tareLoadCell();
     
-    initialized = true;
     Serial.println("Load cell ready");
     return true;
 }
 
 float readThrust() {
-    if (!initialized || !scale.is_ready()) {
+    if (!initialized) {
+        return 0.0;
+    }
+    if (!driver->isReady()) {
+        metricCount(METRIC_LOADCELL_NOT_READY);
         return 0.0;
     }
     
-    // Read average of 1 sample (you can increase for stability)
-    float reading = scale.get_units(1);
+    TRACE_SCOPE("loadcell.read");
     
+    // Read 1 sample (you can average more for stability)
+    return netCountsToThrust(driver->readRaw() - tareOffset);
+}
+
+float netCountsToThrust(long counts) {
     // Return absolute value (thrust is always positive)
-    return abs(reading);
+    return fabsf(countsToGrams((float)counts));
 }
 
 void tareLoadCell() {
@@ -44,38 +71,57 @@ void tareLoadCell() {
     }
     
     Serial.println("Taring load cell...");
-    scale.tare();
-}
-/*
-void calibrateLoadCell(float knownWeight) {
-    if (!initialized || !scale.is_ready()) {
-        Serial.println("Cannot calibrate: load cell not ready");
-        return;
+    long long sum = 0;
+    for (int i = 0; i < TARE_READINGS; i++) {
+        sum += driver->readRaw();
     }
-    
-    Serial.println("Place known weight on load cell...");
-    delay(2000);
-    
-    // Read the raw value
-    long reading = scale.get_units(10);
-    
-    // Calculate calibration factor
-    float calibrationFactor = reading / knownWeight;
-    scale.set_scale(calibrationFactor);
-    
-    Serial.print("New calibration factor: ");
-    Serial.println(calibrationFactor);
-    Serial.println("Update LOAD_CELL_CALIBRATION_FACTOR in config.h with this value");
+    tareOffset = sum / TARE_READINGS;
 }
-*/
+
 bool isLoadCellReady() {
-    return initialized && scale.is_ready();
+    return initialized && driver->isReady();
 }
 
 void setLoadCellCalibration(float calibrationFactor) {
-    if (initialized && calibrationFactor != 0.0) {
-        scale.set_scale(calibrationFactor);
+    // Stored even before initLoadCell() so a saved factor loaded at boot takes effect
+    if (calibrationFactor != 0.0) {
+        curve = LoadCellCurve{0.0f, 1.0f / calibrationFactor, 0.0f};
         Serial.print("Updated load cell calibration to: ");
         Serial.println(calibrationFactor, 2);
     }
-}
\ No newline at end of file
+}
+
+void setLoadCellCurve(const LoadCellCurve& newCurve) {
+    curve = newCurve;
+    Serial.printf("Updated load cell curve to: %.6g + %.6g x + %.6g x^2\n", curve.c0, curve.c1, curve.c2);
+}
+
+const LoadCellCurve& getLoadCellCurve() {
+    return curve;
+}
+
+long getTareOffset() {
+    return tareOffset;
+}
+
+void adjustTare(long netCounts) {
+    tareOffset += netCounts;
+}
+
+bool readNetCounts(long& counts) {
+    if (!initialized || !driver->isReady()) {
+        return false;
+    }
+    counts = driver->readRaw() - tareOffset;
+    return true;
+}
+
+bool setLoadCellDriver(LoadCellDriver& newDriver) {
+    driver = &newDriver;
+    Serial.println("Load cell source: " + String(driver->name()));
+    return initLoadCell(driverDoutPin, driverSckPin);
+}
+
+const char* getLoadCellDriverName() {
+    return driver->name();
+}
@@ -3,19 +3,27 @@
 #include "config.h"
 #include "wifi_manager.h"
 #include "load_cell.h"
+#include "calibration.h"
+#include "channels.h"
+#include "serial_stream.h"
+#include "udp_stream.h"
 #include "run_manager.h"
 #include "data_logger.h"
+#include "run_compression.h"
+#include "storage_manager.h"
+#include "run_journal.h"
 #include "config.h"
 #include "web_server.h"
-#include <Preferences.h>
+#include "job_scheduler.h"
+#include "sampler.h"
+#include "run_trigger.h"
+#include "zero_tracker.h"
+#include "trace.h"
+#include "metrics.h"
 
 
-// Timing variables
-unsigned long lastSample = 0;
-
 void setup() {
-    Serial.begin(115200);
-    delay(1000);
+    Serial.begin(SERIAL_BAUD);
     
     // Pin setup
     pinMode(BUTTON_PIN, INPUT_PULLUP);
@@ -31,31 +39,13 @@ void setup() {
     }
     Serial.println("LittleFS mounted successfully");
     
-    // Initialize WiFi
-    delay(2000);
+    // Opens the wifi-config preferences the calibration is read from
     initWiFiManager(BUTTON_PIN, LED_PIN);
-    if (connectToSavedWiFi()) {
-        Serial.flush();
-        delay(1000);
-        Serial.println("Connected to WiFi!");
-        Serial.print("IP Address: ");
-        Serial.println(WiFi.localIP());
-    } else {
-        Serial.println("No WiFi. Hold button for config mode.");
-        return;
-    }
 
-    // Load calibration factor from preferences
-    Preferences prefs;
-    prefs.begin("wifi-config", true);  // Read-only
-    float calibrationFactor = prefs.getFloat("cal_factor", LOAD_CELL_CALIBRATION_FACTOR);
-    prefs.end();
-    
-    if (calibrationFactor != 0.0) {
-        Serial.print("Loaded calibration factor: ");
-        Serial.println(calibrationFactor);
-        // Apply to load cell
-        setLoadCellCalibration(calibrationFactor);
+    // Load calibration from preferences
+    if (loadCalibration()) {
+        LoadCellCurve curve = getLoadCellCurve();
+        Serial.printf("Loaded calibration: %.6g + %.6g*x + %.6g*x^2\n", curve.c0, curve.c1, curve.c2);
     } else {
         Serial.println("Using default calibration factor");
     }
@@ -68,16 +58,36 @@ void setup() {
         Serial.println("Load cell initialized");
     }
     
+    // Torque and RPM inputs, if enabled
+    initChannels();
+    
+    // Data logger first - it creates /data, which the run catalog lives in
+    if (!initDataLogger()) {
+        Serial.println("ERROR: Data logger initialization failed");
+    } else {
+        Serial.println("Data logger initialized");
+    }
+    
+    // Before the catalog: it counts its snapshot writes
+    initStorageManager();
+    
     if (!initRunManager()) {
         Serial.println("ERROR: Run manager initialization failed");
     } else {
         Serial.println("Run manager initialized");
     }
     
-    if (!initDataLogger()) {
-        Serial.println("ERROR: Data logger initialization failed");
-    } else {
-        Serial.println("Data logger initialized");
+    // Repair a run a reset cut short, before compression picks up its file
+    initRunJournal();
+    initRunCompression();
+    scheduleStorageCleanup();
+    initRunTrigger();
+    initSerialStream();
+    initUdpStream();
+    
+    // Connecting continues in loop(); the stand does not wait for the network
+    if (!startWiFi()) {
+        Serial.println("No WiFi. Hold button for config mode.");
     }
         
     if (!initWebServer()) {
@@ -86,7 +96,8 @@ void setup() {
         Serial.println("Web server started");
     }
     
-    Serial.println("=== Initialization Complete ===\n");
+    metricMark(METRIC_BOOT_READY);
+    Serial.printf("=== Initialization Complete in %lu ms ===\n\n", millis());
 }
 
 int read_test = 0;
@@ -99,41 +110,66 @@ void loop() {
          delay(10);
     }
     else {
+        TRACE_SCOPE("loop");
+        unsigned long loopStart = micros();
+        
         // Handle WiFi configuration
-        handleWiFiManager();
+        {
+            TRACE_SCOPE("wifi");
+            handleWiFiManager();
+        }
         
         if (!isInConfigMode()) {
             // Handle web server requests
-            handleWebServer();
+            {
+                TRACE_SCOPE("http");
+                handleWebServer();
+            }
             
-            // If a run is active, log samples at the configured rate
-            if (isRunActive()) {
-                unsigned long currentTime = millis();
-                if (currentTime - lastSample >= SAMPLE_RATE_MS) {
-                    float thrust = readThrust();
-                    unsigned long timestamp = currentTime - getCurrentRun().startTime;
-
-                    if (getSampleCount() == 0 && thrust <= 0.5) {
-                        // Beginning of run. Discard zero/noise sample and advance start time (start all runs with non-zero thrust)
-                        resetStartTime(currentTime);
-                        lastSample = currentTime;
-                    }
-                    else {
-                        if (logSample(thrust, timestamp)) {
-                            // Sample logged successfully
-                            lastSample = currentTime;
-                        } else {
-                            Serial.println("ERROR: Failed to log sample");
-                        }
-                    }
-                }
+            // Background maintenance (paused while a run is active)
+            {
+                TRACE_SCOPE("jobs");
+                handleJobs();
+            }
+            
+            // Bench PC on the USB serial port: commands in, run frames out
+            handleSerialStream();
+            
+            // Batches to the UDP collector
+            handleUdpStream();
+            
+            // Headless start/stop: BOOT button and thrust trigger
+            if (takeButtonPress()) {
+                runTriggerButton();
+            }
+            handleRunTrigger();
+            
+            // Log samples to the active run
+            {
+                TRACE_SCOPE("sampler");
+                handleSampler();
             }
-            // LED indicator
-            if (WiFi.status() == WL_CONNECTED) {
-                digitalWrite(LED_PIN, isRunActive() ? (millis() % 500 < 250) : HIGH);
+            
+            // Stop a run that has filled the room it was given
+            handleStorage();
+            
+            // Checkpoint the recording file for crash recovery
+            handleRunJournal();
+            
+            // Follow zero drift while idle
+            handleZeroTracker();
+            
+            // LED indicator: blinking while recording, a short flash every 2 s while armed,
+            // otherwise on when WiFi is connected
+            if (isRunActive()) {
+                digitalWrite(LED_PIN, millis() % 500 < 250);
+            } else if (getTriggerState() == TRIGGER_ARMED) {
+                digitalWrite(LED_PIN, millis() % 2000 < 100);
             } else {
-                digitalWrite(LED_PIN, LOW);
+                digitalWrite(LED_PIN, WiFi.status() == WL_CONNECTED ? HIGH : LOW);
             }
+            
+            metricObserve(METRIC_LOOP_US, micros() - loopStart);
         }
         else {
 
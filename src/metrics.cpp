@@ -0,0 +1,198 @@
+// src/metrics.cpp
+#include "metrics.h"
+#include "config.h"
+#include "hal.h"
+#include "run_manager.h"
+#include "run_compression.h"
+#include "request_arena.h"
+#include <LittleFS.h>
+#include <atomic>
+
+#define METRIC_BUCKETS 13   // le = 4^0 .. 4^11 us, then +Inf
+
+// Sums are 32-bit microseconds so every update stays a lock-free atomic on
+// the ESP32; they wrap after ~71 min, which Prometheus treats as a reset.
+struct Histogram {
+    std::atomic<uint32_t> buckets[METRIC_BUCKETS];  // Not cumulative
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> sumMicros;
+};
+
+struct RouteHistogram {
+    const char* route;
+    Histogram histogram;
+};
+
+static Histogram histograms[METRIC_HISTOGRAM_COUNT];
+static std::atomic<uint32_t> counters[METRIC_COUNTER_COUNT];
+static std::atomic<uint32_t> moments[METRIC_MOMENT_COUNT];   // millis() + 1, 0 = not yet
+static RouteHistogram routes[METRICS_MAX_ROUTES];
+static size_t routeCount = 0;
+
+static const char* histogramNames[METRIC_HISTOGRAM_COUNT] = {
+    "thrustplotter_loop_duration_seconds",
+    "thrustplotter_sample_interval_seconds",
+    "thrustplotter_file_write_duration_seconds",
+    "thrustplotter_flash_flush_duration_seconds"
+};
+
+static const char* histogramHelp[METRIC_HISTOGRAM_COUNT] = {
+    "Duration of one main loop iteration",
+    "Time between consecutive logged samples",
+    "Duration of logSample() including any flush",
+    "Duration of data file flushes to flash"
+};
+
+static const char* momentNames[METRIC_MOMENT_COUNT] = {
+    "thrustplotter_boot_ready_seconds",
+    "thrustplotter_wifi_connected_seconds",
+    "thrustplotter_time_synced_seconds"
+};
+
+static const char* momentHelp[METRIC_MOMENT_COUNT] = {
+    "Time from boot until sampling and logging were ready",
+    "Time from boot until WiFi first connected",
+    "Time from boot until the clock was first set by NTP"
+};
+
+static const char* counterNames[METRIC_COUNTER_COUNT] = {
+    "thrustplotter_samples_logged_total",
+    "thrustplotter_loadcell_not_ready_total"
+};
+
+static const char* counterHelp[METRIC_COUNTER_COUNT] = {
+    "Samples written to run data files",
+    "Load cell reads skipped because no conversion was ready"
+};
+
+// Smallest k with 4^k >= micros, clamped to the +Inf bucket
+static int bucketIndex(uint32_t micros) {
+    if (micros <= 1) return 0;
+    int bits = 32 - __builtin_clz(micros - 1);
+    int k = (bits + 1) / 2;
+    return k < METRIC_BUCKETS - 1 ? k : METRIC_BUCKETS - 1;
+}
+
+static void observe(Histogram& h, uint32_t micros) {
+    h.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sumMicros.fetch_add(micros, std::memory_order_relaxed);
+}
+
+void metricObserve(MetricHistogram histogram, uint32_t micros) {
+    observe(histograms[histogram], micros);
+}
+
+void metricCount(MetricCounter counter) {
+    counters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+void metricMark(MetricMoment moment) {
+    uint32_t unset = 0;
+    moments[moment].compare_exchange_strong(unset, millis() + 1, std::memory_order_relaxed);
+}
+
+void metricObserveRoute(const char* route, uint32_t micros) {
+    // Routes are only added from the web server's loop, so claiming a slot needs no lock
+    for (size_t i = 0; i < routeCount; i++) {
+        if (routes[i].route == route) {
+            observe(routes[i].histogram, micros);
+            return;
+        }
+    }
+    if (routeCount < METRICS_MAX_ROUTES) {
+        routes[routeCount].route = route;
+        observe(routes[routeCount].histogram, micros);
+        routeCount++;
+    }
+}
+
+static void appendHistogram(String& out, const char* name, const String& labels, const Histogram& h) {
+    String labelPrefix = labels.length() > 0 ? labels + "," : "";
+    uint32_t cumulative = 0;
+    uint32_t bound = 1;
+    char line[256];
+
+    for (int i = 0; i < METRIC_BUCKETS - 1; i++) {
+        cumulative += h.buckets[i].load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), "%s_bucket{%sle=\"%.9g\"} %u\n", name, labelPrefix.c_str(), bound / 1e6, (unsigned)cumulative);
+        out += line;
+        bound *= 4;
+    }
+    cumulative += h.buckets[METRIC_BUCKETS - 1].load(std::memory_order_relaxed);
+    String braces = labels.length() > 0 ? "{" + labels + "}" : "";
+    snprintf(line, sizeof(line), "%s_bucket{%sle=\"+Inf\"} %u\n", name, labelPrefix.c_str(), (unsigned)cumulative);
+    out += line;
+    snprintf(line, sizeof(line), "%s_sum%s %.6f\n", name, braces.c_str(), h.sumMicros.load(std::memory_order_relaxed) / 1e6);
+    out += line;
+    snprintf(line, sizeof(line), "%s_count%s %u\n", name, braces.c_str(), (unsigned)h.count.load(std::memory_order_relaxed));
+    out += line;
+}
+
+static void appendGauge(String& out, const char* name, const char* help, double value) {
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s gauge\n%s %.17g\n", name, help, name, name, value);
+    out += line;
+}
+
+static String gaugesAndCounters() {
+    String out;
+    char line[256];
+
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %u\n", counterNames[i], counterHelp[i],
+                 counterNames[i], counterNames[i], (unsigned)counters[i].load(std::memory_order_relaxed));
+        out += line;
+    }
+
+    // Moments not reached yet are left out rather than reported as 0
+    for (int i = 0; i < METRIC_MOMENT_COUNT; i++) {
+        uint32_t mark = moments[i].load(std::memory_order_relaxed);
+        if (mark != 0) appendGauge(out, momentNames[i], momentHelp[i], (mark - 1) / 1000.0);
+    }
+
+    HeapInfo heap = heapInfo();
+    appendGauge(out, "thrustplotter_uptime_seconds", "Time since boot", millis() / 1000.0);
+    appendGauge(out, "thrustplotter_run_active", "1 while a run is recording", isRunActive() ? 1 : 0);
+    appendGauge(out, "thrustplotter_heap_free_bytes", "Free internal heap", heap.freeHeap);
+    appendGauge(out, "thrustplotter_heap_min_free_bytes", "Lowest free heap since boot", heap.minFreeHeap);
+    appendGauge(out, "thrustplotter_heap_largest_free_block_bytes", "Largest allocatable heap block", heap.largestFreeBlock);
+    appendGauge(out, "thrustplotter_psram_size_bytes", "PSRAM size", heap.psramSize);
+    appendGauge(out, "thrustplotter_psram_free_bytes", "Free PSRAM", heap.psramFree);
+    appendGauge(out, "thrustplotter_request_arena_peak_bytes", "Largest per-request arena since boot", arenaStats().peakBytes);
+    appendGauge(out, "thrustplotter_fs_total_bytes", "LittleFS partition size", LittleFS.totalBytes());
+    appendGauge(out, "thrustplotter_fs_used_bytes", "LittleFS space in use", LittleFS.usedBytes());
+    appendGauge(out, "thrustplotter_fs_free_bytes", "LittleFS space available", LittleFS.totalBytes() - LittleFS.usedBytes());
+    RunStorageStats storage = getRunStorageStats();
+    appendGauge(out, "thrustplotter_run_data_bytes", "CSV size of all run files", storage.dataBytes);
+    appendGauge(out, "thrustplotter_run_stored_bytes", "Flash taken by run files, after compression", storage.storedBytes);
+    appendGauge(out, "thrustplotter_run_files_compressed", "Run files stored compressed", storage.compressedFiles);
+    return out;
+}
+
+String metricsChunk(size_t index) {
+    if (index == 0) {
+        return gaugesAndCounters();
+    }
+
+    index--;
+    if (index < METRIC_HISTOGRAM_COUNT) {
+        String out = "# HELP " + String(histogramNames[index]) + " " + histogramHelp[index] + "\n";
+        out += "# TYPE " + String(histogramNames[index]) + " histogram\n";
+        appendHistogram(out, histogramNames[index], "", histograms[index]);
+        return out;
+    }
+
+    // One chunk per route, all under a single metric family
+    index -= METRIC_HISTOGRAM_COUNT;
+    if (index < routeCount) {
+        const char* name = "thrustplotter_http_request_duration_seconds";
+        String out;
+        if (index == 0) {
+            out = "# HELP " + String(name) + " HTTP handler latency by route\n# TYPE " + name + " histogram\n";
+        }
+        appendHistogram(out, name, "route=\"" + String(routes[index].route) + "\"", routes[index].histogram);
+        return out;
+    }
+    return "";
+}
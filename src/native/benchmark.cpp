@@ -0,0 +1,246 @@
+// src/native/benchmark.cpp - pipeline benchmarks of the host build
+#include "benchmark.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <ftw.h>
+#include <malloc.h>
+#include <vector>
+#include "native_hal.h"
+#include "config.h"
+#include "run_manager.h"
+#include "data_logger.h"
+#include "chart_manager.h"
+#include "request_arena.h"
+#include "job_scheduler.h"
+
+// Heap accounting (glibc): malloc and friends are wrapped so the peak covers
+// String, ArduinoJson's allocator and operator new alike
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+}
+
+static size_t heapInUse = 0;
+static size_t heapPeak = 0;
+
+static void* countAllocation(void* p) {
+    if (p) {
+        heapInUse += malloc_usable_size(p);
+        if (heapInUse > heapPeak) heapPeak = heapInUse;
+    }
+    return p;
+}
+
+extern "C" void* malloc(size_t size) {
+    return countAllocation(__libc_malloc(size));
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    return countAllocation(__libc_calloc(count, size));
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+    if (p) heapInUse -= malloc_usable_size(p);
+    void* resized = __libc_realloc(p, size);
+    if (!resized && p && size) {
+        heapInUse += malloc_usable_size(p);  // Failed; the old block is still live
+        return nullptr;
+    }
+    return countAllocation(resized);
+}
+
+extern "C" void free(void* p) {
+    if (p) heapInUse -= malloc_usable_size(p);
+    __libc_free(p);
+}
+
+// Latencies and heap high-water mark of one operation
+class OpStats {
+public:
+    explicit OpStats(const char* name) : name(name), bytes(0), peakHeap(0) {}
+
+    void begin() {
+        heapBase = heapInUse;
+        heapPeak = heapInUse;
+        startUs = micros();
+    }
+
+    void end(size_t processedBytes = 0) {
+        unsigned long elapsedUs = micros() - startUs;
+        // Before push_back, which allocates on our own behalf
+        if (heapPeak - heapBase > peakHeap) peakHeap = heapPeak - heapBase;
+        latenciesUs.push_back(elapsedUs);
+        bytes += processedBytes;
+    }
+
+    void report(JsonObject out) {
+        std::vector<unsigned long> sorted = latenciesUs;
+        std::sort(sorted.begin(), sorted.end());
+
+        unsigned long long totalUs = 0;
+        for (unsigned long us : sorted) totalUs += us;
+
+        out["name"] = name;
+        out["iterations"] = sorted.size();
+        out["totalMs"] = totalUs / 1000.0;
+        out["opsPerSec"] = totalUs ? sorted.size() * 1e6 / totalUs : 0.0;
+        if (bytes) out["bytesPerSec"] = totalUs ? bytes * 1e6 / totalUs : 0.0;
+        out["p50Us"] = percentile(sorted, 50);
+        out["p99Us"] = percentile(sorted, 99);
+        out["maxUs"] = sorted.empty() ? 0 : sorted.back();
+        out["peakHeapBytes"] = peakHeap;
+    }
+
+private:
+    static unsigned long percentile(const std::vector<unsigned long>& sorted, int p) {
+        if (sorted.empty()) return 0;
+        size_t rank = (sorted.size() * p + 99) / 100;  // Nearest-rank
+        return sorted[rank ? rank - 1 : 0];
+    }
+
+    const char* name;
+    std::vector<unsigned long> latenciesUs;
+    unsigned long long bytes;
+    size_t peakHeap;
+    size_t heapBase;
+    unsigned long startUs;
+};
+
+static int removeEntry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    return ::remove(path);
+}
+
+// Synthetic burn: ramp up, plateau, tail off, with a little deterministic ripple
+static float syntheticThrust(int sample, int samples) {
+    float x = (float)sample / samples;
+    float envelope = x < 0.1 ? x / 0.1 : (x < 0.7 ? 1.0 : (1.0 - x) / 0.3);
+    return 850.0 * envelope + 4.0 * sinf(sample * 0.7);
+}
+
+int runBenchmark(int argc, char** argv) {
+    String fsRoot = "";
+    String outFile = "";
+    int runs = 10;
+    int samples = 3000;
+    int iterations = 50;
+    int chartFiles = 3;
+
+    for (int i = 1; i < argc; i++) {
+        String option = argv[i];
+        if (option == "--fs" && i + 1 < argc) {
+            fsRoot = argv[++i];
+        } else if (option == "--runs" && i + 1 < argc) {
+            runs = String(argv[++i]).toInt();
+        } else if (option == "--samples" && i + 1 < argc) {
+            samples = String(argv[++i]).toInt();
+        } else if (option == "--iterations" && i + 1 < argc) {
+            iterations = String(argv[++i]).toInt();
+        } else if (option == "--chart-files" && i + 1 < argc) {
+            chartFiles = String(argv[++i]).toInt();
+        } else if (option == "--out" && i + 1 < argc) {
+            outFile = argv[++i];
+        } else {
+            fprintf(stderr, "usage: program bench [--fs DIR] [--runs N] [--samples N] [--iterations N] [--chart-files N] [--out FILE]\n");
+            return 1;
+        }
+    }
+    if (runs < 1 || samples < 1 || iterations < 1) {
+        fprintf(stderr, "bench: --runs, --samples and --iterations must be positive\n");
+        return 1;
+    }
+    chartFiles = constrain(chartFiles, 1, runs);
+
+    // Scratch filesystem, removed afterwards unless the caller chose the directory
+    bool scratch = fsRoot.length() == 0;
+    if (scratch) {
+        char dirTemplate[] = "/tmp/thrustplotter_bench_XXXXXX";
+        if (!mkdtemp(dirTemplate)) {
+            perror("bench: mkdtemp");
+            return 1;
+        }
+        fsRoot = dirTemplate;
+    }
+    nativeSetFsRoot(fsRoot);
+    if (!LittleFS.begin(true) || !initDataLogger() || !initRunManager()) {
+        fprintf(stderr, "bench: cannot set up filesystem at %s\n", fsRoot.c_str());
+        return 1;
+    }
+
+    // Populate: one data file per run, written through the normal run path
+    OpStats logStats("logSample");
+    std::vector<String> fileNames;
+    for (int r = 0; r < runs; r++) {
+        String runName = "bench " + String(r);
+        createRunConfig(runName, "Synthetic benchmark run");
+        if (!startRun(runName)) {
+            fprintf(stderr, "bench: cannot start %s\n", runName.c_str());
+            return 1;
+        }
+        fileNames.push_back(getCurrentRun().currentFileName);
+
+        for (int s = 0; s < samples; s++) {
+            float thrust = syntheticThrust(s, samples);
+            logStats.begin();
+            logSample(thrust, s * SAMPLE_RATE_MS);
+            logStats.end();
+        }
+        stopRun();
+    }
+    while (getJobsStatus().indexOf("\"queued\"") >= 0 || getJobsStatus().indexOf("\"running\"") >= 0) {
+        handleJobs();
+    }
+
+    OpStats readStats("readDataFile");
+    for (int i = 0; i < iterations; i++) {
+        readStats.begin();
+        String content = readDataFile(fileNames[i % fileNames.size()]);
+        readStats.end(content.length());
+    }
+
+    OpStats listStats("getRunConfigsList");
+    for (int i = 0; i < iterations; i++) {
+        listStats.begin();
+        String list = getRunConfigsList();
+        listStats.end(list.length());
+    }
+
+    OpStats chartStats("generateChartData");
+    for (int i = 0; i < iterations; i++) {
+        RequestArenaScope arenaScope;
+        size_t length = 0;
+        chartStats.begin();
+        generateChartData(fileNames.data(), chartFiles, length);
+        chartStats.end(length);
+    }
+
+    JsonDocument doc;
+    JsonObject params = doc["params"].to<JsonObject>();
+    params["runs"] = runs;
+    params["samplesPerRun"] = samples;
+    params["iterations"] = iterations;
+    params["chartFiles"] = chartFiles;
+    params["bytesOnDisk"] = LittleFS.usedBytes();
+    JsonArray results = doc["results"].to<JsonArray>();
+    logStats.report(results.add<JsonObject>());
+    readStats.report(results.add<JsonObject>());
+    listStats.report(results.add<JsonObject>());
+    chartStats.report(results.add<JsonObject>());
+
+    String json;
+    serializeJsonPretty(doc, json);
+    FILE* out = outFile.length() > 0 ? fopen(outFile.c_str(), "w") : stdout;
+    if (!out) {
+        perror("bench: --out");
+        return 1;
+    }
+    fprintf(out, "%s\n", json.c_str());
+    if (out != stdout) fclose(out);
+
+    if (scratch) {
+        nftw(fsRoot.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+// src/native/benchmark.h - pipeline benchmarks of the host build
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// program bench [--fs DIR] [--runs N] [--samples N] [--iterations N] [--chart-files N] [--out FILE]
+//
+// Populates a scratch filesystem with synthetic runs, then times logSample(),
+// readDataFile(), getRunConfigsList() and generateChartData(). Prints JSON
+// with throughput, p50/p99/max latency and peak heap per operation.
+int runBenchmark(int argc, char** argv);
+
+#endif
@@ -0,0 +1,83 @@
+// src/native/hal_native.cpp - host implementation of hal.h (only built in [env:native])
+#include "hal.h"
+#include "native_hal.h"
+#include <chrono>
+#include <unistd.h>
+
+// There is no amplifier on the host; it never has a reading ready
+class NoLoadCellDriver : public LoadCellDriver {
+public:
+    bool begin(uint8_t doutPin, uint8_t sckPin) override {
+        return true;
+    }
+
+    bool isReady() override {
+        return false;
+    }
+
+    long readRaw() override {
+        return 0;
+    }
+
+    const char* name() const override {
+        return "none";
+    }
+};
+
+LoadCellDriver& hardwareLoadCellDriver(uint8_t index) {
+    static NoLoadCellDriver driver;
+    return driver;
+}
+
+// Nor a pulse input
+class NoPulseCounter : public PulseCounter {
+public:
+    bool begin(uint8_t pin) override {
+        return true;
+    }
+
+    uint32_t takeCount() override {
+        return 0;
+    }
+
+    const char* name() const override {
+        return "none";
+    }
+};
+
+PulseCounter& hardwarePulseCounter() {
+    static NoPulseCounter counter;
+    return counter;
+}
+
+bool truncateFile(const char* path, size_t size) {
+    String hostPath = nativeFsRoot() + path;
+    return truncate(hostPath.c_str(), size) == 0;
+}
+
+// 10 ns ticks of the real (unscaled) clock, so traces show actual host cost
+uint32_t cycleCount() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() / 10);
+}
+
+uint32_t cyclesPerMicrosecond() {
+    return 100;
+}
+
+// The host heap is not the device's; report nothing rather than misleading numbers
+HeapInfo heapInfo() {
+    return HeapInfo{0, 0, 0, 0, 0};
+}
+
+void* largeAlloc(size_t size) {
+    return malloc(size);
+}
+
+void* largeRealloc(void* ptr, size_t size) {
+    return realloc(ptr, size);
+}
+
+void largeFree(void* ptr) {
+    free(ptr);
+}
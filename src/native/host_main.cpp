@@ -0,0 +1,236 @@
+// src/native/host_main.cpp - entry point of the [env:native] host build
+//
+// Mounts a host directory as LittleFS and drives the same modules as the
+// firmware loop (web server, jobs, sampler) without any hardware attached.
+//
+//   .pio/build/native/program [--fs DIR] [--seconds N] [--speed X] [--trigger G] [--stream]
+//                             [--udp HOST[:PORT]] [--stand NAME] [--http PORT] [simulator options]
+//
+// --trigger G arms the thrust trigger (run_trigger.h) at G grams instead of
+// starting a run right away. --stream turns on the binary sample stream
+// (serial_stream.h); Serial is stderr here, so 2>capture.bin records it for
+// tools/serial_receiver --file. --udp sends the run's samples to a
+// tools/udp_collector (udp_stream.h), as stand NAME if --stand is given, so
+// the host build stands in for a device on the network. --http also serves
+// the web API on 127.0.0.1:PORT for HTTP clients such as tools/sync_client.
+//
+// Simulator options (see sim_load_cell.h) switch the load cell to the
+// simulated driver: --sim step|decay|replay, --replay FILE, --amplitude G,
+// --delay MS, --duration MS, --tau MS, --noise G, --hum G, --hum-hz HZ,
+// --drift G_PER_MIN, --dropout FRACTION, --sps N, --repeat, --seed N;
+// --channels also logs the simulated torque and RPM channels
+//
+//   .pio/build/native/program bench [options]   (see benchmark.h)
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "native_hal.h"
+#include "config.h"
+#include "load_cell.h"
+#include "run_manager.h"
+#include "data_logger.h"
+#include "run_compression.h"
+#include "storage_manager.h"
+#include "run_journal.h"
+#include "web_server.h"
+#include "job_scheduler.h"
+#include "sampler.h"
+#include "run_trigger.h"
+#include "zero_tracker.h"
+#include "channels.h"
+#include "serial_stream.h"
+#include "udp_stream.h"
+#include "stream_protocol.h"
+#include "sim_load_cell.h"
+#include "benchmark.h"
+#include "trace.h"
+#include "metrics.h"
+
+static void printUsage() {
+    fprintf(stderr, "usage: program [--fs DIR] [--seconds N] [--speed X] [--trigger G] [--stream] [--udp HOST[:PORT]]\n"
+                    "               [--stand NAME] [--http PORT] [--sim step|decay|replay]\n"
+                    "               [--replay FILE] [--amplitude G] [--delay MS] [--duration MS] [--tau MS] [--noise G]\n"
+                    "               [--hum G] [--hum-hz HZ] [--drift G_PER_MIN] [--dropout FRACTION] [--sps N] [--repeat]\n"
+                    "               [--seed N] [--channels]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && String(argv[1]) == "bench") {
+        return runBenchmark(argc - 1, argv + 1);
+    }
+
+    String fsRoot = "native_fs";
+    unsigned long seconds = 5;
+    float speed = 1.0;
+    bool simulate = false;
+    float triggerGrams = -1;   // < 0: start a run right away
+    bool extraChannels = false;
+    bool stream = false;
+    UdpStreamConfig udpStream = {false, "", STREAM_UDP_PORT, UDP_DEFAULT_STAND};
+    SimLoadCellConfig sim = defaultSimLoadCellConfig();
+
+    for (int i = 1; i < argc; i++) {
+        String option = argv[i];
+        String value = (i + 1 < argc) ? argv[i + 1] : "";
+        bool hasValue = i + 1 < argc;
+        bool simOption = true;
+
+        if (option == "--fs" && hasValue) {
+            fsRoot = argv[++i];
+            simOption = false;
+        } else if (option == "--seconds" && hasValue) {
+            seconds = String(argv[++i]).toInt();
+            simOption = false;
+        } else if (option == "--stream") {
+            stream = true;
+            simOption = false;
+        } else if (option == "--udp" && hasValue) {
+            String target = argv[++i];
+            int colon = target.lastIndexOf(':');
+            udpStream.enabled = true;
+            udpStream.host = colon >= 0 ? target.substring(0, colon) : target;
+            udpStream.port = colon >= 0 ? target.substring(colon + 1).toInt() : STREAM_UDP_PORT;
+            simOption = false;
+        } else if (option == "--http" && hasValue) {
+            nativeSetHttpPort(String(argv[++i]).toInt());
+            simOption = false;
+        } else if (option == "--stand" && hasValue) {
+            udpStream.stand = argv[++i];
+            simOption = false;
+        } else if (option == "--speed" && hasValue) {
+            speed = String(argv[++i]).toFloat();
+            simOption = false;
+        } else if (option == "--sim" && hasValue && parseSimCurve(value, sim.curve)) {
+            i++;
+        } else if (option == "--replay" && hasValue) {
+            sim.curve = SIM_CURVE_REPLAY;
+            sim.replayFile = argv[++i];
+        } else if (option == "--amplitude" && hasValue) {
+            sim.amplitude = String(argv[++i]).toFloat();
+        } else if (option == "--delay" && hasValue) {
+            sim.delayMs = String(argv[++i]).toInt();
+        } else if (option == "--duration" && hasValue) {
+            sim.durationMs = String(argv[++i]).toInt();
+        } else if (option == "--tau" && hasValue) {
+            sim.decayTauMs = String(argv[++i]).toFloat();
+        } else if (option == "--noise" && hasValue) {
+            sim.noiseGrams = String(argv[++i]).toFloat();
+        } else if (option == "--hum" && hasValue) {
+            sim.humGrams = String(argv[++i]).toFloat();
+        } else if (option == "--hum-hz" && hasValue) {
+            sim.humHz = String(argv[++i]).toFloat();
+        } else if (option == "--channels") {
+            extraChannels = true;
+        } else if (option == "--drift" && hasValue) {
+            sim.driftGramsPerMin = String(argv[++i]).toFloat();
+        } else if (option == "--dropout" && hasValue) {
+            sim.dropoutRate = String(argv[++i]).toFloat();
+        } else if (option == "--sps" && hasValue) {
+            sim.samplesPerSecond = String(argv[++i]).toInt();
+        } else if (option == "--repeat") {
+            sim.repeat = true;
+        } else if (option == "--seed" && hasValue) {
+            sim.seed = String(argv[++i]).toInt();
+        } else if (option == "--trigger" && hasValue) {
+            triggerGrams = String(argv[++i]).toFloat();
+            simOption = false;
+        } else {
+            printUsage();
+            return 1;
+        }
+        simulate = simulate || simOption;
+    }
+
+    nativeSetFsRoot(fsRoot);
+    if (!LittleFS.begin(true)) {
+        Serial.println("ERROR: cannot use " + fsRoot + " as the filesystem root");
+        return 1;
+    }
+
+    nativeSetClockRate(speed);
+
+    if (simulate) {
+        if (!configureSimLoadCell(sim)) {
+            Serial.println("ERROR: invalid simulator settings");
+            return 1;
+        }
+        setLoadCellDriver(simLoadCellDriver());
+    } else if (!initLoadCell(HX711_DOUT_PIN, HX711_SCK_PIN)) {
+        Serial.println("WARNING: Load cell initialization failed");
+    }
+    initChannels();
+    if (simulate) {
+        ChannelConfig channels = getChannelConfig();
+        channels.torqueEnabled = extraChannels;
+        channels.rpmEnabled = extraChannels;
+        setChannelConfig(channels);
+        setChannelSources(simTorqueDriver(), simPulseCounter());
+    }
+    if (!initDataLogger() || !initStorageManager() || !initRunManager() || !initWebServer()) {
+        Serial.println("ERROR: initialization failed");
+        return 1;
+    }
+    initRunJournal();
+    initRunCompression();
+    scheduleStorageCleanup();
+    initRunTrigger();
+    initSerialStream();
+    setSerialStreaming(stream);
+    initUdpStream();
+    if (!setUdpStreamConfig(udpStream)) {
+        Serial.println("ERROR: invalid UDP stream settings");
+        return 1;
+    }
+    metricMark(METRIC_BOOT_READY);
+
+    String runName = "native";
+    if (triggerGrams >= 0) {
+        RunTriggerConfig trigger = getRunTriggerConfig();
+        trigger.startThreshold = triggerGrams;
+        setRunTriggerConfig(trigger);
+        armRunTrigger();
+        runName = trigger.runName;
+    } else {
+        createRunConfig(runName, "Host build run");
+        startRun(runName);
+    }
+
+    unsigned long start = millis();
+    while (millis() - start < seconds * 1000) {
+        TRACE_SCOPE("loop");
+        unsigned long loopStart = micros();
+        {
+            TRACE_SCOPE("http");
+            handleWebServer();
+        }
+        {
+            TRACE_SCOPE("jobs");
+            handleJobs();
+        }
+        handleSerialStream();
+        handleUdpStream();
+        handleRunTrigger();
+        {
+            TRACE_SCOPE("sampler");
+            handleSampler();
+        }
+        handleStorage();
+        handleRunJournal();
+        handleZeroTracker();
+        metricObserve(METRIC_LOOP_US, micros() - loopStart);
+        delay(1);
+    }
+
+    if (isRunActive()) {
+        stopRun();
+    }
+    handleSerialStream();
+    handleUdpStream();
+
+    // Let queued maintenance (summaries, deletes) finish
+    while (getJobsStatus().indexOf("\"queued\"") >= 0 || getJobsStatus().indexOf("\"running\"") >= 0) {
+        handleJobs();
+    }
+
+    printf("%s\n", getRunDataFiles(runName).c_str());
+    return 0;
+}
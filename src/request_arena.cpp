@@ -0,0 +1,160 @@
+// src/request_arena.cpp
+#include "request_arena.h"
+#include "config.h"
+#include "hal.h"
+
+// Every block carries its size so reallocate() can copy without asking the caller
+struct BlockHeader {
+    size_t size;
+    size_t padding;   // Keeps the payload 8-byte aligned on 32-bit targets
+};
+
+struct ArenaChunk {
+    ArenaChunk* next;   // Older chunk
+    size_t capacity;
+    size_t used;
+    size_t padding;
+};
+
+static ArenaChunk* chunks = nullptr;   // Newest first; only the newest is bumped
+static BlockHeader* lastBlock = nullptr;
+static int scopeDepth = 0;
+static size_t chunkBytes = 0;
+static size_t peakBytes = 0;
+static uint32_t requestsUsingArena = 0;
+
+static size_t aligned(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static char* chunkData(ArenaChunk* chunk) {
+    return (char*)(chunk + 1);
+}
+
+static void* blockData(BlockHeader* block) {
+    return block + 1;
+}
+
+static BlockHeader* blockOf(void* ptr) {
+    return (BlockHeader*)ptr - 1;
+}
+
+static void releaseArena() {
+    if (chunks) requestsUsingArena++;
+    while (chunks) {
+        ArenaChunk* next = chunks->next;
+        largeFree(chunks);
+        chunks = next;
+    }
+    lastBlock = nullptr;
+    chunkBytes = 0;
+}
+
+void* arenaAlloc(size_t size) {
+    if (scopeDepth == 0) return nullptr;
+
+    size_t needed = sizeof(BlockHeader) + aligned(size);
+    if (!chunks || chunks->used + needed > chunks->capacity) {
+        // Oversized blocks get a chunk of their own
+        size_t capacity = needed > REQUEST_ARENA_CHUNK ? needed : REQUEST_ARENA_CHUNK;
+        ArenaChunk* chunk = (ArenaChunk*)largeAlloc(sizeof(ArenaChunk) + capacity);
+        if (!chunk) return nullptr;
+        chunk->next = chunks;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        chunks = chunk;
+        chunkBytes += capacity;
+        if (chunkBytes > peakBytes) peakBytes = chunkBytes;
+    }
+
+    BlockHeader* block = (BlockHeader*)(chunkData(chunks) + chunks->used);
+    block->size = size;
+    chunks->used += needed;
+    lastBlock = block;
+    return blockData(block);
+}
+
+// The newest block can grow or shrink in place; anything else is copied
+static void* arenaRealloc(void* ptr, size_t size) {
+    if (!ptr) return arenaAlloc(size);
+
+    BlockHeader* block = blockOf(ptr);
+    if (block == lastBlock) {
+        size_t start = (char*)block - chunkData(chunks);
+        size_t needed = sizeof(BlockHeader) + aligned(size);
+        if (start + needed <= chunks->capacity) {
+            chunks->used = start + needed;
+            block->size = size;
+            return ptr;
+        }
+    }
+
+    void* moved = arenaAlloc(size);
+    if (moved) memcpy(moved, ptr, block->size < size ? block->size : size);
+    return moved;
+}
+
+// Only the newest block is worth taking back before the scope ends
+static void arenaFree(void* ptr) {
+    if (!ptr || blockOf(ptr) != lastBlock) return;
+    chunks->used = (char*)lastBlock - chunkData(chunks);
+    lastBlock = nullptr;
+}
+
+class PsramAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        return largeAlloc(size);
+    }
+
+    void deallocate(void* ptr) override {
+        largeFree(ptr);
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        return largeRealloc(ptr, newSize);
+    }
+};
+
+class ArenaAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        return arenaAlloc(size);
+    }
+
+    void deallocate(void* ptr) override {
+        arenaFree(ptr);
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        return arenaRealloc(ptr, newSize);
+    }
+};
+
+ArduinoJson::Allocator* psramAllocator() {
+    static PsramAllocator allocator;
+    return &allocator;
+}
+
+ArduinoJson::Allocator* arenaAllocator() {
+    static ArenaAllocator allocator;
+    return scopeDepth > 0 ? (ArduinoJson::Allocator*)&allocator : psramAllocator();
+}
+
+RequestArenaScope::RequestArenaScope() {
+    scopeDepth++;
+}
+
+RequestArenaScope::~RequestArenaScope() {
+    if (--scopeDepth == 0) {
+        releaseArena();
+    }
+}
+
+ArenaStats arenaStats() {
+    ArenaStats stats;
+    stats.chunkBytes = chunkBytes;
+    stats.peakBytes = peakBytes;
+    stats.requests = requestsUsingArena;
+    return stats;
+}
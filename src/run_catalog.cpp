@@ -0,0 +1,602 @@
+// src/run_catalog.cpp
+#include "run_catalog.h"
+#include "run_manager.h"
+#include "config.h"
+#include "job_scheduler.h"
+#include "storage_manager.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <deque>
+
+#define CATALOG_MAGIC 0x36435054  // "TPC6"
+
+static std::vector<RunListing> runs;
+static std::vector<CatalogTombstone> tombstones;
+static CatalogSyncState syncState = {0, 0, 0};
+static int batchDepth = 0;        // Open catalogBeginBatch() calls
+static bool snapshotDirty = false;  // Changed since the snapshot was written, during a batch
+static uint32_t changeCount = 0;  // Catalog changes since boot, so a rebuild can tell it missed some
+static std::deque<String> pendingStats;  // Files waiting for the summary job
+
+// Snapshot helpers - all integers little endian, strings are u16 length + bytes
+static void writeU32(File& f, uint32_t v) { f.write((const uint8_t*)&v, 4); }
+static void writeU16(File& f, uint16_t v) { f.write((const uint8_t*)&v, 2); }
+static void writeStr(File& f, const String& s) {
+    writeU16(f, s.length());
+    f.write((const uint8_t*)s.c_str(), s.length());
+}
+
+static bool readU32(File& f, uint32_t& v) { return f.read((uint8_t*)&v, 4) == 4; }
+static bool readU16(File& f, uint16_t& v) { return f.read((uint8_t*)&v, 2) == 2; }
+static bool readStr(File& f, String& s) {
+    uint16_t len;
+    if (!readU16(f, len)) return false;
+    std::vector<char> buffer(len + 1, '\0');
+    if (f.read((uint8_t*)buffer.data(), len) != len) return false;
+    s = buffer.data();
+    return true;
+}
+
+static void writeSnapshot() {
+    snapshotDirty = false;
+    String tmpPath = String(CATALOG_FILE) + ".tmp";
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file) {
+        Serial.println("Failed to write catalog snapshot");
+        return;
+    }
+
+    writeU32(file, CATALOG_MAGIC);
+    writeU32(file, syncState.epoch);
+    writeU32(file, syncState.cursor);
+    writeU32(file, syncState.horizon);
+    writeU16(file, runs.size());
+    for (const RunListing& run : runs) {
+        writeStr(file, run.name);
+        writeStr(file, run.notes);
+        writeStr(file, run.created);
+        writeU32(file, run.changed);
+        file.write((uint8_t)run.starred);
+        writeU16(file, run.files.size());
+        for (const RunFileInfo& f : run.files) {
+            writeStr(file, f.name);
+            writeU32(file, f.size);
+            writeU32(file, f.stats.samples);
+            writeU32(file, f.stats.durationMs);
+            file.write((const uint8_t*)&f.stats.peakThrust, sizeof(float));
+            file.write((uint8_t)f.hasStats);
+            writeU32(file, f.changed);
+            writeU32(file, f.storedSize);
+            file.write((uint8_t)f.storage);
+            file.write((uint8_t)f.recovered);
+        }
+    }
+    writeU16(file, tombstones.size());
+    for (const CatalogTombstone& t : tombstones) {
+        writeStr(file, t.name);
+        file.write((uint8_t)t.isRun);
+        writeU32(file, t.changed);
+    }
+    storageNoteWrite(file.size());
+    file.close();
+
+    // Swap in the new snapshot only once it is completely written
+    LittleFS.remove(CATALOG_FILE);
+    LittleFS.rename(tmpPath, CATALOG_FILE);
+}
+
+// Write the snapshot now, or when the open batch is committed
+static void saveSnapshot() {
+    changeCount++;
+    if (batchDepth > 0) {
+        snapshotDirty = true;
+    } else {
+        writeSnapshot();
+    }
+}
+
+static bool loadSnapshot() {
+    File file = LittleFS.open(CATALOG_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic;
+    uint16_t runCount;
+    CatalogSyncState state;
+    bool ok = readU32(file, magic) && magic == CATALOG_MAGIC && readU32(file, state.epoch) &&
+              readU32(file, state.cursor) && readU32(file, state.horizon) && readU16(file, runCount);
+
+    std::vector<RunListing> loaded;
+    for (uint16_t i = 0; ok && i < runCount; i++) {
+        RunListing run;
+        uint16_t fileCount;
+        run.totalBytes = 0;
+        ok = readStr(file, run.name) && readStr(file, run.notes) &&
+             readStr(file, run.created) && readU32(file, run.changed) &&
+             file.read((uint8_t*)&run.starred, 1) == 1 && readU16(file, fileCount);
+
+        for (uint16_t j = 0; ok && j < fileCount; j++) {
+            RunFileInfo f;
+            uint32_t size, storedSize;
+            ok = readStr(file, f.name) && readU32(file, size) &&
+                 readU32(file, f.stats.samples) && readU32(file, f.stats.durationMs) &&
+                 file.read((uint8_t*)&f.stats.peakThrust, sizeof(float)) == sizeof(float) &&
+                 file.read((uint8_t*)&f.hasStats, 1) == 1 && readU32(file, f.changed) &&
+                 readU32(file, storedSize) && file.read((uint8_t*)&f.storage, 1) == 1 &&
+                 file.read((uint8_t*)&f.recovered, 1) == 1;
+            f.size = size;
+            f.storedSize = storedSize;
+            if (ok) {
+                run.totalBytes += f.size;
+                run.files.push_back(f);
+            }
+        }
+        if (ok) {
+            loaded.push_back(run);
+        }
+    }
+
+    uint16_t tombstoneCount;
+    std::vector<CatalogTombstone> loadedTombstones;
+    ok = ok && readU16(file, tombstoneCount);
+    for (uint16_t i = 0; ok && i < tombstoneCount; i++) {
+        CatalogTombstone t;
+        ok = readStr(file, t.name) && file.read((uint8_t*)&t.isRun, 1) == 1 && readU32(file, t.changed);
+        if (ok) {
+            loadedTombstones.push_back(t);
+        }
+    }
+    file.close();
+
+    if (!ok) {
+        Serial.println("Catalog snapshot is corrupt, ignoring it");
+        return false;
+    }
+
+    runs = loaded;
+    tombstones = loadedTombstones;
+    syncState = state;
+    return true;
+}
+
+static uint32_t nextChange() {
+    return ++syncState.cursor;
+}
+
+static void addTombstone(const String& name, bool isRun) {
+    tombstones.push_back(CatalogTombstone{name, isRun, nextChange()});
+    if (tombstones.size() > CATALOG_TOMBSTONES_MAX) {
+        // Clients that have not seen this removal can no longer be told about it
+        syncState.horizon = tombstones.front().changed;
+        tombstones.erase(tombstones.begin());
+    }
+}
+
+// Runs are keyed on disk by sanitized name, so match on that like the config lookup always has
+static RunListing* findRun(const String& runName) {
+    String sanitizedName = sanitizeFilename(runName);
+    for (RunListing& run : runs) {
+        if (run.name == runName || sanitizeFilename(run.name) == sanitizedName) return &run;
+    }
+    return nullptr;
+}
+
+// Data files are named "<sanitized run name>: <timestamp>.csv"
+static RunListing* findRunForFile(const String& fileName, std::vector<RunListing>& in = runs) {
+    int sep = fileName.indexOf(": ");
+    if (sep <= 0 || !fileName.endsWith(".csv")) return nullptr;
+
+    String prefix = fileName.substring(0, sep);
+    for (RunListing& run : in) {
+        if (sanitizeFilename(run.name) == prefix) return &run;
+    }
+    return nullptr;
+}
+
+static bool removeFileEntry(RunListing& run, const String& fileName) {
+    for (size_t i = 0; i < run.files.size(); i++) {
+        if (run.files[i].name == fileName) {
+            run.totalBytes -= run.files[i].size;
+            run.files.erase(run.files.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static RunFileInfo* findFileEntry(const String& fileName) {
+    RunListing* run = findRunForFile(fileName);
+    if (!run) return nullptr;
+    for (RunFileInfo& f : run->files) {
+        if (f.name == fileName) return &f;
+    }
+    return nullptr;
+}
+
+// The file the summary job is scanning, CATALOG_SUMMARY_STEP_BYTES per step
+struct SummaryTask {
+    String fileName;
+    uint32_t changed;     // Of its entry; if that changes meanwhile, the stats are stale
+    RunFileReader file;
+    DataFileStats stats;
+};
+
+static SummaryTask* summary = nullptr;
+
+static void discardSummary() {
+    summary->file.close();
+    delete summary;
+    summary = nullptr;
+}
+
+static bool summaryStep(JobStatus& status) {
+    if (!summary) {
+        RunFileInfo* next = nullptr;
+        while (!next && !pendingStats.empty()) {
+            next = findFileEntry(pendingStats.front());
+            pendingStats.pop_front();
+            if (next && next->hasStats) next = nullptr;
+        }
+        if (!next) {
+            saveSnapshot();
+            return false;
+        }
+
+        summary = new SummaryTask();
+        summary->fileName = next->name;
+        summary->changed = next->changed;
+        summary->stats = {0, 0, 0.0};
+        summary->file.open(runFilePath(next->name).c_str());
+        status.total = status.done + pendingStats.size() + 1;
+        status.message = next->name;
+        return true;
+    }
+
+    // An unreadable file gets empty stats rather than being retried forever
+    if (summary->file && scanDataFileRows(summary->file, CATALOG_SUMMARY_STEP_BYTES, summary->stats)) {
+        return true;
+    }
+    RunFileInfo* f = findFileEntry(summary->fileName);
+    if (f && f->changed == summary->changed) {
+        f->stats = summary->stats;
+        f->hasStats = true;
+    }
+    status.done++;
+    discardSummary();
+    return true;
+}
+
+// Fill in missing file stats in the background
+static void queueSummary(const String& fileName) {
+    pendingStats.push_back(fileName);
+    if (isJobPending("catalog-summaries")) return;
+
+    // A cancelled job leaves its file half scanned
+    if (summary) {
+        discardSummary();
+    }
+    scheduleJob("catalog-summaries", JOB_PRIORITY_LOW, summaryStep);
+}
+
+// A rebuild in progress: the runs found so far, and where the walk through
+// CONFIGS_DIR and then RUNS_DIR has got to. It replaces the catalog only
+// once complete, so listings stay whole meanwhile.
+struct CatalogRebuild {
+    std::vector<RunListing> runs;
+    File dir;
+    bool scanningRuns;
+    uint32_t changes;     // changeCount when the walk started
+    unsigned long startMs;
+};
+
+static CatalogRebuild* rebuild = nullptr;
+static int rebuildJobId = 0;
+
+static void startRebuild() {
+    if (rebuild) {
+        rebuild->dir.close();
+        delete rebuild;
+    }
+    rebuild = new CatalogRebuild();
+    rebuild->dir = LittleFS.open(CONFIGS_DIR);
+    rebuild->scanningRuns = false;
+    rebuild->changes = changeCount;
+    rebuild->startMs = millis();
+}
+
+static void addConfig(File& file) {
+    if (file.isDirectory() || !String(file.name()).endsWith(".json")) return;
+
+    JsonDocument configDoc;
+    DeserializationError error = deserializeJson(configDoc, file);
+    if (error) return;
+
+    RunListing run;
+    run.name = configDoc["name"].as<String>();
+    run.notes = configDoc["notes"].as<String>();
+    run.created = configDoc["created"].as<String>();
+    run.starred = configDoc["starred"] | false;
+    run.totalBytes = 0;
+    run.changed = 1;
+    rebuild->runs.push_back(run);
+}
+
+static void addDataFile(File& file) {
+    String fileName = String(file.name());
+    RunListing* run = file.isDirectory() ? nullptr : findRunForFile(fileName, rebuild->runs);
+    if (!run) return;
+
+    // Compressed files carry their CSV size in their header
+    RunFileReader reader;
+    reader.open(file);
+    RunFileInfo info;
+    info.name = fileName;
+    info.size = reader.size();
+    info.storedSize = reader.storedSize();
+    info.storage = reader.isCompressed() ? STORAGE_COMPRESSED : STORAGE_RAW;
+    info.stats = {0, 0, 0.0};
+    info.hasStats = false;
+    info.changed = 1;
+    run->files.push_back(info);
+    run->totalBytes += info.size;
+}
+
+static void finishRebuild() {
+    // Timestamps are "%y-%m-%d_%T", so name order is date order
+    for (RunListing& run : rebuild->runs) {
+        std::sort(run.files.begin(), run.files.end(), [](const RunFileInfo& a, const RunFileInfo& b) {
+            return a.name < b.name;
+        });
+    }
+
+    runs.swap(rebuild->runs);
+    unsigned long elapsed = millis() - rebuild->startMs;
+    delete rebuild;
+    rebuild = nullptr;
+
+    // Replicas cannot tell what changed across a rebuild; a new epoch has them compare listings
+    tombstones.clear();
+    syncState = CatalogSyncState{esp_random(), 1, 0};
+    saveSnapshot();
+
+    pendingStats.clear();
+    if (summary) {
+        discardSummary();
+    }
+    for (const RunListing& run : runs) {
+        for (const RunFileInfo& f : run.files) {
+            queueSummary(f.name);
+        }
+    }
+    Serial.println("Run catalog rebuilt: " + String(runs.size()) + " runs in " + String(elapsed) + "ms");
+}
+
+// Walk CATALOG_REBUILD_STEP_FILES directory entries; true while there is more to do
+static bool rebuildStep(JobStatus& status) {
+    if (!rebuild) {
+        startRebuild();
+    }
+
+    for (int i = 0; i < CATALOG_REBUILD_STEP_FILES; i++) {
+        File file;
+        if (rebuild->dir && rebuild->dir.isDirectory()) {
+            file = rebuild->dir.openNextFile();
+        }
+        if (file) {
+            if (rebuild->scanningRuns) {
+                addDataFile(file);
+            } else {
+                addConfig(file);
+            }
+            status.done++;
+            continue;
+        }
+
+        rebuild->dir.close();
+        if (!rebuild->scanningRuns) {
+            rebuild->dir = LittleFS.open(RUNS_DIR);
+            rebuild->scanningRuns = true;
+            continue;
+        }
+
+        // What was walked already may be out of date; walk again
+        if (changeCount != rebuild->changes) {
+            startRebuild();
+            return true;
+        }
+        finishRebuild();
+        return false;
+    }
+    return true;
+}
+
+bool initRunCatalog() {
+    if (loadSnapshot()) {
+        Serial.println("Run catalog loaded: " + String(runs.size()) + " runs");
+
+        for (const RunListing& run : runs) {
+            for (const RunFileInfo& f : run.files) {
+                if (!f.hasStats) queueSummary(f.name);
+            }
+        }
+        return true;
+    }
+
+    rebuildRunCatalog();
+    return true;
+}
+
+void rebuildRunCatalog() {
+    JobStatus status = {};
+    startRebuild();
+    while (rebuildStep(status)) {
+        yield();
+    }
+}
+
+int scheduleCatalogRebuild() {
+    // A rebuild already under way starts over, so it sees this change too
+    startRebuild();
+    if (!isJobPending("catalog-rebuild")) {
+        rebuildJobId = scheduleJob("catalog-rebuild", JOB_PRIORITY_HIGH, rebuildStep);
+    }
+    return rebuildJobId;
+}
+
+const std::vector<RunListing>& catalogRuns() {
+    return runs;
+}
+
+const RunListing* catalogFindRun(const String& runName) {
+    return findRun(runName);
+}
+
+void catalogPutRun(const String& name, const String& notes, const String& created) {
+    RunListing* run = findRun(name);
+    if (!run) {
+        runs.push_back(RunListing());
+        run = &runs.back();
+        run->name = name;
+        run->totalBytes = 0;
+    }
+    run->notes = notes;
+    run->created = created;
+    run->changed = nextChange();
+    saveSnapshot();
+}
+
+void catalogSetNotes(const String& runName, const String& notes) {
+    RunListing* run = findRun(runName);
+    if (run) {
+        run->notes = notes;
+        run->changed = nextChange();
+        saveSnapshot();
+    }
+}
+
+void catalogSetStarred(const String& runName, bool starred) {
+    RunListing* run = findRun(runName);
+    if (run) {
+        run->starred = starred;
+        run->changed = nextChange();
+        saveSnapshot();
+    }
+}
+
+void catalogRemoveRun(const String& runName) {
+    RunListing* run = findRun(runName);
+    if (run) {
+        for (const RunFileInfo& f : run->files) {
+            addTombstone(f.name, false);
+        }
+        addTombstone(run->name, true);
+        runs.erase(runs.begin() + (run - runs.data()));
+        saveSnapshot();
+    }
+}
+
+void catalogPutFile(const String& fileName, const RunFileInfo& info) {
+    RunListing* run = findRunForFile(fileName);
+    if (!run) return;
+
+    removeFileEntry(*run, fileName);
+
+    RunFileInfo entry = info;
+    entry.name = fileName;
+    entry.changed = nextChange();
+    if (entry.storedSize == 0) {
+        entry.storedSize = entry.size;
+    }
+
+    // Keep files in name (= date) order
+    size_t pos = 0;
+    while (pos < run->files.size() && run->files[pos].name < fileName) pos++;
+    run->files.insert(run->files.begin() + pos, entry);
+    run->totalBytes += entry.size;
+    saveSnapshot();
+    if (!entry.hasStats) {
+        queueSummary(fileName);
+    }
+}
+
+void catalogRemoveFile(const String& fileName) {
+    RunListing* run = findRunForFile(fileName);
+    if (run && removeFileEntry(*run, fileName)) {
+        addTombstone(fileName, false);
+        saveSnapshot();
+    }
+}
+
+const RunFileInfo* catalogFindFile(const String& fileName) {
+    RunListing* run = findRunForFile(fileName);
+    if (!run) return nullptr;
+    for (const RunFileInfo& f : run->files) {
+        if (f.name == fileName) return &f;
+    }
+    return nullptr;
+}
+
+void catalogSetStorage(const String& fileName, size_t storedSize, RunFileStorage storage) {
+    RunListing* run = findRunForFile(fileName);
+    if (!run) return;
+    for (RunFileInfo& f : run->files) {
+        if (f.name == fileName) {
+            f.storedSize = storedSize;
+            f.storage = storage;
+            saveSnapshot();
+            return;
+        }
+    }
+}
+
+void catalogPathChanged(const String& path) {
+    String runsPrefix = String(RUNS_DIR) + "/";
+    String configsPrefix = String(CONFIGS_DIR) + "/";
+
+    if (path.startsWith(runsPrefix)) {
+        // Data file removed or renamed away - recreate its entry if it still exists
+        String fileName = path.substring(runsPrefix.length());
+        if (LittleFS.exists(path)) {
+            RunFileReader reader(path.c_str());
+            RunFileInfo info;
+            info.name = fileName;
+            info.size = reader.size();
+            info.storedSize = reader.storedSize();
+            info.storage = reader.isCompressed() ? STORAGE_COMPRESSED : STORAGE_RAW;
+            info.stats = {0, 0, 0.0};
+            info.hasStats = false;
+            catalogPutFile(fileName, info);
+            scheduleRunCompression();
+        } else {
+            catalogRemoveFile(fileName);
+        }
+    } else if (path.startsWith(configsPrefix) && !LittleFS.exists(path)) {
+        // Config removed - drop the run it described
+        String sanitizedName = path.substring(configsPrefix.length());
+        sanitizedName.replace(".json", "");
+        catalogRemoveRun(sanitizedName);
+    } else if (path.startsWith(configsPrefix) || path == DATA_DIR || path == RUNS_DIR) {
+        // Config files appearing or whole directories touched by hand - just start over
+        scheduleCatalogRebuild();
+    }
+}
+
+void catalogBeginBatch() {
+    batchDepth++;
+}
+
+void catalogCommit() {
+    if (batchDepth > 0 && --batchDepth == 0 && snapshotDirty) {
+        writeSnapshot();
+    }
+}
+
+CatalogSyncState catalogSyncState() {
+    return syncState;
+}
+
+const std::vector<CatalogTombstone>& catalogTombstones() {
+    return tombstones;
+}
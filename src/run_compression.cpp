@@ -0,0 +1,495 @@
+// src/run_compression.cpp
+#include "run_compression.h"
+#include "run_catalog.h"
+#include "run_manager.h"
+#include "job_scheduler.h"
+#include "zip_stream.h"
+#include "storage_manager.h"
+#include "config.h"
+#include <LittleFS.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#define WINDOW_MASK (RUN_FILE_WINDOW - 1)
+#define MIN_MATCH 3
+#define MAX_MATCH 34                        // 5-bit length field
+#define MAX_DISTANCE (RUN_FILE_WINDOW - 1)  // Matches never reach a position the chain has reused
+#define HASH_BITS 10
+#define MAX_CHAIN 16                        // Candidates tried per position
+#define INPUT_BUFFER (2 * RUN_FILE_WINDOW)
+
+// --- Reading ---
+
+bool RunFileReader::open(const char* path) {
+    return open(LittleFS.open(path, "r"));
+}
+
+bool RunFileReader::open(File newFile) {
+    close();
+    file = newFile;
+    if (!file || file.isDirectory()) {
+        return (bool)file;
+    }
+
+    uint32_t header[3];
+    rawSize = file.size();
+    if (file.size() >= RUN_FILE_HEADER_SIZE && file.read((uint8_t*)header, RUN_FILE_HEADER_SIZE) == RUN_FILE_HEADER_SIZE &&
+        header[0] == RUN_FILE_MAGIC) {
+        compressed = true;
+        rawSize = header[1];
+        crc = header[2];
+        window.reset(new uint8_t[RUN_FILE_WINDOW]);
+    }
+    restart();
+    return true;
+}
+
+void RunFileReader::close() {
+    file.close();
+    window.reset();
+    compressed = false;
+    rawSize = 0;
+    pos = 0;
+    crc = 0;
+    peeked = -1;
+}
+
+void RunFileReader::restart() {
+    file.seek(compressed ? RUN_FILE_HEADER_SIZE : 0);
+    pos = 0;
+    peeked = -1;
+    windowPos = 0;
+    matchRemaining = 0;
+    flagBits = 0;
+    inputPos = 0;
+    inputLength = 0;
+    if (window) {
+        memset(window.get(), 0, RUN_FILE_WINDOW);
+    }
+}
+
+bool RunFileReader::seek(size_t position) {
+    if (!compressed) {
+        if (!file.seek(position)) return false;
+        pos = position;
+        peeked = -1;
+        return true;
+    }
+    if (position < pos || peeked >= 0) {
+        restart();
+    }
+    while (pos < position) {
+        if (decode() < 0) return false;
+    }
+    return true;
+}
+
+int RunFileReader::nextInput() {
+    if (inputPos == inputLength) {
+        inputLength = file.read(input, sizeof(input));
+        inputPos = 0;
+        if (inputLength == 0) return -1;
+    }
+    return input[inputPos++];
+}
+
+// The tokens ran out before the size in the header was reached
+int RunFileReader::truncated() {
+    Serial.printf("Compressed run file is truncated: %s\n", file.path());
+    rawSize = pos;
+    return -1;
+}
+
+int RunFileReader::decode() {
+    if (pos >= rawSize) {
+        return -1;
+    }
+    if (!compressed) {
+        int c = file.read();
+        if (c < 0) return truncated();
+        pos++;
+        return c;
+    }
+
+    if (matchRemaining == 0) {
+        if (flagBits == 0) {
+            int f = nextInput();
+            if (f < 0) return truncated();
+            flags = f;
+            flagBits = 8;
+        }
+        bool isMatch = flags & 1;
+        flags >>= 1;
+        flagBits--;
+
+        if (!isMatch) {
+            int c = nextInput();
+            if (c < 0) return truncated();
+            window[windowPos++ & WINDOW_MASK] = c;
+            pos++;
+            return c;
+        }
+        int low = nextInput();
+        int high = nextInput();
+        if (high < 0) return truncated();
+        uint16_t token = low | (high << 8);
+        matchDistance = (token >> 5) + 1;
+        matchRemaining = (token & 31) + MIN_MATCH;
+    }
+
+    // Byte by byte, so a match may overlap the bytes it is producing
+    uint8_t c = window[(uint16_t)(windowPos - matchDistance) & WINDOW_MASK];
+    window[windowPos++ & WINDOW_MASK] = c;
+    matchRemaining--;
+    pos++;
+    return c;
+}
+
+int RunFileReader::read() {
+    if (peeked >= 0) {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    return decode();
+}
+
+int RunFileReader::peek() {
+    if (peeked < 0) {
+        peeked = decode();
+    }
+    return peeked;
+}
+
+size_t RunFileReader::read(uint8_t* buffer, size_t length) {
+    size_t n = 0;
+    if (peeked >= 0 && length > 0) {
+        buffer[n++] = peeked;
+        peeked = -1;
+    }
+    if (!compressed) {
+        size_t wanted = min(length - n, rawSize - pos);
+        size_t got = file.read(buffer + n, wanted);
+        pos += got;
+        return n + got;
+    }
+    while (n < length) {
+        int c = decode();
+        if (c < 0) break;
+        buffer[n++] = c;
+    }
+    return n;
+}
+
+// --- Compressing ---
+
+// One file being compressed, a step at a time: encode into COMPRESS_TMP_FILE,
+// then read that back and check it against the CRC of the original before it
+// replaces the file. About 14 KB, allocated only while the job runs.
+struct CompressionTask {
+    String fileName;
+    File source;
+    File target;
+    uint32_t rawSize;
+    uint32_t consumed;      // Bytes read from the source
+    uint32_t crc;           // ...and their CRC-32
+    uint32_t storedSize;
+    bool verifying;
+    RunFileReader check;
+    uint32_t checkCrc;
+
+    // Source bytes from bufferStart on: up to a window of history, then what is still to be coded
+    uint8_t buffer[INPUT_BUFFER];
+    uint32_t bufferStart;
+    uint16_t bufferLength;
+    uint16_t next;          // Index of the next byte to code
+    int32_t head[1 << HASH_BITS];     // Latest position of each hash, -1 = none
+    uint16_t chain[RUN_FILE_WINDOW];  // Distance back to the previous position with the same hash, 0 = none
+
+    uint8_t group[1 + 8 * 2];         // Flag byte and up to 8 items
+    uint8_t groupLength;
+    uint8_t groupItems;
+};
+
+static CompressionTask* task = nullptr;
+static std::vector<String> attempted;   // Files this job has already been through
+
+static uint32_t hash3(const uint8_t* p) {
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void insertPosition(CompressionTask& t, uint16_t index) {
+    if (index + MIN_MATCH > t.bufferLength) return;
+    uint32_t position = t.bufferStart + index;
+    uint32_t h = hash3(t.buffer + index);
+    int32_t previous = t.head[h];
+    t.chain[position & WINDOW_MASK] = previous >= 0 && position - previous <= MAX_DISTANCE ? position - previous : 0;
+    t.head[h] = position;
+}
+
+static uint16_t longestMatch(CompressionTask& t, uint16_t& distance) {
+    uint16_t limit = min(t.bufferLength - t.next, MAX_MATCH);
+    if (limit < MIN_MATCH) return 0;
+
+    uint32_t position = t.bufferStart + t.next;
+    const uint8_t* current = t.buffer + t.next;
+    int32_t candidate = t.head[hash3(current)];
+    uint16_t best = 0;
+    for (int tries = 0; tries < MAX_CHAIN && candidate >= 0; tries++) {
+        uint32_t back = position - candidate;
+        if (back == 0 || back > MAX_DISTANCE) break;
+
+        const uint8_t* earlier = current - back;
+        uint16_t length = 0;
+        while (length < limit && earlier[length] == current[length]) length++;
+        if (length > best) {
+            best = length;
+            distance = back;
+            if (length == limit) break;
+        }
+
+        uint16_t step = t.chain[candidate & WINDOW_MASK];
+        if (step == 0) break;
+        candidate -= step;
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+static void flushGroup(CompressionTask& t) {
+    if (t.groupItems == 0) return;
+    t.target.write(t.group, t.groupLength);
+    t.storedSize += t.groupLength;
+    t.groupItems = 0;
+}
+
+static void emitLiteral(CompressionTask& t, uint8_t c) {
+    if (t.groupItems == 0) {
+        t.group[0] = 0;
+        t.groupLength = 1;
+    }
+    t.group[t.groupLength++] = c;
+    if (++t.groupItems == 8) flushGroup(t);
+}
+
+static void emitMatch(CompressionTask& t, uint16_t distance, uint16_t length) {
+    if (t.groupItems == 0) {
+        t.group[0] = 0;
+        t.groupLength = 1;
+    }
+    uint16_t token = (distance - 1) << 5 | (length - MIN_MATCH);
+    t.group[0] |= 1 << t.groupItems;
+    t.group[t.groupLength++] = token & 0xFF;
+    t.group[t.groupLength++] = token >> 8;
+    if (++t.groupItems == 8) flushGroup(t);
+}
+
+// Read up to COMPRESS_STEP_BYTES more and code all but the last MAX_MATCH
+// bytes (all of them at the end of the file); true once the input is done
+static bool encodeStep(CompressionTask& t) {
+    if (t.next > RUN_FILE_WINDOW) {
+        uint16_t shift = t.next - RUN_FILE_WINDOW;
+        memmove(t.buffer, t.buffer + shift, t.bufferLength - shift);
+        t.bufferStart += shift;
+        t.bufferLength -= shift;
+        t.next -= shift;
+    }
+    size_t room = min((size_t)(INPUT_BUFFER - t.bufferLength), (size_t)COMPRESS_STEP_BYTES);
+    size_t n = t.source.read(t.buffer + t.bufferLength, min(room, (size_t)(t.rawSize - t.consumed)));
+    t.crc = crc32Update(t.crc, t.buffer + t.bufferLength, n);
+    t.bufferLength += n;
+    t.consumed += n;
+    bool inputDone = t.consumed == t.rawSize || (n == 0 && room > 0);
+
+    while (t.next < t.bufferLength && (inputDone || t.next + MAX_MATCH <= t.bufferLength)) {
+        uint16_t distance = 0;
+        uint16_t length = longestMatch(t, distance);
+        if (length == 0) {
+            emitLiteral(t, t.buffer[t.next]);
+            length = 1;
+        } else {
+            emitMatch(t, distance, length);
+        }
+        for (uint16_t i = 0; i < length; i++) {
+            insertPosition(t, t.next++);
+        }
+    }
+    return inputDone && t.next == t.bufferLength;
+}
+
+static void discardTask() {
+    task->source.close();
+    task->target.close();
+    task->check.close();
+    if (LittleFS.exists(COMPRESS_TMP_FILE)) {
+        LittleFS.remove(COMPRESS_TMP_FILE);
+    }
+    delete task;
+    task = nullptr;
+}
+
+static bool beginTask(const RunFileInfo& info) {
+    task = new (std::nothrow) CompressionTask();
+    if (!task) {
+        Serial.println("Not enough memory to compress run files");
+        return false;
+    }
+    task->fileName = info.name;
+    task->source = LittleFS.open(runFilePath(info.name), "r");
+    task->target = LittleFS.open(COMPRESS_TMP_FILE, "w");
+    if (!task->source || !task->target) {
+        discardTask();
+        return false;
+    }
+    task->rawSize = task->source.size();
+    task->consumed = 0;
+    task->crc = 0;
+    task->storedSize = RUN_FILE_HEADER_SIZE;
+    task->verifying = false;
+    task->bufferStart = 0;
+    task->bufferLength = 0;
+    task->next = 0;
+    task->groupItems = 0;
+    memset(task->head, 0xFF, sizeof(task->head));
+
+    // The CRC goes in once it is known
+    uint32_t header[3] = {RUN_FILE_MAGIC, task->rawSize, 0};
+    task->target.write((const uint8_t*)header, RUN_FILE_HEADER_SIZE);
+    return true;
+}
+
+// Swap the compressed copy in, unless the file changed meanwhile (deleted,
+// renamed, replaced) or compressing it saved too little
+static void finishTask(bool verified) {
+    String path = runFilePath(task->fileName).c_str();
+    const RunFileInfo* entry = catalogFindFile(task->fileName);
+    bool unchanged = entry && entry->storage == STORAGE_RAW && entry->size == task->rawSize && LittleFS.exists(path);
+    bool worthIt = task->storedSize * 100ull <= task->rawSize * (uint64_t)COMPRESS_KEEP_PERCENT;
+    uint32_t storedSize = task->storedSize;
+    uint32_t rawSize = task->rawSize;
+    String fileName = task->fileName;
+    storageNoteWrite(storedSize);
+
+    task->check.close();
+    if (!verified) {
+        Serial.printf("Compressed copy of %s did not read back correctly, keeping it raw\n", fileName.c_str());
+    }
+    // LittleFS replaces the target of a rename atomically, so the file is never missing
+    if (unchanged && verified && worthIt && LittleFS.rename(COMPRESS_TMP_FILE, path)) {
+        catalogSetStorage(fileName, storedSize, STORAGE_COMPRESSED);
+        Serial.printf("Compressed %s: %u -> %u bytes\n", fileName.c_str(), rawSize, storedSize);
+    } else if (unchanged && verified) {
+        catalogSetStorage(fileName, rawSize, STORAGE_INCOMPRESSIBLE);
+    }
+    discardTask();
+}
+
+// Next finished file that is still raw and big enough to bother with
+static const RunFileInfo* nextRawFile(uint32_t& remaining) {
+    const RunFileInfo* next = nullptr;
+    String recording = isRunActive() ? getCurrentRun().currentFileName : String();
+    remaining = 0;
+    for (const RunListing& run : catalogRuns()) {
+        for (const RunFileInfo& f : run.files) {
+            if (f.storage != STORAGE_RAW || f.size < COMPRESS_MIN_BYTES || f.name == recording) continue;
+            if (std::find(attempted.begin(), attempted.end(), f.name) != attempted.end()) continue;
+            remaining++;
+            if (!next) next = &f;
+        }
+    }
+    return next;
+}
+
+static bool compressionStep(JobStatus& status) {
+    if (!task) {
+        uint32_t remaining;
+        const RunFileInfo* next = nextRawFile(remaining);
+        if (!next) {
+            attempted.clear();
+            return false;
+        }
+        status.total = status.done + remaining;
+        status.message = next->name;
+        attempted.push_back(next->name);
+        beginTask(*next);
+        return true;
+    }
+
+    CompressionTask& t = *task;
+    if (!t.verifying) {
+        if (encodeStep(t)) {
+            flushGroup(t);
+            t.target.seek(8);
+            t.target.write((const uint8_t*)&t.crc, 4);
+            t.target.close();
+            t.source.close();
+            t.verifying = t.check.open(COMPRESS_TMP_FILE);
+            t.checkCrc = 0;
+            if (!t.verifying) {
+                finishTask(false);
+                status.done++;
+            }
+        }
+        return true;
+    }
+
+    uint8_t buffer[256];
+    for (size_t total = 0; total < COMPRESS_STEP_BYTES;) {
+        size_t n = t.check.read(buffer, sizeof(buffer));
+        if (n == 0) {
+            finishTask(t.check.position() == t.rawSize && t.checkCrc == t.crc && t.check.storedCrc() == t.crc);
+            status.done++;
+            return true;
+        }
+        t.checkCrc = crc32Update(t.checkCrc, buffer, n);
+        total += n;
+    }
+    return true;
+}
+
+void initRunCompression() {
+    // Left over from a reset in the middle of a file
+    if (LittleFS.exists(COMPRESS_TMP_FILE)) {
+        LittleFS.remove(COMPRESS_TMP_FILE);
+    }
+    scheduleRunCompression();
+}
+
+void scheduleRunCompression() {
+    if (isJobPending("compress-runs")) return;
+
+    // A cancelled job leaves its file half done
+    if (task) {
+        discardTask();
+    }
+    attempted.clear();
+
+    uint32_t remaining;
+    if (nextRawFile(remaining)) {
+        scheduleJob("compress-runs", JOB_PRIORITY_LOW, compressionStep);
+    }
+}
+
+bool compressRunFilesStep() {
+    JobStatus status = {};
+    return compressionStep(status);
+}
+
+RunStorageStats getRunStorageStats() {
+    RunStorageStats stats = {0, 0, 0, 0, 0, 0, 0};
+    for (const RunListing& run : catalogRuns()) {
+        for (const RunFileInfo& f : run.files) {
+            stats.files++;
+            stats.dataBytes += f.size;
+            stats.storedBytes += f.storedSize;
+            if (f.storage == STORAGE_COMPRESSED) {
+                stats.compressedFiles++;
+                stats.compressedDataBytes += f.size;
+                stats.compressedStoredBytes += f.storedSize;
+            } else if (f.storage == STORAGE_RAW && f.size >= COMPRESS_MIN_BYTES) {
+                stats.pendingFiles++;
+            }
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,171 @@
+// src/run_journal.cpp
+#include "run_journal.h"
+#include "run_manager.h"
+#include "run_catalog.h"
+#include "data_logger.h"
+#include "storage_manager.h"
+#include "zip_stream.h"
+#include "trace.h"
+#include "hal.h"
+#include "config.h"
+#include <LittleFS.h>
+
+#define RUN_JOURNAL_MAGIC 0x314A5054  // "TPJ1"
+
+struct JournalRecord {
+    uint32_t magic;
+    uint32_t bytes;          // Of the data file, known to be on flash
+    DataFileStats stats;     // Of the rows in those bytes
+    char fileName[PATH_MAX_LEN];
+    char runName[64];
+    uint32_t crc;            // Of everything before it
+};
+
+static JournalRecord record;
+static bool journalActive = false;
+static unsigned long lastCheckpoint = 0;
+
+static void writeRecord() {
+    record.crc = crc32Update(0, (const uint8_t*)&record, offsetof(JournalRecord, crc));
+    File file = LittleFS.open(RUN_JOURNAL_FILE, "w");
+    if (!file || file.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+        Serial.println("Failed to write run journal");
+        return;
+    }
+    file.close();
+    storageNoteWrite(sizeof(record));
+}
+
+// Rows of a data file from offset on: the end of the last complete one, and
+// their stats added to stats. The first line is skipped unless offset is
+// known to start a row.
+static size_t scanTail(File& file, size_t offset, bool atRowStart, DataFileStats& stats) {
+    size_t rowEnd = offset;
+    size_t pos = offset;
+    bool skipping = !atRowStart;
+    char line[48];
+    size_t lineLength = 0;
+    uint8_t buffer[256];
+
+    file.seek(offset);
+    size_t n;
+    while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+        for (size_t i = 0; i < n; i++, pos++) {
+            char c = (char)buffer[i];
+            if (c != '\n') {
+                if (lineLength < sizeof(line) - 1) line[lineLength++] = c;
+                continue;
+            }
+
+            // Parsed like scanDataFileStats: rows start with a digit and have a comma
+            line[lineLength] = '\0';
+            char* comma = strchr(line, ',');
+            if (!skipping && comma && comma != line && line[0] >= '0' && line[0] <= '9') {
+                float thrust = strtof(comma + 1, nullptr);
+                stats.samples++;
+                stats.durationMs = strtoul(line, nullptr, 10);
+                if (thrust > stats.peakThrust) {
+                    stats.peakThrust = thrust;
+                }
+            }
+            skipping = false;
+            lineLength = 0;
+            rowEnd = pos + 1;
+        }
+    }
+    return rowEnd;
+}
+
+static void recoverRun(const JournalRecord& journal) {
+    String fileName = journal.fileName;
+    PathString path = runFilePath(fileName);
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        Serial.printf("Interrupted run file is gone: %s\n", path.c_str());
+        return;
+    }
+    size_t size = file.size();
+
+    // Rows past the checkpoint, up to the scan limit; beyond it, the summary
+    // job rescans the whole file in the background
+    size_t scanStart = journal.bytes;
+    bool statsKnown = true;
+    if (journal.bytes > size || size - journal.bytes > RUN_RECOVERY_SCAN_BYTES) {
+        scanStart = size > RUN_RECOVERY_SCAN_BYTES ? size - RUN_RECOVERY_SCAN_BYTES : 0;
+        statsKnown = false;
+    }
+    DataFileStats stats = statsKnown ? journal.stats : DataFileStats{0, 0, 0.0};
+    size_t rowEnd = scanTail(file, scanStart, statsKnown || scanStart == 0, stats);
+    file.close();
+
+    // Without a newline in the tail, the checkpoint is the last known row end
+    size_t keep = rowEnd;
+    if (rowEnd == scanStart && journal.bytes <= size) {
+        keep = journal.bytes;
+    }
+    if (keep < size && !truncateFile(path.c_str(), keep)) {
+        Serial.printf("Failed to cut %s to its last complete row\n", path.c_str());
+        keep = size;
+        statsKnown = false;
+    }
+
+    RunFileInfo info{fileName, keep, stats, statsKnown};
+    info.recovered = true;
+    catalogPutFile(fileName, info);
+    Serial.printf("Recovered interrupted run %s: %s, %u bytes kept, %u cut\n", journal.runName, fileName.c_str(),
+                  (unsigned)keep, (unsigned)(size - keep));
+}
+
+void initRunJournal() {
+    if (!LittleFS.exists(RUN_JOURNAL_FILE)) {
+        return;
+    }
+
+    File file = LittleFS.open(RUN_JOURNAL_FILE, "r");
+    JournalRecord journal;
+    bool valid = file && file.read((uint8_t*)&journal, sizeof(journal)) == sizeof(journal) &&
+                 journal.magic == RUN_JOURNAL_MAGIC &&
+                 journal.crc == crc32Update(0, (const uint8_t*)&journal, offsetof(JournalRecord, crc));
+    file.close();
+
+    if (valid) {
+        journal.fileName[sizeof(journal.fileName) - 1] = '\0';
+        journal.runName[sizeof(journal.runName) - 1] = '\0';
+        recoverRun(journal);
+    } else {
+        Serial.println("Run journal is unreadable, ignoring it");
+    }
+    LittleFS.remove(RUN_JOURNAL_FILE);
+}
+
+void journalRunStarted(const String& fileName, const String& runName) {
+    memset(&record, 0, sizeof(record));
+    record.magic = RUN_JOURNAL_MAGIC;
+    record.bytes = getCurrentFileBytes();  // The header, flushed by createDataFile
+    record.stats = {0, 0, 0.0};
+    strncpy(record.fileName, fileName.c_str(), sizeof(record.fileName) - 1);
+    strncpy(record.runName, runName.c_str(), sizeof(record.runName) - 1);
+    writeRecord();
+
+    journalActive = true;
+    lastCheckpoint = millis();
+}
+
+void handleRunJournal() {
+    if (!journalActive || millis() - lastCheckpoint < RUN_JOURNAL_CHECKPOINT_MS) {
+        return;
+    }
+    lastCheckpoint = millis();
+
+    TRACE_SCOPE("run.checkpoint");
+    record.bytes = syncDataFile();
+    record.stats = getCurrentFileStats();
+    writeRecord();
+}
+
+void journalRunStopped() {
+    journalActive = false;
+    if (LittleFS.exists(RUN_JOURNAL_FILE)) {
+        LittleFS.remove(RUN_JOURNAL_FILE);
+    }
+}
@@ -2,12 +2,42 @@
 #include "run_manager.h"
 #include "config.h"
 #include "data_logger.h"
+#include "file_ops.h"
+#include "run_compression.h"
+#include "run_journal.h"
+#include "load_cell.h"
+#include "zero_tracker.h"
+#include "request_arena.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include <algorithm>
 
 static RunConfig currentRun;
 static bool runActive = false;
 
+// Data files named before NTP set the clock, renamed once it is
+struct UnsyncedFile {
+    String fileName;
+    String sanitizedName;
+    unsigned long startMillis;
+};
+static std::vector<UnsyncedFile> unsyncedFiles;
+static uint32_t bootCount = 0;
+
+// Boots that had the wall clock and when each started, oldest first; saved,
+// so files left with boot-relative names can be placed among dated ones
+#define CLOCKED_BOOTS_MAX 16
+struct ClockedBoot {
+    uint32_t boot;
+    uint32_t startTime;
+};
+static std::vector<ClockedBoot> clockedBoots;
+static bool bootClocked = false;  // This boot is in clockedBoots
+
+// Runs deleteRun handed to a file batch, with the batch id
+static std::vector<std::pair<String, int>> deletingRuns;
+
 // Helper function to sanitize filenames
 String sanitizeFilename(const String& input) {
     String output = input;
@@ -28,19 +58,35 @@ String sanitizeFilename(const String& input) {
     return output;
 }
 
-// Helper function to generate timestamp string
-String getTimestamp() {
-    //time_t now = time(nullptr);
-    //struct tm* timeinfo = localtime(&now);
+bool isClockSet() {
+    return time(nullptr) > TIME_VALID_EPOCH;
+}
 
+String formatTimestamp(time_t when) {
     struct tm timeinfo;
-    if (getLocalTime(&timeinfo)) {
-        char buffer[20];
-        strftime(buffer, sizeof(buffer), "%y-%m-%d_%T", &timeinfo);
-        return String(buffer);
+    localtime_r(&when, &timeinfo);
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%y-%m-%d_%T", &timeinfo);
+    return String(buffer);
+}
+
+// Helper function to generate timestamp string. Without NTP (no network in
+// the field) it is boot-relative, "boot<count>+<ms>", and unique across boots.
+String getTimestamp() {
+    if (isClockSet()) {
+        return formatTimestamp(time(nullptr));
     }
- 
-    return String("badTimestamp");
+    
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "boot%u+%lu", (unsigned)bootCount, millis());
+    return String(buffer);
+}
+
+static PathString configFilePath(const String& sanitizedName) {
+    PathString path(CONFIGS_DIR "/");
+    path += sanitizedName;
+    path += ".json";
+    return path;
 }
 
 bool initRunManager() {
@@ -59,6 +105,17 @@ bool initRunManager() {
     currentRun.startTime = 0;
     currentRun.currentFileName = "";
     
+    // Numbers boots, so boot-relative timestamps never repeat
+    Preferences prefs;
+    prefs.begin("runs", false);
+    bootCount = prefs.getUInt("boots", 0) + 1;
+    prefs.putUInt("boots", bootCount);
+    clockedBoots.resize(prefs.getBytesLength("clocked") / sizeof(ClockedBoot));
+    prefs.getBytes("clocked", clockedBoots.data(), clockedBoots.size() * sizeof(ClockedBoot));
+    prefs.end();
+    
+    initRunCatalog();
+    
     Serial.println("Run manager initialized");
     return true;
 }
@@ -69,79 +126,100 @@ bool createRunConfig(const String& name, const String& notes) {
         return false;
     }
     
+    // Its config is about to be deleted
+    const RunListing* existing = catalogFindRun(name);
+    if (existing && isRunDeleting(name)) {
+        Serial.println("Run is being deleted: " + name);
+        return false;
+    }
+    
     // Sanitize the name for the config filename
     String sanitizedName = sanitizeFilename(name);
     
     // Create JSON document
     JsonDocument doc;
+    String created = getTimestamp();
     doc["name"] = name;  // Store original name with spaces
     doc["notes"] = notes;
-    doc["created"] = getTimestamp();
+    doc["created"] = created;
     
     // Save to file using sanitized name
-    String configPath = String(CONFIGS_DIR) + "/" + sanitizedName + ".json";
+    PathString configPath = configFilePath(sanitizedName);
     File file = LittleFS.open(configPath, "w");
     
     if (!file) {
-        Serial.println("Failed to create config file: " + configPath);
+        Serial.printf("Failed to create config file: %s\n", configPath.c_str());
         return false;
     }
     
     serializeJson(doc, file);
     file.close();
     
+    catalogPutRun(name, notes, created);
+    
     Serial.println("Created run config: " + name + " (file: " + sanitizedName + ".json)");
     return true;
 }
 
-bool startRun(const String& runName) {
+bool startRun(const String& runName, StorageCheck* storageCheck) {
     if (runActive) {
         Serial.println("A run is already active. Stop it first.");
         return false;
     }
     
-    // Sanitize the name to find the config file
-    String sanitizedName = sanitizeFilename(runName);
-    String configPath = String(CONFIGS_DIR) + "/" + sanitizedName + ".json";
-    
-    if (!LittleFS.exists(configPath)) {
-        Serial.println("Run config not found: " + runName + " (looked for: " + configPath + ")");
+    const RunListing* config = catalogFindRun(runName);
+    if (!config) {
+        Serial.println("Run config not found: " + runName);
         return false;
     }
-    
-    File file = LittleFS.open(configPath, "r");
-    if (!file) {
-        Serial.println("Failed to open config file");
+    if (isRunDeleting(runName)) {
+        Serial.println("Run is being deleted: " + runName);
         return false;
     }
     
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    
-    if (error) {
-        Serial.println("Failed to parse config file");
-        return false;
-    }
+    String sanitizedName = sanitizeFilename(runName);
     
     // Generate filename with timestamp (sanitized)
     String timestamp = getTimestamp();
     String fileName = sanitizedName + ": " + timestamp + ".csv";
     
+    // Record the zero the run is measured from, and how far tracking has moved it since boot
+    ZeroTrackerStatus zero = getZeroTrackerStatus();
+    FixedString<96> header;
+    header.appendf("tare_counts=%ld zero_drift_counts=%ld zero_drift_grams=%.2f", getTareOffset(), zero.driftCounts,
+                   zero.driftGrams);
+    
+    // Make room for it, or refuse it when there is too little
+    StorageCheck storage = checkRunStorage(enabledChannels());
+    if (storageCheck) {
+        *storageCheck = storage;
+    }
+    if (!storage.ok) {
+        Serial.println("Not starting run: " + storage.message);
+        return false;
+    }
+    
     // Create data file
-    if (!createDataFile(fileName)) {
+    if (!createDataFile(fileName, header.c_str(), enabledChannels())) {
         Serial.println("Failed to create data file");
         return false;
     }
     
+    catalogPutFile(fileName, RunFileInfo{fileName, getFileSize(fileName), getCurrentFileStats(), true});
+    journalRunStarted(fileName, config->name);
+    
     // Set current run state (store original name with spaces)
-    currentRun.name = doc["name"].as<String>();
-    currentRun.notes = doc["notes"].as<String>();
+    currentRun.name = config->name;
+    currentRun.notes = config->notes;
     currentRun.isActive = true;
     currentRun.startTime = millis();
     currentRun.currentFileName = fileName;
     runActive = true;
     
+    if (!isClockSet()) {
+        unsyncedFiles.push_back(UnsyncedFile{fileName, sanitizedName, currentRun.startTime});
+    }
+    
     Serial.println("Started run: " + currentRun.name + " -> " + fileName);
     return true;
 }
@@ -152,8 +230,13 @@ bool stopRun() {
         return false;
     }
     
-    // Close the data file
+    // Close the data file and record its final size and stats
+    DataFileStats stats = getCurrentFileStats();
     closeDataFile();
+    journalRunStopped();
+    storageNoteWrite(getCurrentFileBytes());
+    catalogPutFile(currentRun.currentFileName,
+                   RunFileInfo{currentRun.currentFileName, getFileSize(currentRun.currentFileName), stats, true});
     
     Serial.println("Stopped run: " + currentRun.name);
     Serial.println("Data saved to: " + currentRun.currentFileName);
@@ -162,6 +245,10 @@ bool stopRun() {
     currentRun.isActive = false;
     runActive = false;
     
+    // Compressed in the background once the stand is idle, and room made for the next run
+    scheduleRunCompression();
+    scheduleStorageCleanup();
+    
     return true;
 }
 
@@ -171,38 +258,56 @@ bool deleteRun(const String& runName) {
         stopRun();
     }
     
+    const RunListing* run = catalogFindRun(runName);
+    if (run && isRunDeleting(runName)) {
+        return true;
+    }
+    
     // Sanitize the name for file operations
     String sanitizedName = sanitizeFilename(runName);
+    PathString configPath = configFilePath(sanitizedName);
+    
+    // Data files are removed by a background job, and the config after them,
+    // so a reset part way leaves the run listed with the files it still has
+    // rather than files no run owns
+    if (run && !run->files.empty()) {
+        std::vector<FileOp> ops;
+        for (const RunFileInfo& f : run->files) {
+            ops.push_back(FileOp{FILE_OP_DELETE, runFilePath(f.name).c_str(), "", false, false, ""});
+        }
+        // Unless a data file could not be deleted: the run keeps owning it
+        ops.push_back(FileOp{FILE_OP_DELETE, configPath.c_str(), "", false, false, "", true});
+        deletingRuns.push_back(std::make_pair(sanitizedName, submitFileBatch(ops)));
+        Serial.println("Deleting run: " + runName);
+        return true;
+    }
     
     // Delete config file
-    String configPath = String(CONFIGS_DIR) + "/" + sanitizedName + ".json";
     if (LittleFS.exists(configPath)) {
         LittleFS.remove(configPath);
-        Serial.println("Deleted config: " + configPath);
-    }
-    
-    // Delete all data files for this run (use sanitized name prefix)
-    File dir = LittleFS.open(RUNS_DIR);
-    if (dir && dir.isDirectory()) {
-        File file = dir.openNextFile();
-        
-        while (file) {
-            String fileName = String(file.name());
-            // Match files that start with sanitized name
-            if (fileName.startsWith(sanitizedName + ": ") && fileName.endsWith(".csv")) {
-                String fullPath = String(RUNS_DIR) + "/" + fileName;
-                LittleFS.remove(fullPath);
-                Serial.println("Deleted data file: " + fileName);
-            }
-            file = dir.openNextFile();
-        }
+        Serial.printf("Deleted config: %s\n", configPath.c_str());
     }
+    catalogRemoveRun(runName);
     
     Serial.println("Deleted run: " + runName);
     return true;
 }
 
-RunConfig getCurrentRun() {
+bool isRunDeleting(const String& runName) {
+    // Forget batches that finished or were cancelled
+    deletingRuns.erase(std::remove_if(deletingRuns.begin(), deletingRuns.end(),
+                                      [](const std::pair<String, int>& entry) {
+                                          return !isFileBatchActive(entry.second);
+                                      }),
+                       deletingRuns.end());
+    String sanitizedName = sanitizeFilename(runName);
+    for (const auto& entry : deletingRuns) {
+        if (entry.first == sanitizedName) return true;
+    }
+    return false;
+}
+
+const RunConfig& getCurrentRun() {
     return currentRun;
 }
 
@@ -211,28 +316,18 @@ bool isRunActive() {
 }
 
 String getRunConfigsList() {
-    JsonDocument doc;
+    JsonDocument doc(arenaAllocator());
     JsonArray runs = doc.to<JsonArray>();
     
-    File dir = LittleFS.open(CONFIGS_DIR);
-    if (!dir || !dir.isDirectory()) {
-        return "[]";
-    }
-    
-    File file = dir.openNextFile();
-    while (file) {
-        if (!file.isDirectory() && String(file.name()).endsWith(".json")) {
-            JsonDocument configDoc;
-            DeserializationError error = deserializeJson(configDoc, file);
-            
-            if (!error) {
-                JsonObject run = runs.add<JsonObject>();
-                run["name"] = configDoc["name"];  // Return original name with spaces
-                run["notes"] = configDoc["notes"];
-                run["created"] = configDoc["created"];
-            }
-        }
-        file = dir.openNextFile();
+    for (const RunListing& entry : catalogRuns()) {
+        JsonObject run = runs.add<JsonObject>();
+        run["name"] = entry.name;  // Return original name with spaces
+        run["notes"] = entry.notes;
+        run["created"] = entry.created;
+        run["starred"] = entry.starred;
+        run["deleting"] = isRunDeleting(entry.name);
+        run["recovered"] = std::any_of(entry.files.begin(), entry.files.end(),
+                                       [](const RunFileInfo& f) { return f.recovered; });
     }
     
     String output;
@@ -241,29 +336,17 @@ String getRunConfigsList() {
 }
 
 String getRunDataFiles(const String& runName) {
-    JsonDocument doc;
+    JsonDocument doc(arenaAllocator());
     JsonArray files = doc.to<JsonArray>();
     
-    // Sanitize the name to match filenames
-    String sanitizedName = sanitizeFilename(runName);
-    
-    File dir = LittleFS.open(RUNS_DIR);
-    if (!dir || !dir.isDirectory()) {
-        return "[]";
-    }
-    
-    File file = dir.openNextFile();
-    while (file) {
-        String fileName = String(file.name());
-        if (!file.isDirectory() && 
-            fileName.startsWith(sanitizedName + ": ") && 
-            fileName.endsWith(".csv")) {
-            
+    const RunListing* run = catalogFindRun(runName);
+    if (run) {
+        for (const RunFileInfo& f : run->files) {
             JsonObject fileObj = files.add<JsonObject>();
-            fileObj["name"] = fileName;
-            fileObj["size"] = file.size();
+            fileObj["name"] = f.name;
+            fileObj["size"] = f.size;
+            fileObj["recovered"] = f.recovered;
         }
-        file = dir.openNextFile();
     }
     
     String output;
@@ -271,10 +354,26 @@ String getRunDataFiles(const String& runName) {
     return output;
 }
 
-bool updateRunNotes(const String& runName, const String& notes) {
+std::vector<const RunListing*> listRunsWithFiles(bool newestFirst) {
+    std::vector<const RunListing*> runs;
+    for (const RunListing& run : catalogRuns()) {
+        runs.push_back(&run);
+    }
+    
+    // Timestamps are "%y-%m-%d_%T", so string order is date order
+    std::sort(runs.begin(), runs.end(), [newestFirst](const RunListing* a, const RunListing* b) {
+        return newestFirst ? b->created < a->created : a->created < b->created;
+    });
+    
+    return runs;
+}
+
+// Change one field of a run's config file
+template <typename T>
+static bool setRunConfigField(const String& runName, const char* key, const T& value) {
     // Sanitize the name to find the config file
     String sanitizedName = sanitizeFilename(runName);
-    String configPath = String(CONFIGS_DIR) + "/" + sanitizedName + ".json";
+    PathString configPath = configFilePath(sanitizedName);
     
     if (!LittleFS.exists(configPath)) {
         Serial.println("Run config not found: " + runName);
@@ -295,8 +394,7 @@ bool updateRunNotes(const String& runName, const String& notes) {
         return false;
     }
     
-    // Update notes
-    doc["notes"] = notes;
+    doc[key] = value;
     
     // Write back
     file = LittleFS.open(configPath, "w");
@@ -306,6 +404,15 @@ bool updateRunNotes(const String& runName, const String& notes) {
     
     serializeJson(doc, file);
     file.close();
+    return true;
+}
+
+bool updateRunNotes(const String& runName, const String& notes) {
+    if (!setRunConfigField(runName, "notes", notes)) {
+        return false;
+    }
+    
+    catalogSetNotes(runName, notes);
     
     // Update current run if it's active
     if (runActive && currentRun.name == runName) {
@@ -316,6 +423,99 @@ bool updateRunNotes(const String& runName, const String& notes) {
     return true;
 }
 
+bool setRunStarred(const String& runName, bool starred) {
+    if (!setRunConfigField(runName, "starred", starred)) {
+        return false;
+    }
+    
+    catalogSetStarred(runName, starred);
+    Serial.println(String(starred ? "Starred" : "Unstarred") + " run: " + runName);
+    return true;
+}
+
 void resetStartTime(unsigned long millis) {
     currentRun.startTime = millis;
-}
\ No newline at end of file
+    
+    // The leading samples the sampler skips are not part of the run's start
+    if (!unsyncedFiles.empty() && unsyncedFiles.back().fileName == currentRun.currentFileName) {
+        unsyncedFiles.back().startMillis = millis;
+    }
+}
+
+// Wall-clock time of a boot-relative timestamp from this boot, or 0
+static time_t bootTimestampTime(const String& timestamp, time_t now) {
+    String prefix = "boot" + String(bootCount) + "+";
+    if (!timestamp.startsWith(prefix)) {
+        return 0;
+    }
+    unsigned long atMillis = strtoul(timestamp.c_str() + prefix.length(), nullptr, 10);
+    return now - (time_t)((millis() - atMillis) / 1000);
+}
+
+// The clock has just been set: remember when this boot started, and date
+// the run configs created before
+static void clockArrived(time_t now) {
+    bootClocked = true;
+    clockedBoots.push_back(ClockedBoot{bootCount, (uint32_t)(now - millis() / 1000)});
+    if (clockedBoots.size() > CLOCKED_BOOTS_MAX) {
+        clockedBoots.erase(clockedBoots.begin());
+    }
+    Preferences prefs;
+    prefs.begin("runs", false);
+    prefs.putBytes("clocked", clockedBoots.data(), clockedBoots.size() * sizeof(ClockedBoot));
+    prefs.end();
+    
+    std::vector<String> undated;
+    for (const RunListing& run : catalogRuns()) {
+        if (bootTimestampTime(run.created, now)) undated.push_back(run.name);
+    }
+    for (const String& name : undated) {
+        const RunListing* run = catalogFindRun(name);
+        String notes = run->notes;
+        String created = formatTimestamp(bootTimestampTime(run->created, now));
+        if (setRunConfigField(name, "created", created)) {
+            catalogPutRun(name, notes, created);
+            Serial.println("Clock set: run " + name + " created " + created);
+        }
+    }
+}
+
+void reconcileRunTimestamps() {
+    if (!isClockSet()) {
+        return;
+    }
+    
+    time_t now = time(nullptr);
+    if (!bootClocked) {
+        clockArrived(now);
+    }
+    for (auto it = unsyncedFiles.begin(); it != unsyncedFiles.end();) {
+        // The file being recorded is renamed after it is closed
+        if (runActive && it->fileName == currentRun.currentFileName) {
+            ++it;
+            continue;
+        }
+        
+        time_t started = now - (time_t)((millis() - it->startMillis) / 1000);
+        String fileName = it->sanitizedName + ": " + formatTimestamp(started) + ".csv";
+        for (int n = 1; LittleFS.exists(runFilePath(fileName)); n++) {
+            fileName = it->sanitizedName + ": " + formatTimestamp(started) + "_" + String(n) + ".csv";
+        }
+        
+        FileOp op{FILE_OP_RENAME, runFilePath(it->fileName).c_str(), runFilePath(fileName).c_str(), false, false, ""};
+        runFileOp(op);
+        if (op.ok) {
+            Serial.println("Clock set: " + it->fileName + " -> " + fileName);
+        } else {
+            Serial.println("Could not rename " + it->fileName + ": " + op.error);
+        }
+        it = unsyncedFiles.erase(it);
+    }
+}
+
+time_t clockedBootAfter(uint32_t boot) {
+    for (const ClockedBoot& clocked : clockedBoots) {
+        if (clocked.boot > boot) return clocked.startTime;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+// src/run_trigger.cpp
+#include "run_trigger.h"
+#include "config.h"
+#include "load_cell.h"
+#include "run_manager.h"
+#include "zero_tracker.h"
+#include <Preferences.h>
+
+static RunTriggerConfig config;
+static TriggerState state = TRIGGER_IDLE;
+static float filteredThrust = 0.0;
+static unsigned long lastRead = 0;
+
+// End-of-run detection for the active run
+static bool startedByThrust = false;    // Re-arm after an automatic stop
+static bool autoStopped = false;
+static bool sawThrust = false;          // Only a run that has been above the stop threshold can end
+static unsigned long quietSince = 0;    // Run timestamp the smoothed thrust dropped below it
+
+bool initRunTrigger() {
+    Preferences prefs;
+    prefs.begin("trigger", true);  // Read-only
+    config.runName = prefs.getString("run", TRIGGER_DEFAULT_RUN);
+    config.startThreshold = prefs.getFloat("start_g", TRIGGER_DEFAULT_START_GRAMS);
+    config.armAtBoot = prefs.getBool("arm_boot", false);
+    config.autoStop = prefs.getBool("auto_stop", true);
+    config.stopThreshold = prefs.getFloat("stop_g", TRIGGER_DEFAULT_STOP_GRAMS);
+    config.stopHoldMs = prefs.getUInt("stop_ms", TRIGGER_DEFAULT_STOP_HOLD_MS);
+    prefs.end();
+
+    if (config.armAtBoot) {
+        armRunTrigger();
+    }
+    return true;
+}
+
+const RunTriggerConfig& getRunTriggerConfig() {
+    return config;
+}
+
+bool setRunTriggerConfig(const RunTriggerConfig& newConfig) {
+    if (newConfig.runName.length() == 0 || newConfig.startThreshold < 0 || newConfig.stopThreshold < 0) {
+        return false;
+    }
+    config = newConfig;
+
+    Preferences prefs;
+    prefs.begin("trigger", false);
+    prefs.putString("run", config.runName);
+    prefs.putFloat("start_g", config.startThreshold);
+    prefs.putBool("arm_boot", config.armAtBoot);
+    prefs.putBool("auto_stop", config.autoStop);
+    prefs.putFloat("stop_g", config.stopThreshold);
+    prefs.putUInt("stop_ms", config.stopHoldMs);
+    prefs.end();
+    return true;
+}
+
+TriggerState getTriggerState() {
+    return state;
+}
+
+const char* triggerStateName(TriggerState s) {
+    switch (s) {
+        case TRIGGER_ARMED: return "armed";
+        case TRIGGER_RECORDING: return "recording";
+        case TRIGGER_ENDING: return "ending";
+        default: return "idle";
+    }
+}
+
+static void enterRecording(bool byThrust) {
+    state = TRIGGER_RECORDING;
+    startedByThrust = byThrust;
+    autoStopped = false;
+    sawThrust = false;
+    if (!byThrust) {
+        filteredThrust = 0.0;
+    }
+}
+
+static bool startTriggeredRun(bool byThrust) {
+    if (!catalogFindRun(config.runName) && !createRunConfig(config.runName, "Recorded without the web UI")) {
+        return false;
+    }
+    if (!startRun(config.runName)) {
+        return false;
+    }
+
+    enterRecording(byThrust);
+    Serial.printf("Run started by %s\n", byThrust ? "thrust trigger" : "button");
+    return true;
+}
+
+bool armRunTrigger() {
+    if (isRunActive()) {
+        return false;
+    }
+
+    filteredThrust = 0.0;
+    state = TRIGGER_ARMED;
+    Serial.printf("Trigger armed: run starts at %.1f g\n", config.startThreshold);
+
+    // So the triggered start only has to check for room
+    scheduleStorageCleanup();
+    return true;
+}
+
+void disarmRunTrigger() {
+    if (state == TRIGGER_ARMED) {
+        state = TRIGGER_IDLE;
+        Serial.println("Trigger disarmed");
+    }
+}
+
+void runTriggerButton() {
+    if (isRunActive()) {
+        stopRun();
+        state = TRIGGER_IDLE;
+    } else if (state == TRIGGER_ARMED) {
+        disarmRunTrigger();
+    } else if (config.startThreshold > 0) {
+        armRunTrigger();
+    } else {
+        startTriggeredRun(false);
+    }
+}
+
+TriggerVerdict runTriggerObserve(float thrust, unsigned long timestamp) {
+    filteredThrust += TRIGGER_FILTER_ALPHA * (thrust - filteredThrust);
+    if (!config.autoStop) {
+        return TRIGGER_KEEP_SAMPLE;
+    }
+
+    if (filteredThrust >= config.stopThreshold) {
+        sawThrust = true;
+        state = TRIGGER_RECORDING;
+        return TRIGGER_KEEP_SAMPLE;
+    }
+    if (!sawThrust) {
+        return TRIGGER_KEEP_SAMPLE;
+    }
+
+    if (state != TRIGGER_ENDING) {
+        state = TRIGGER_ENDING;
+        quietSince = timestamp;
+    }
+    if (timestamp - quietSince < config.stopHoldMs) {
+        return TRIGGER_HOLD_SAMPLE;
+    }
+
+    autoStopped = true;
+    Serial.printf("End of run: below %.1f g for %lu ms\n", config.stopThreshold, timestamp - quietSince);
+    return TRIGGER_END_RUN;
+}
+
+void handleRunTrigger() {
+    reconcileRunTimestamps();
+
+    // Follow runs started and stopped through the web UI
+    if (isRunActive()) {
+        if (state != TRIGGER_RECORDING && state != TRIGGER_ENDING) {
+            enterRecording(false);
+        }
+        return;
+    }
+    if (state == TRIGGER_RECORDING || state == TRIGGER_ENDING) {
+        state = TRIGGER_IDLE;
+        // Hands-free sessions: a run the thrust started and ended waits for the next one
+        if (autoStopped && startedByThrust) {
+            armRunTrigger();
+        }
+    }
+    if (state != TRIGGER_ARMED) {
+        return;
+    }
+
+    unsigned long now = millis();
+    long counts;
+    if (now - lastRead < SAMPLE_RATE_MS || !readNetCounts(counts)) {
+        return;
+    }
+    lastRead = now;
+    zeroTrackerObserve(counts);
+
+    // Smoothed so a single noisy reading cannot start a run
+    filteredThrust += TRIGGER_FILTER_ALPHA * (netCountsToThrust(counts) - filteredThrust);
+    if (filteredThrust >= config.startThreshold && !startTriggeredRun(true)) {
+        disarmRunTrigger();
+    }
+}
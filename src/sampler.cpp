@@ -0,0 +1,108 @@
+// src/sampler.cpp
+#include "sampler.h"
+#include "config.h"
+#include "channels.h"
+#include "run_manager.h"
+#include "run_trigger.h"
+#include "data_logger.h"
+#include "serial_stream.h"
+#include "udp_stream.h"
+#include "metrics.h"
+
+struct HeldSample {
+    unsigned long timestamp;
+    ChannelSample channels;
+};
+
+// Timing variables
+static unsigned long lastSample = 0;
+static unsigned long lastLoggedMicros = 0;
+
+// Samples that may be the run's idle tail, oldest at heldStart. They reach the
+// file only if thrust comes back, so an ended run needs no trimming afterwards.
+static HeldSample held[TRIGGER_HOLDBACK_MAX];
+static size_t heldStart = 0;
+static size_t heldCount = 0;
+
+// Into the run's file, and to the streams once it is there
+static bool recordSample(const ChannelSample& channels, unsigned long timestamp) {
+    if (!logSample(channels, timestamp)) {
+        return false;
+    }
+    serialStreamSample(channels, timestamp);
+    udpStreamSample(channels, timestamp);
+    return true;
+}
+
+static void writeOldestHeld() {
+    const HeldSample& sample = held[heldStart];
+    if (!recordSample(sample.channels, sample.timestamp)) {
+        Serial.println("ERROR: Failed to log sample");
+    }
+    heldStart = (heldStart + 1) % TRIGGER_HOLDBACK_MAX;
+    heldCount--;
+}
+
+static void holdSample(const ChannelSample& channels, unsigned long timestamp) {
+    // A tail longer than the buffer is only trimmed to its last TRIGGER_HOLDBACK_MAX samples
+    if (heldCount == TRIGGER_HOLDBACK_MAX) {
+        writeOldestHeld();
+    }
+    held[(heldStart + heldCount) % TRIGGER_HOLDBACK_MAX] = HeldSample{timestamp, channels};
+    heldCount++;
+}
+
+void handleSampler() {
+    // If a run is active, log samples at the configured rate
+    if (!isRunActive()) {
+        // A run stopped by hand drops its held tail too
+        heldCount = 0;
+        return;
+    }
+
+    unsigned long currentTime = millis();
+    if (currentTime - lastSample >= SAMPLE_RATE_MS) {
+        // All channels on this one timestamp
+        ChannelSample channels;
+        readChannels(channels);
+        float thrust = channels.value[CHANNEL_THRUST];
+        unsigned long timestamp = currentTime - getCurrentRun().startTime;
+
+        if (getSampleCount() == 0 && thrust <= 0.5) {
+            // Beginning of run. Discard zero/noise sample and advance start time (start all runs with non-zero thrust)
+            resetStartTime(currentTime);
+            lastSample = currentTime;
+            return;
+        }
+
+        lastSample = currentTime;
+        switch (runTriggerObserve(thrust, timestamp)) {
+            case TRIGGER_HOLD_SAMPLE:
+                holdSample(channels, timestamp);
+                return;
+
+            case TRIGGER_END_RUN:
+                Serial.printf("Trimmed %u idle samples from the end of the run\n", (unsigned)heldCount);
+                heldCount = 0;
+                stopRun();
+                return;
+
+            case TRIGGER_KEEP_SAMPLE:
+                while (heldCount > 0) {
+                    writeOldestHeld();
+                }
+                break;
+        }
+
+        if (recordSample(channels, timestamp)) {
+            // Sample logged successfully
+            unsigned long now = micros();
+            if (getSampleCount() > 1) {
+                metricObserve(METRIC_SAMPLE_INTERVAL_US, now - lastLoggedMicros);
+            }
+            lastLoggedMicros = now;
+        } else {
+            Serial.println("ERROR: Failed to log sample");
+        }
+    }
+}
@@ -0,0 +1,168 @@
+// src/serial_stream.cpp
+#include "serial_stream.h"
+#include "stream_protocol.h"
+#include "config.h"
+#include "run_manager.h"
+#include "data_logger.h"
+#include <Preferences.h>
+
+static bool streaming = false;
+static StreamDecoder decoder;
+
+// Run whose frames are being sent
+static bool runOpen = false;
+static uint8_t runChannels = 0;
+static uint32_t runSamples = 0;
+
+static void sendFrame(uint8_t type, const StreamPayload& payload) {
+    uint8_t frame[STREAM_MAX_PAYLOAD + STREAM_FRAME_OVERHEAD];
+    size_t size = encodeStreamFrame(type, payload.data, payload.length, frame);
+    // One write, so no debug print can land inside a frame
+    Serial.write(frame, size);
+}
+
+static void sendHello() {
+    StreamPayload payload;
+    payload.putU8(STREAM_VERSION);
+    payload.putU16(SAMPLE_RATE_MS);
+    payload.putU8(enabledChannels());
+    payload.putU8(streaming);
+    sendFrame(STREAM_HELLO, payload);
+}
+
+static void sendAck(uint8_t command, bool ok, const char* message) {
+    StreamPayload payload;
+    payload.putU8(command);
+    payload.putU8(ok);
+    payload.put(message, strlen(message));
+    sendFrame(STREAM_ACK, payload);
+}
+
+static void closeRun() {
+    if (!runOpen) {
+        return;
+    }
+    StreamPayload payload;
+    payload.putU32(runSamples);
+    sendFrame(STREAM_RUN_STOP, payload);
+    runOpen = false;
+}
+
+static void openRun() {
+    runChannels = getCurrentFileChannels();
+    runSamples = 0;
+
+    StreamPayload payload;
+    payload.putU8(runChannels);
+    payload.putText(getCurrentRun().currentFileName.c_str());
+    payload.putText(getCurrentFileComment());
+    sendFrame(STREAM_RUN_START, payload);
+    runOpen = true;
+}
+
+bool initSerialStream() {
+    Preferences prefs;
+    prefs.begin("stream", true);  // Read-only
+    streaming = prefs.getBool("serial", false);
+    prefs.end();
+    return true;
+}
+
+bool isSerialStreaming() {
+    return streaming;
+}
+
+void setSerialStreaming(bool enabled) {
+    if (!enabled) {
+        closeRun();
+    }
+    streaming = enabled;
+
+    Preferences prefs;
+    prefs.begin("stream", false);
+    prefs.putBool("serial", enabled);
+    prefs.end();
+}
+
+void serialStreamSample(const ChannelSample& sample, unsigned long timestamp) {
+    if (!streaming) {
+        return;
+    }
+    // The first sample of a run opens it, whoever started the run
+    if (!runOpen) {
+        openRun();
+    }
+
+    StreamPayload payload;
+    payload.putU32(timestamp);
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (runChannels & CHANNEL_BIT(channel)) {
+            payload.putFloat(sample.value[channel]);
+        }
+    }
+    sendFrame(STREAM_SAMPLE, payload);
+    runSamples++;
+}
+
+static void runCommand() {
+    uint8_t command = decoder.type;
+    StreamReader reader(decoder.payload, decoder.length);
+
+    switch (command) {
+        case STREAM_CMD_PING:
+            sendHello();
+            break;
+
+        case STREAM_CMD_START: {
+            String runName;
+            runName.concat((const char*)decoder.payload, decoder.length);
+            bool ok = runName.length() > 0 && !isRunActive() &&
+                      (catalogFindRun(runName) || createRunConfig(runName, "Started over USB serial")) &&
+                      startRun(runName);
+            sendAck(command, ok, ok ? "Run started" : "Cannot start run");
+            break;
+        }
+
+        case STREAM_CMD_STOP: {
+            bool ok = isRunActive() && stopRun();
+            sendAck(command, ok, ok ? "Run stopped" : "No run in progress");
+            break;
+        }
+
+        case STREAM_CMD_CONFIG: {
+            uint8_t stream = reader.getU8();
+            uint8_t torque = reader.getU8();
+            uint8_t rpm = reader.getU8();
+            if (stream != 0xFF) {
+                setSerialStreaming(stream != 0);
+            }
+            bool ok = true;
+            if (torque != 0xFF || rpm != 0xFF) {
+                ChannelConfig channels = getChannelConfig();
+                if (torque != 0xFF) channels.torqueEnabled = torque != 0;
+                if (rpm != 0xFF) channels.rpmEnabled = rpm != 0;
+                // Like /api/channels, not while a run is being logged
+                ok = !isRunActive() && setChannelConfig(channels);
+            }
+            sendAck(command, ok, ok ? "Configured" : "Channels cannot change during a run");
+            break;
+        }
+
+        default:
+            sendAck(command, false, "Unknown command");
+            break;
+    }
+}
+
+void handleSerialStream() {
+    // Commands are few bytes; whatever has arrived is parsed without waiting
+    while (Serial.available() > 0) {
+        if (decoder.feed((uint8_t)Serial.read())) {
+            runCommand();
+        }
+    }
+
+    if (runOpen && !isRunActive()) {
+        closeRun();
+    }
+}
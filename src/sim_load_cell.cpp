@@ -0,0 +1,330 @@
+// src/sim_load_cell.cpp
+#include "sim_load_cell.h"
+#include "config.h"
+#include "load_cell.h"
+#include "channels.h"
+#include "data_logger.h"
+#include "run_compression.h"
+#include <vector>
+
+#define SIM_RAW_OFFSET 84000        // Unloaded bridge reading, so taring has something to remove
+#define SIM_RAW_MIN (-8388608L)     // HX711 output is 24-bit two's complement
+#define SIM_RAW_MAX 8388607L
+#define SIM_REPLAY_MAX_SAMPLES 20000
+
+struct ReplaySample {
+    uint32_t timeMs;
+    float thrust;
+};
+
+static SimLoadCellConfig config = defaultSimLoadCellConfig();
+static std::vector<ReplaySample> replay;
+static uint64_t elapsedMicros = 0;   // Since the curve started; micros() wraps every 71 min on the ESP32
+static unsigned long lastMicros = 0;  // micros() when elapsedMicros was last advanced
+static long lastConversion = -1;  // Index of the last conversion handed out
+static long lastTorqueConversion = -1;
+static uint64_t lastPulseMicros = 0;
+static float pulseRevolutions = 0;  // Fraction of a revolution not yet counted
+
+SimLoadCellConfig defaultSimLoadCellConfig() {
+    SimLoadCellConfig defaults;
+    defaults.curve = SIM_CURVE_STEP;
+    defaults.amplitude = 1000.0;
+    defaults.delayMs = 2000;
+    defaults.durationMs = 5000;
+    defaults.decayTauMs = 1500.0;
+    defaults.noiseGrams = 2.0;
+    defaults.humGrams = 0.0;
+    defaults.driftGramsPerMin = 0.0;
+    defaults.torquePerGram = 0.5;
+    defaults.rpmPerRootGram = 300.0;
+    defaults.humHz = 50.0;
+    defaults.dropoutRate = 0.0;
+    defaults.samplesPerSecond = 80;
+    defaults.repeat = false;
+    defaults.seed = 1;
+    defaults.replayFile = "";
+    return defaults;
+}
+
+bool parseSimCurve(const String& name, SimCurve& curve) {
+    if (name == "step") curve = SIM_CURVE_STEP;
+    else if (name == "decay") curve = SIM_CURVE_DECAY;
+    else if (name == "replay") curve = SIM_CURVE_REPLAY;
+    else return false;
+    return true;
+}
+
+const char* simCurveName(SimCurve curve) {
+    switch (curve) {
+        case SIM_CURVE_DECAY: return "decay";
+        case SIM_CURVE_REPLAY: return "replay";
+        default: return "step";
+    }
+}
+
+static bool loadReplay(const String& fileName) {
+    PathString fullPath = runFilePath(fileName);
+    replay.clear();
+
+    RunFileReader file(fullPath.c_str());
+    if (!file) {
+        Serial.printf("Simulator: cannot open %s\n", fullPath.c_str());
+        return false;
+    }
+
+    // Skip header line
+    file.readStringUntil('\n');
+
+    while (file.available() && replay.size() < SIM_REPLAY_MAX_SAMPLES) {
+        String line = file.readStringUntil('\n');
+        int commaPos = line.indexOf(',');
+        if (commaPos <= 0) continue;
+        replay.push_back({(uint32_t)line.substring(0, commaPos).toInt(), line.substring(commaPos + 1).toFloat()});
+    }
+    file.close();
+
+    Serial.printf("Simulator: replaying %u samples from %s\n", (unsigned)replay.size(), fullPath.c_str());
+    return !replay.empty();
+}
+
+bool configureSimLoadCell(const SimLoadCellConfig& newConfig) {
+    SimLoadCellConfig checked = newConfig;
+    if (checked.samplesPerSecond == 0) checked.samplesPerSecond = 1;
+    if (checked.decayTauMs <= 0) checked.decayTauMs = 1.0;
+    // Some conversions must get through or readRaw() never returns
+    checked.dropoutRate = constrain(checked.dropoutRate, 0.0f, 0.95f);
+
+    if (checked.curve == SIM_CURVE_REPLAY && !loadReplay(checked.replayFile)) {
+        return false;
+    }
+    if (checked.curve != SIM_CURVE_REPLAY) {
+        replay.clear();
+    }
+
+    config = checked;
+    restartSimLoadCell();
+    return true;
+}
+
+const SimLoadCellConfig& getSimLoadCellConfig() {
+    return config;
+}
+
+void restartSimLoadCell() {
+    elapsedMicros = 0;
+    lastMicros = micros();
+    lastConversion = -1;
+    lastTorqueConversion = -1;
+    lastPulseMicros = 0;
+    pulseRevolutions = 0;
+}
+
+// Time on the curve; the unsigned difference stays right across a micros() wrap
+static uint64_t curveMicros() {
+    unsigned long now = micros();
+    elapsedMicros += (unsigned long)(now - lastMicros);
+    lastMicros = now;
+    return elapsedMicros;
+}
+
+// SplitMix64: a well-mixed value per (seed, conversion, stream) without keeping generator state
+static uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static float uniform(long conversion, uint32_t stream) {
+    uint64_t bits = mix(((uint64_t)config.seed << 40) ^ ((uint64_t)stream << 32) ^ (uint32_t)conversion);
+    return ((bits >> 40) + 0.5f) / (float)(1UL << 24);  // (0, 1)
+}
+
+static bool isDropped(long conversion) {
+    return config.dropoutRate > 0 && uniform(conversion, 0) < config.dropoutRate;
+}
+
+static float replayThrust(float t) {
+    if (replay.empty() || t < replay.front().timeMs || t > replay.back().timeMs) {
+        return 0.0;
+    }
+
+    // Binary search for the first sample at or after t, then interpolate
+    size_t lo = 0, hi = replay.size() - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (replay[mid].timeMs < t) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return replay[0].thrust;
+
+    const ReplaySample& a = replay[lo - 1];
+    const ReplaySample& b = replay[lo];
+    float span = (float)(b.timeMs - a.timeMs);
+    return span > 0 ? a.thrust + (b.thrust - a.thrust) * (t - a.timeMs) / span : b.thrust;
+}
+
+static float curveLengthMs() {
+    if (config.curve == SIM_CURVE_REPLAY) {
+        return config.delayMs + (replay.empty() ? 0 : replay.back().timeMs);
+    }
+    return config.delayMs + config.durationMs;
+}
+
+static float curveThrust(float timeMs) {
+    float length = curveLengthMs();
+    if (config.repeat && length > 0) {
+        timeMs = fmodf(timeMs, length);
+    }
+
+    float t = timeMs - config.delayMs;
+    if (t < 0) return 0.0;
+
+    switch (config.curve) {
+        case SIM_CURVE_STEP:
+            return t < config.durationMs ? config.amplitude : 0.0;
+        case SIM_CURVE_DECAY:
+            return t < config.durationMs ? config.amplitude * expf(-t / config.decayTauMs) : 0.0;
+        case SIM_CURVE_REPLAY:
+            return replayThrust(t);
+    }
+    return 0.0;
+}
+
+// Net counts the active calibration curve reads as grams: the root of
+// c1*x + c2*x^2 = grams nearest grams / c1, so a fitted curve reads back the
+// simulated thrust. c0 is the zero residual the tare leaves.
+static float gramsToCounts(float grams) {
+    const LoadCellCurve& curve = getLoadCellCurve();
+    if (curve.c1 == 0) {
+        return grams * LOAD_CELL_CALIBRATION_FACTOR;
+    }
+    float discriminant = curve.c1 * curve.c1 + 4.0f * curve.c2 * grams;
+    if (discriminant < 0) {
+        return grams / curve.c1;
+    }
+    float root = sqrtf(discriminant);
+    return 2.0f * grams / (curve.c1 + (curve.c1 < 0 ? -root : root));
+}
+
+static long conversionValue(long conversion) {
+    float timeMs = conversion * 1000.0f / config.samplesPerSecond;
+    float thrust = curveThrust(timeMs);
+
+    if (config.humGrams != 0) {
+        thrust += config.humGrams * sinf(2.0f * (float)M_PI * config.humHz * timeMs / 1000.0f);
+    }
+    if (config.driftGramsPerMin != 0) {
+        thrust += config.driftGramsPerMin * timeMs / 60000.0f;
+    }
+    if (config.noiseGrams != 0) {
+        // Box-Muller
+        float u1 = uniform(conversion, 1);
+        float u2 = uniform(conversion, 2);
+        thrust += config.noiseGrams * sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+    }
+
+    long raw = SIM_RAW_OFFSET + lroundf(gramsToCounts(thrust));
+    return constrain(raw, SIM_RAW_MIN, SIM_RAW_MAX);
+}
+
+// Noise-free: the torque channel is there to check the channel plumbing
+static long torqueValue(long conversion) {
+    float timeMs = conversion * 1000.0f / config.samplesPerSecond;
+    float torque = curveThrust(timeMs) * config.torquePerGram;
+    long raw = SIM_RAW_OFFSET + lroundf(torque * getChannelConfig().torqueFactor);
+    return constrain(raw, SIM_RAW_MIN, SIM_RAW_MAX);
+}
+
+static long latestConversion() {
+    return (long)(curveMicros() * config.samplesPerSecond / 1000000UL);
+}
+
+class SimLoadCellDriver : public LoadCellDriver {
+public:
+    bool begin(uint8_t doutPin, uint8_t sckPin) override {
+        restartSimLoadCell();
+        return true;
+    }
+
+    bool isReady() override {
+        long latest = latestConversion();
+        return latest > lastConversion && !isDropped(latest);
+    }
+
+    long readRaw() override {
+        // Like the HX711, block until a conversion completes
+        while (!isReady()) {
+            delayMicroseconds(500000 / config.samplesPerSecond);
+        }
+        lastConversion = latestConversion();
+        return conversionValue(lastConversion);
+    }
+
+    const char* name() const override {
+        return "sim";
+    }
+};
+
+LoadCellDriver& simLoadCellDriver() {
+    static SimLoadCellDriver driver;
+    return driver;
+}
+
+class SimTorqueDriver : public LoadCellDriver {
+public:
+    bool begin(uint8_t doutPin, uint8_t sckPin) override {
+        return true;
+    }
+
+    bool isReady() override {
+        return latestConversion() > lastTorqueConversion;
+    }
+
+    long readRaw() override {
+        while (!isReady()) {
+            delayMicroseconds(500000 / config.samplesPerSecond);
+        }
+        lastTorqueConversion = latestConversion();
+        return torqueValue(lastTorqueConversion);
+    }
+
+    const char* name() const override {
+        return "sim";
+    }
+};
+
+LoadCellDriver& simTorqueDriver() {
+    static SimTorqueDriver driver;
+    return driver;
+}
+
+class SimPulseCounter : public PulseCounter {
+public:
+    bool begin(uint8_t pin) override {
+        return true;
+    }
+
+    // Revolutions at the RPM of the current thrust since the previous call
+    uint32_t takeCount() override {
+        uint64_t now = curveMicros();
+        float thrust = curveThrust(now / 1000.0f);
+        float rpm = config.rpmPerRootGram * sqrtf(thrust > 0 ? thrust : 0);
+        pulseRevolutions += rpm / 60.0f * (now - lastPulseMicros) / 1000000.0f;
+        lastPulseMicros = now;
+
+        uint32_t pulses = (uint32_t)pulseRevolutions;
+        pulseRevolutions -= pulses;
+        return pulses;
+    }
+
+    const char* name() const override {
+        return "sim";
+    }
+};
+
+PulseCounter& simPulseCounter() {
+    static SimPulseCounter counter;
+    return counter;
+}
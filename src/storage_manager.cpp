@@ -0,0 +1,248 @@
+// src/storage_manager.cpp
+#include "storage_manager.h"
+#include "run_manager.h"
+#include "run_compression.h"
+#include "data_logger.h"
+#include "channels.h"
+#include "job_scheduler.h"
+#include "config.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <algorithm>
+
+// Estimated CSV bytes: the column names and "#" line, and one row per sample
+#define HEADER_BYTES 160
+#define THRUST_ROW_BYTES 16  // "123456,1234.56\r\n"
+#define TORQUE_ROW_BYTES 8   // ",1234.56"
+#define RPM_ROW_BYTES 6      // ",12345"
+
+static StorageConfig config;
+static size_t runBudget = 0;  // Bytes the active run may write
+static bool cleanupCompressing = false;  // The cleanup job is still compressing files
+
+static uint64_t bytesWritten = 0;
+static uint64_t savedBytes = 0;  // bytesWritten when it was last saved
+static uint32_t runsRefused = 0;
+static uint32_t runsWarned = 0;
+static uint32_t runsStoppedFull = 0;
+static uint32_t filesDeleted = 0;
+
+static const char* RETENTION_NAMES[] = {"off", "oldest"};
+
+bool initStorageManager() {
+    Preferences prefs;
+    prefs.begin("storage", true);  // Read-only
+    config.maxRunSeconds = prefs.getUInt("max_run_s", STORAGE_DEFAULT_MAX_RUN_S);
+    config.quotaBytes = prefs.getUInt("quota", 0);
+    config.reserveBytes = prefs.getUInt("reserve", STORAGE_DEFAULT_RESERVE_BYTES);
+    config.retention = (RetentionMode)prefs.getUInt("retention", RETENTION_OFF);
+    config.compressFirst = prefs.getBool("compress", true);
+    config.keepStarred = prefs.getBool("keep_star", true);
+    uint64_t written = (uint64_t)prefs.getUInt("written_kb", 0) * 1024;
+    prefs.end();
+
+    // Writes counted before this (catalog snapshots) come on top
+    bytesWritten += written;
+    savedBytes = written;
+    return true;
+}
+
+const StorageConfig& getStorageConfig() {
+    return config;
+}
+
+bool setStorageConfig(const StorageConfig& newConfig) {
+    if (newConfig.maxRunSeconds == 0 || newConfig.retention > RETENTION_OLDEST) {
+        return false;
+    }
+    config = newConfig;
+
+    Preferences prefs;
+    prefs.begin("storage", false);
+    prefs.putUInt("max_run_s", config.maxRunSeconds);
+    prefs.putUInt("quota", config.quotaBytes);
+    prefs.putUInt("reserve", config.reserveBytes);
+    prefs.putUInt("retention", config.retention);
+    prefs.putBool("compress", config.compressFirst);
+    prefs.putBool("keep_star", config.keepStarred);
+    prefs.end();
+
+    scheduleStorageCleanup();
+    return true;
+}
+
+bool parseRetentionMode(const String& name, RetentionMode& mode) {
+    for (int i = RETENTION_OFF; i <= RETENTION_OLDEST; i++) {
+        if (name == RETENTION_NAMES[i]) {
+            mode = (RetentionMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* retentionModeName(RetentionMode mode) {
+    return RETENTION_NAMES[mode];
+}
+
+static uint32_t rowBytes(uint8_t channels) {
+    uint32_t bytes = THRUST_ROW_BYTES;
+    if (channels & CHANNEL_BIT(CHANNEL_TORQUE)) bytes += TORQUE_ROW_BYTES;
+    if (channels & CHANNEL_BIT(CHANNEL_RPM)) bytes += RPM_ROW_BYTES;
+    return bytes;
+}
+
+static uint32_t bytesForSeconds(uint32_t seconds, uint8_t channels) {
+    return HEADER_BYTES + (uint64_t)seconds * 1000 / SAMPLE_RATE_MS * rowBytes(channels);
+}
+
+static uint32_t secondsForBytes(uint32_t bytes, uint8_t channels) {
+    if (bytes <= HEADER_BYTES) return 0;
+    return (uint64_t)(bytes - HEADER_BYTES) / rowBytes(channels) * SAMPLE_RATE_MS / 1000;
+}
+
+// Room for the next run: free space above the reserve, and under the quota
+static uint32_t availableBytes() {
+    size_t total = LittleFS.totalBytes();
+    size_t used = LittleFS.usedBytes();
+    uint32_t available = used + config.reserveBytes < total ? total - used - config.reserveBytes : 0;
+    if (config.quotaBytes > 0) {
+        uint32_t stored = getRunStorageStats().storedBytes;
+        available = std::min<uint32_t>(available, stored < config.quotaBytes ? config.quotaBytes - stored : 0);
+    }
+    return available;
+}
+
+// Timestamp part of a data file name, "Run: <timestamp>.csv"
+static String fileTimestamp(const String& fileName) {
+    int start = fileName.lastIndexOf(": ");
+    return start >= 0 ? fileName.substring(start + 2) : fileName;
+}
+
+// Wall-clock names ("%y-%m-%d_%T") sort by date. Boot-relative ones
+// ("boot<count>+<ms>") sort by boot and time, just before the start of the
+// next boot that had the clock (run_manager.h); how much older they are is
+// unknown. Without one, they are from the last boots and sort after all.
+static String fileSortKey(const String& fileName) {
+    String timestamp = fileTimestamp(fileName);
+    if (!timestamp.startsWith("boot")) {
+        return timestamp + "|1";
+    }
+
+    char order[24];
+    unsigned long boot = strtoul(timestamp.c_str() + 4, nullptr, 10);
+    unsigned long ms = strtoul(timestamp.c_str() + timestamp.indexOf('+') + 1, nullptr, 10);
+    snprintf(order, sizeof(order), "%010lu%010lu", boot, ms);
+    time_t bound = clockedBootAfter(boot);
+    return bound ? formatTimestamp(bound) + "|0" + order : String("~") + order;
+}
+
+// Delete the oldest run file retention may delete; false if there is none
+static bool deleteOldestFile() {
+    const RunFileInfo* oldest = nullptr;
+    String oldestKey;
+    for (const RunListing& run : catalogRuns()) {
+        if (config.keepStarred && run.starred) continue;
+        for (const RunFileInfo& f : run.files) {
+            String key = fileSortKey(f.name);
+            if (!oldest || key < oldestKey) {
+                oldest = &f;
+                oldestKey = key;
+            }
+        }
+    }
+    if (!oldest) {
+        return false;
+    }
+
+    String fileName = oldest->name;
+    uint32_t storedSize = oldest->storedSize;
+    if (!deleteDataFile(fileName)) {
+        Serial.printf("Retention: failed to delete %s\n", fileName.c_str());
+        return false;
+    }
+    catalogPathChanged(runFilePath(fileName).c_str());
+    filesDeleted++;
+    Serial.printf("Retention: deleted %s (%u bytes)\n", fileName.c_str(), storedSize);
+    return true;
+}
+
+StorageCheck checkRunStorage(uint8_t channels) {
+    StorageCheck check = {true, false, bytesForSeconds(config.maxRunSeconds, channels), availableBytes(), ""};
+
+    uint32_t roomSeconds = secondsForBytes(check.availableBytes, channels);
+    uint32_t minSeconds = std::min<uint32_t>(STORAGE_MIN_RUN_S, config.maxRunSeconds);
+    if (roomSeconds < minSeconds) {
+        check.ok = false;
+        check.message = "Not enough storage: room for " + String(roomSeconds) + " s of run data, " +
+                        String(minSeconds) + " s needed";
+        runsRefused++;
+    } else if (roomSeconds < config.maxRunSeconds) {
+        check.warning = true;
+        check.message = "Storage is low: the run stops after " + String(roomSeconds) + " s";
+        runsWarned++;
+    }
+    if (check.availableBytes < check.neededBytes) {
+        scheduleStorageCleanup();
+    }
+
+    runBudget = check.availableBytes;
+    return check;
+}
+
+// Compress a step at a time, then delete a file per step, until a run of
+// maxRunSeconds fits or nothing more can be done
+void scheduleStorageCleanup() {
+    if (isJobPending("storage-cleanup")) return;
+
+    cleanupCompressing = config.compressFirst;
+    scheduleJob("storage-cleanup", JOB_PRIORITY_LOW, [](JobStatus& status) {
+        uint32_t needed = bytesForSeconds(config.maxRunSeconds, enabledChannels());
+        uint32_t available = availableBytes();
+        status.total = needed;
+        status.done = std::min(available, needed);
+        if (available >= needed) {
+            return false;
+        }
+        if (cleanupCompressing) {
+            cleanupCompressing = compressRunFilesStep();
+            return true;
+        }
+        return config.retention == RETENTION_OLDEST && deleteOldestFile();
+    });
+}
+
+void handleStorage() {
+    if (isRunActive() && getCurrentFileBytes() >= runBudget) {
+        Serial.printf("Run stopped: it has used its %u bytes of storage\n", (unsigned)runBudget);
+        runsStoppedFull++;
+        stopRun();
+    }
+}
+
+void storageNoteWrite(size_t bytes) {
+    bytesWritten += bytes;
+    if (bytesWritten - savedBytes >= STORAGE_WEAR_SAVE_BYTES) {
+        Preferences prefs;
+        prefs.begin("storage", false);
+        prefs.putUInt("written_kb", bytesWritten / 1024);
+        prefs.end();
+        savedBytes = bytesWritten;
+    }
+}
+
+StorageStats getStorageStats() {
+    StorageStats stats;
+    stats.totalBytes = LittleFS.totalBytes();
+    stats.usedBytes = LittleFS.usedBytes();
+    stats.runStoredBytes = getRunStorageStats().storedBytes;
+    stats.availableBytes = availableBytes();
+    stats.roomSeconds = secondsForBytes(stats.availableBytes, enabledChannels());
+    stats.bytesWritten = bytesWritten;
+    stats.eraseCycles = stats.totalBytes > 0 ? (float)((double)bytesWritten / stats.totalBytes) : 0.0f;
+    stats.runsRefused = runsRefused;
+    stats.runsWarned = runsWarned;
+    stats.runsStoppedFull = runsStoppedFull;
+    stats.filesDeleted = filesDeleted;
+    return stats;
+}
@@ -0,0 +1,87 @@
+// src/trace.cpp
+#include "trace.h"
+#include "config.h"
+
+struct TraceEvent {
+    uint64_t start;     // Cycles, unwrapped
+    uint32_t duration;  // Cycles
+    const char* name;
+};
+
+static TraceEvent ring[TRACE_RING_SIZE];
+static size_t head = 0;    // Next slot to write
+static size_t count = 0;
+static bool enabled = true;
+static uint64_t clock64 = 0;  // Last start seen, extended to 64 bits
+
+static String names[TRACE_MAX_NAMES];
+static size_t nameCount = 0;
+
+void traceRecord(const char* name, uint32_t startCycles, uint32_t endCycles) {
+    if (!enabled) {
+        return;
+    }
+
+    // Extend the 32-bit counter by the signed distance to the previous start.
+    // Nested scopes finish inner-first, so starts can step backwards a little.
+    if (clock64 == 0) {
+        clock64 = startCycles;
+    } else {
+        clock64 += (int32_t)(startCycles - (uint32_t)clock64);
+    }
+
+    TraceEvent& event = ring[head];
+    event.start = clock64;
+    event.duration = endCycles - startCycles;
+    event.name = name;
+
+    head = (head + 1) % TRACE_RING_SIZE;
+    if (count < TRACE_RING_SIZE) {
+        count++;
+    }
+}
+
+const char* traceName(const String& name) {
+    for (size_t i = 0; i < nameCount; i++) {
+        if (names[i] == name) {
+            return names[i].c_str();
+        }
+    }
+    if (nameCount == TRACE_MAX_NAMES) {
+        return "other";
+    }
+    names[nameCount] = name;
+    return names[nameCount++].c_str();
+}
+
+void setTraceEnabled(bool on) {
+    enabled = on;
+}
+
+bool isTraceEnabled() {
+    return enabled;
+}
+
+void clearTrace() {
+    head = 0;
+    count = 0;
+}
+
+size_t traceEventCount() {
+    return count;
+}
+
+String traceEventsJson(size_t from, size_t n) {
+    String out;
+    size_t oldest = (head + TRACE_RING_SIZE - count) % TRACE_RING_SIZE;
+    double cyclesPerUs = cyclesPerMicrosecond();
+    char buffer[160];
+
+    for (size_t i = from; i < from + n && i < count; i++) {
+        const TraceEvent& event = ring[(oldest + i) % TRACE_RING_SIZE];
+        snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                 i > from ? "," : "", event.name, event.start / cyclesPerUs, event.duration / cyclesPerUs);
+        out += buffer;
+    }
+    return out;
+}
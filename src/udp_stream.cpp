@@ -0,0 +1,162 @@
+// src/udp_stream.cpp
+#include "udp_stream.h"
+#include "stream_protocol.h"
+#include "config.h"
+#include "run_manager.h"
+#include "data_logger.h"
+#include <Preferences.h>
+#include <WiFiUdp.h>
+
+#define UDP_STAND_MAX_LENGTH 32
+
+static UdpStreamConfig config = {false, "", STREAM_UDP_PORT, UDP_DEFAULT_STAND};
+static UdpStreamStats stats = {0, 0};
+static WiFiUDP udp;
+
+// Lets the collector tell runs apart across reboots, which restart the run numbers
+static uint32_t bootId = 0;
+static uint32_t runNumber = 0;
+
+// Run whose batches are being sent
+static bool runOpen = false;
+static uint8_t runChannels = 0;
+static String runFileName;
+static String runComment;
+static uint32_t nextSequence = 0;
+static uint32_t runSamples = 0;   // Samples in the batches already sent
+
+// Batch being filled
+static unsigned long batchTimestamps[UDP_BATCH_SAMPLES];
+static ChannelSample batchSamples[UDP_BATCH_SAMPLES];
+static uint8_t batchCount = 0;
+static unsigned long batchStarted = 0;
+
+// Static: together they are too big for the loop task's stack
+static StreamUdpPayload payload;
+static uint8_t frame[STREAM_UDP_MAX_PAYLOAD + STREAM_FRAME_OVERHEAD];
+
+static void sendBatch(uint8_t flags, int copies = 1) {
+    payload.length = 0;
+    payload.putText(config.stand.c_str());
+    payload.putU32(bootId);
+    payload.putU32(runNumber);
+    payload.putU32(nextSequence++);
+    payload.putU8(flags);
+    payload.putU8(runChannels);
+    payload.putText(runFileName.c_str());
+    payload.putText(runComment.c_str());
+    payload.putU32(runSamples);
+    payload.putU8(batchCount);
+    for (uint8_t i = 0; i < batchCount; i++) {
+        payload.putU32(batchTimestamps[i]);
+        for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+            if (runChannels & CHANNEL_BIT(channel)) {
+                payload.putFloat(batchSamples[i].value[channel]);
+            }
+        }
+    }
+    runSamples += batchCount;
+    batchCount = 0;
+
+    size_t size = encodeStreamFrame(STREAM_UDP_BATCH, payload.data, payload.length, frame);
+    for (int copy = 0; copy < copies; copy++) {
+        bool sent = udp.beginPacket(config.host.c_str(), config.port) && udp.write(frame, size) == size &&
+                    udp.endPacket();
+        if (sent) {
+            stats.datagrams++;
+        } else {
+            stats.sendErrors++;
+        }
+    }
+}
+
+static void closeRun() {
+    if (!runOpen) {
+        return;
+    }
+    // The end marker carries the last samples; sent twice, as the collector
+    // otherwise only closes the run when it times out
+    sendBatch(STREAM_UDP_FLAG_END, 2);
+    runOpen = false;
+}
+
+static void openRun() {
+    runChannels = getCurrentFileChannels();
+    runFileName = getCurrentRun().currentFileName;
+    runComment = getCurrentFileComment();
+    runNumber++;
+    nextSequence = 0;
+    runSamples = 0;
+    batchCount = 0;
+    runOpen = true;
+}
+
+bool initUdpStream() {
+    bootId = esp_random();
+
+    Preferences prefs;
+    prefs.begin("stream", true);  // Read-only
+    config.enabled = prefs.getBool("udp", false);
+    config.host = prefs.getString("udp_host", "");
+    config.port = prefs.getUInt("udp_port", STREAM_UDP_PORT);
+    config.stand = prefs.getString("stand", UDP_DEFAULT_STAND);
+    prefs.end();
+    return true;
+}
+
+const UdpStreamConfig& getUdpStreamConfig() {
+    return config;
+}
+
+bool setUdpStreamConfig(const UdpStreamConfig& newConfig) {
+    if ((newConfig.enabled && newConfig.host.length() == 0) || newConfig.port == 0 ||
+        newConfig.stand.length() == 0 || newConfig.stand.length() > UDP_STAND_MAX_LENGTH) {
+        return false;
+    }
+    // Whatever was sent so far ends at the old destination
+    closeRun();
+    config = newConfig;
+
+    Preferences prefs;
+    prefs.begin("stream", false);
+    prefs.putBool("udp", config.enabled);
+    prefs.putString("udp_host", config.host);
+    prefs.putUInt("udp_port", config.port);
+    prefs.putString("stand", config.stand);
+    prefs.end();
+    return true;
+}
+
+UdpStreamStats getUdpStreamStats() {
+    return stats;
+}
+
+void udpStreamSample(const ChannelSample& sample, unsigned long timestamp) {
+    if (!config.enabled) {
+        return;
+    }
+    // The first sample of a run opens it, whoever started the run
+    if (!runOpen) {
+        openRun();
+    }
+
+    if (batchCount == 0) {
+        batchStarted = millis();
+    }
+    batchTimestamps[batchCount] = timestamp;
+    batchSamples[batchCount] = sample;
+    if (++batchCount == UDP_BATCH_SAMPLES) {
+        sendBatch(0);
+    }
+}
+
+void handleUdpStream() {
+    if (!runOpen) {
+        return;
+    }
+    if (!isRunActive()) {
+        closeRun();
+    } else if (batchCount > 0 && millis() - batchStarted >= UDP_BATCH_MAX_MS) {
+        sendBatch(0);
+    }
+}
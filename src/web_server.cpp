@@ -2,11 +2,30 @@
 #include "web_server.h"
 #include "config.h"
 #include "run_manager.h"
+#include "run_catalog.h"
+#include "run_compression.h"
+#include "storage_manager.h"
 #include "data_logger.h"
 #include "chart_manager.h"
+#include "file_ops.h"
+#include "job_scheduler.h"
+#include "admission.h"
+#include "load_cell.h"
+#include "sim_load_cell.h"
+#include "run_trigger.h"
+#include "zero_tracker.h"
+#include "channels.h"
+#include "serial_stream.h"
+#include "udp_stream.h"
+#include "trace.h"
+#include "metrics.h"
+#include "json_writer.h"
+#include "zip_stream.h"
+#include "request_arena.h"
 #include "upload_page.h"
 #include <WebServer.h>
 #include <LittleFS.h>
+#include <algorithm>
 #include <ArduinoJson.h>
 
 // This is not static because it is externed in wifi_manager.cpp
@@ -16,6 +35,7 @@ WebServer server(WEB_SERVER_PORT);
 void handleFileUpload();
 void handleFileUploadComplete();
 void handleNotFound();
+void serveNotFound();
 void handleRoot();
 void handleUploadPage();
 void handleRunsAPI(String path);
@@ -46,6 +66,132 @@ void handleDeleteChartWithName(const String& chartName);
 void handleGenerateChartData();
 void handleExportChart();
 void handleListFiles();
+void handleFileBatch();
+void handleFileBatchStatus();
+void handleGetLoadCellSource();
+void handleSetLoadCellSource();
+void handleGetTrigger();
+void handleSetTrigger();
+void handleGetChannels();
+void handleSetChannels();
+void handleGetStream();
+void handleSetStream();
+void handleSync();
+void handleGetStorage();
+void handleSetStorage();
+void handleGetTrace();
+void handleGetMetrics();
+
+// JSON response written through a stack buffer: sent whole if it fits, chunked from the first overflow on
+class JsonResponse : public StackJsonWriter<JSON_RESPONSE_BUFFER> {
+public:
+    JsonResponse() : StackJsonWriter(streamChunk, this), streaming(false) {}
+    
+    void send() {
+        if (streaming) {
+            flush();
+            server.sendContent("");
+        } else {
+            server.send(200, "application/json", c_str());
+        }
+    }
+    
+private:
+    static void streamChunk(void* context, const char* data, size_t length) {
+        JsonResponse* response = (JsonResponse*)context;
+        if (!response->streaming) {
+            server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+            server.send(200, "application/json", "");
+            response->streaming = true;
+        }
+        server.sendContent(data, length);
+    }
+    
+    bool streaming;
+};
+
+// Run a handler under admission control, answering 503 + Retry-After if its class is refused.
+// route names the handler in traces and metrics; it must be a fixed label, not a raw path with parameters.
+static void runAdmitted(RequestClass requestClass, const String& route, const std::function<void(void)>& handler) {
+    const char* routeName = traceName(route);
+    TRACE_SCOPE(routeName);
+    
+    if (!admitRequest(requestClass)) {
+        server.sendHeader("Retry-After", String(BUSY_RETRY_AFTER_S));
+        server.send(503, "text/plain", "Busy: a run is in progress");
+        return;
+    }
+    
+    requestStarted(requestClass);
+    unsigned long start = micros();
+    {
+        // Whatever the handler took from the arena goes back as it returns
+        RequestArenaScope arenaScope;
+        handler();
+    }
+    unsigned long elapsed = micros() - start;
+    requestFinished(requestClass, elapsed);
+    metricObserveRoute(routeName, elapsed);
+}
+
+static void streamFileBytes(RunFileReader& file, size_t remaining) {
+    uint8_t buffer[1024];
+    while (remaining > 0) {
+        size_t n = file.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+        if (n == 0) break;
+        server.sendContent((const char*)buffer, n);
+        remaining -= n;
+    }
+}
+
+// Send a file, or the one byte range a Range header asks for ("bytes=a-b", "bytes=a-" or "bytes=-n").
+// Lets clients resume an interrupted download; multipart ranges get the whole file.
+// Compressed run files go out as the CSV they hold, and ranges are of the CSV.
+static void streamFileRange(RunFileReader& file, const String& contentType) {
+    size_t size = file.size();
+    String range = server.header("Range");
+    server.sendHeader("Accept-Ranges", "bytes");
+    size_t start = 0;
+    size_t end = size - 1;
+    if (!range.startsWith("bytes=") || range.indexOf(',') >= 0 || range.indexOf('-') < 0) {
+        server.setContentLength(size);
+        server.send(200, contentType, "");
+        streamFileBytes(file, size);
+        return;
+    }
+    
+    String first = range.substring(6, range.indexOf('-'));
+    String last = range.substring(range.indexOf('-') + 1);
+    if (first.length() == 0) {
+        // Suffix: the last n bytes
+        size_t n = strtoul(last.c_str(), nullptr, 10);
+        start = n < size ? size - n : 0;
+        end = size - 1;
+    } else {
+        start = strtoul(first.c_str(), nullptr, 10);
+        end = last.length() > 0 ? strtoul(last.c_str(), nullptr, 10) : size - 1;
+        if (end >= size) end = size - 1;
+    }
+    if (size == 0 || start >= size || start > end) {
+        server.sendHeader("Content-Range", "bytes */" + String((unsigned long)size));
+        server.send(416, "text/plain", "Range Not Satisfiable");
+        return;
+    }
+    
+    server.sendHeader("Content-Range", "bytes " + String((unsigned long)start) + "-" + String((unsigned long)end) +
+                                          "/" + String((unsigned long)size));
+    server.setContentLength(end - start + 1);
+    server.send(206, contentType, "");
+    file.seek(start);
+    streamFileBytes(file, end - start + 1);
+}
+
+static std::function<void(void)> admitted(RequestClass requestClass, std::function<void(void)> handler) {
+    return [requestClass, handler]() {
+        // Registered routes match exactly, so the URI is a fixed label
+        runAdmitted(requestClass, server.uri(), handler);
+    };
+}
 
 bool initWebServer() {
     // Create web directory if it doesn't exist
@@ -56,73 +202,119 @@ bool initWebServer() {
         }
     }
     
+    // Range requests on downloads (streamFileRange)
+    const char* headerKeys[] = {"Range"};
+    server.collectHeaders(headerKeys, 1);
+    
     // Serve root
-    server.on("/", HTTP_GET, handleRoot);
+    server.on("/", HTTP_GET, admitted(REQUEST_STANDARD, handleRoot));
     
     // Dedicated upload page endpoint (always accessible)
-    server.on("/upload", HTTP_GET, handleUploadPage);
+    server.on("/upload", HTTP_GET, admitted(REQUEST_STANDARD, handleUploadPage));
     
     // File upload endpoint
-    server.on("/upload", HTTP_POST, handleFileUploadComplete, handleFileUpload);
+    server.on("/upload", HTTP_POST, admitted(REQUEST_HEAVY, handleFileUploadComplete), handleFileUpload);
     
     // Run management API
-    server.on("/api/runs", HTTP_GET, handleGetRuns);
-    server.on("/api/runs", HTTP_POST, handleCreateRun);
-    server.on("/api/runs/current", HTTP_GET, handleGetCurrentRun);
-    server.on("/api/runs/stop", HTTP_POST, handleStopRun);
+    server.on("/api/runs", HTTP_GET, admitted(REQUEST_STANDARD, handleGetRuns));
+    server.on("/api/runs", HTTP_POST, admitted(REQUEST_STANDARD, handleCreateRun));
+    server.on("/api/runs/current", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetCurrentRun));
+    server.on("/api/runs/stop", HTTP_POST, admitted(REQUEST_CRITICAL, handleStopRun));
+    server.on("/api/sync", HTTP_GET, admitted(REQUEST_STANDARD, handleSync));
+    server.on("/api/storage", HTTP_GET, admitted(REQUEST_STANDARD, handleGetStorage));
+    server.on("/api/storage", HTTP_POST, admitted(REQUEST_STANDARD, handleSetStorage));
+    server.on("/api/catalog/rebuild", HTTP_POST, admitted(REQUEST_STANDARD, []() {
+        int jobId = scheduleCatalogRebuild();
+        server.send(202, "application/json", "{\"success\":true,\"job\":" + String(jobId) + "}");
+    }));
+    
+    // Background jobs
+    server.on("/api/jobs", HTTP_GET, admitted(REQUEST_CRITICAL, []() {
+        server.send(200, "application/json", getJobsStatus());
+    }));
+    server.on("/api/jobs/cancel", HTTP_POST, admitted(REQUEST_STANDARD, []() {
+        if (cancelJob(server.arg("id").toInt())) {
+            server.send(200, "application/json", "{\"success\":true}");
+        } else {
+            server.send(404, "text/plain", "Job not found");
+        }
+    }));
+    
+    // Load cell source (hardware or simulator)
+    server.on("/api/loadcell/source", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetLoadCellSource));
+    server.on("/api/loadcell/source", HTTP_POST, admitted(REQUEST_STANDARD, handleSetLoadCellSource));
+    
+    // Headless start/stop trigger
+    server.on("/api/trigger", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetTrigger));
+    server.on("/api/trigger", HTTP_POST, admitted(REQUEST_CRITICAL, handleSetTrigger));
+    server.on("/api/channels", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetChannels));
+    server.on("/api/channels", HTTP_POST, admitted(REQUEST_CRITICAL, handleSetChannels));
+    
+    // Sample streams: USB serial and UDP to a collector
+    server.on("/api/stream", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetStream));
+    server.on("/api/stream", HTTP_POST, admitted(REQUEST_CRITICAL, handleSetStream));
+    
+    // Prometheus metrics
+    server.on("/metrics", HTTP_GET, admitted(REQUEST_CRITICAL, handleGetMetrics));
+    
+    // Trace ring in Chrome trace_event JSON (?enable=0|1, ?clear=1)
+    server.on("/api/debug/trace", HTTP_GET, admitted(REQUEST_STANDARD, handleGetTrace));
+    
+    // Admission control counters
+    server.on("/api/admission", HTTP_GET, admitted(REQUEST_CRITICAL, []() {
+        server.send(200, "application/json", getAdmissionStats());
+    }));
     
     // Chart API
     //server.on("/api/charts", HTTP_GET, handleGetCharts);
     //server.on("/api/charts", HTTP_POST, handleCreateChart);
-    server.on("/api/charts/data", HTTP_POST, handleGenerateChartData);
-    //server.on("/api/charts/export", HTTP_POST, handleExportChart);
+    server.on("/api/charts/data", HTTP_POST, admitted(REQUEST_HEAVY, handleGenerateChartData));
+    server.on("/api/charts/export", HTTP_POST, admitted(REQUEST_HEAVY, handleExportChart));
     
     // File list endpoint for upload page
-    server.on("/api/files", HTTP_GET, []() {
+    server.on("/api/files", HTTP_GET, admitted(REQUEST_STANDARD, []() {
         File dir = LittleFS.open("/web");
-        String files = "[";
+        JsonResponse files;
+        files.beginArray();
         if (dir && dir.isDirectory()) {
             File file = dir.openNextFile();
-            bool first = true;
             while (file) {
                 if (!file.isDirectory()) {
-                    if (!first) files += ",";
-                    files += "\"" + String(file.name()) + "\"";
-                    first = false;
+                    files.value(file.name());
                 }
                 file = dir.openNextFile();
             }
         }
-        files += "]";
-        server.send(200, "application/json", files);
-    });
+        files.endArray();
+        files.send();
+    }));
     
     // Serve static files from /web directory
     server.onNotFound(handleNotFound);
 
     // Explorer endpoints
-        server.on("/listfiles", HTTP_GET, handleListFiles);
+    server.on("/listfiles", HTTP_GET, admitted(REQUEST_HEAVY, handleListFiles));
     // --- DOWNLOAD HANDLER ---
-    server.on("/download", HTTP_GET, []() {
+    server.on("/download", HTTP_GET, admitted(REQUEST_HEAVY, []() {
         String path = server.arg("path");
         if (path == "" || !LittleFS.exists(path)) {
             server.send(404, "text/plain", "File Not Found");
             return;
         }
         
-        File file = LittleFS.open(path, "r");
+        RunFileReader file(path.c_str());
         if (file.isDirectory()) {
             server.send(403, "text/plain", "Cannot download a directory");
             return;
         }
 
         // This streams the file directly to the browser
-        server.streamFile(file, "application/octet-stream");
+        streamFileRange(file, "application/octet-stream");
         file.close();
-    });
+    }));
 
     // --- DELETE HANDLER ---
-    server.on("/delete", HTTP_DELETE, []() {
+    server.on("/delete", HTTP_DELETE, admitted(REQUEST_STANDARD, []() {
         String path = server.arg("path");
         if (path == "" || !LittleFS.exists(path)) {
             server.send(404, "text/plain", "Path Not Found");
@@ -132,14 +324,20 @@ bool initWebServer() {
         // LittleFS.remove() works for files, LittleFS.rmdir() for folders
         // Note: rmdir only works if the directory is empty!
         if (LittleFS.remove(path) || LittleFS.rmdir(path)) {
+            catalogPathChanged(path);
             server.send(200, "text/plain", "Deleted");
         } else {
             server.send(500, "text/plain", "Delete Failed (Folder might not be empty)");
         }
-    });
+    }));
+
+    // --- BATCH HANDLERS ---
+    // Not heavy: batches queue themselves as background jobs during a run
+    server.on("/api/files/batch", HTTP_POST, admitted(REQUEST_STANDARD, handleFileBatch));
+    server.on("/api/files/batch", HTTP_GET, admitted(REQUEST_STANDARD, handleFileBatchStatus));
 
     // --- RENAME HANDLER ---
-    server.on("/rename", HTTP_POST, []() {
+    server.on("/rename", HTTP_POST, admitted(REQUEST_STANDARD, []() {
         String oldPath = server.arg("old");
         String newPath = server.arg("new");
         
@@ -149,11 +347,15 @@ bool initWebServer() {
         }
 
         if (LittleFS.rename(oldPath, newPath)) {
+            catalogBeginBatch();
+            catalogPathChanged(oldPath);
+            catalogPathChanged(newPath);
+            catalogCommit();
             server.send(200, "text/plain", "Renamed");
         } else {
             server.send(500, "text/plain", "Rename Failed");
         }
-    });
+    }));
 
     server.begin();
     Serial.println("Web server started on port " + String(WEB_SERVER_PORT));
@@ -189,6 +391,10 @@ void handleFileUpload() {
     
     if (upload.status == UPLOAD_FILE_START) {
         String filename = "/web/" + String(upload.filename);
+        if (isRunActive()) {
+            // Refused by admission control - don't write flash while recording
+            return;
+        }
         Serial.println("Upload start: " + filename);
         uploadFile = LittleFS.open(filename, "w");
     } else if (upload.status == UPLOAD_FILE_WRITE) {
@@ -208,6 +414,19 @@ void handleFileUploadComplete() {
 }
 
 void handleNotFound() {
+    // Reading a whole data file is heavy; the other path-parameter routes and static files are not
+    RequestClass requestClass = REQUEST_STANDARD;
+    if (server.uri().startsWith("/api/data/") && server.method() == HTTP_GET) {
+        requestClass = REQUEST_HEAVY;
+    }
+    
+    String route = "static";
+    if (server.uri().startsWith("/api/runs/")) route = "/api/runs/*";
+    else if (server.uri().startsWith("/api/data/")) route = "/api/data/*";
+    runAdmitted(requestClass, route, serveNotFound);
+}
+
+void serveNotFound() {
     String path = server.uri();
     
     // Handle API routes with path parameters
@@ -362,8 +581,79 @@ void handleChartsAPI(String path) {
 // API Handlers
 
 void handleGetRuns() {
-    String json = getRunConfigsList();
-    server.send(200, "application/json", json);
+    // Plain /api/runs keeps the original config-only array
+    if (!server.hasArg("include")) {
+        String json = getRunConfigsList();
+        server.send(200, "application/json", json);
+        return;
+    }
+    
+    // /api/runs?include=files,summary&sort=date|-date&offset=N&limit=N
+    String include = server.arg("include");
+    bool withFiles = include.indexOf("files") >= 0;
+    bool withSummary = include.indexOf("summary") >= 0;
+    bool newestFirst = server.arg("sort") == "-date";
+    int offset = server.arg("offset").toInt();
+    int limit = server.arg("limit").toInt();  // 0 = no limit
+    
+    std::vector<const RunListing*> runs = listRunsWithFiles(newestFirst);
+    int total = runs.size();
+    if (offset < 0) offset = 0;
+    if (offset > total) offset = total;
+    int end = (limit > 0 && offset + limit < total) ? offset + limit : total;
+    
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent("{\"total\":" + String(total) + ",\"offset\":" + String(offset) + ",\"runs\":[");
+    
+    // One run per chunk keeps the JSON document small regardless of run count
+    for (int i = offset; i < end; i++) {
+        const RunListing& run = *runs[i];
+        JsonDocument doc;
+        doc["name"] = run.name;
+        doc["notes"] = run.notes;
+        doc["created"] = run.created;
+        doc["starred"] = run.starred;
+        doc["deleting"] = isRunDeleting(run.name);
+        doc["recovered"] = std::any_of(run.files.begin(), run.files.end(),
+                                       [](const RunFileInfo& f) { return f.recovered; });
+        
+        if (withFiles) {
+            JsonArray files = doc["files"].to<JsonArray>();
+            for (const RunFileInfo& f : run.files) {
+                JsonObject fileObj = files.add<JsonObject>();
+                fileObj["name"] = f.name;
+                fileObj["size"] = f.size;
+                fileObj["samples"] = f.stats.samples;
+                fileObj["durationMs"] = f.stats.durationMs;
+                fileObj["peakThrust"] = f.stats.peakThrust;
+                fileObj["recovered"] = f.recovered;
+            }
+        }
+        if (withSummary) {
+            JsonObject summary = doc["summary"].to<JsonObject>();
+            summary["fileCount"] = run.files.size();
+            summary["totalBytes"] = run.totalBytes;
+            summary["lastFile"] = run.files.empty() ? String("") : run.files.back().name;
+            
+            uint32_t samples = 0;
+            float peakThrust = 0.0;
+            for (const RunFileInfo& f : run.files) {
+                samples += f.stats.samples;
+                peakThrust = max(peakThrust, f.stats.peakThrust);
+            }
+            summary["samples"] = samples;
+            summary["peakThrust"] = peakThrust;
+        }
+        
+        String output;
+        serializeJson(doc, output);
+        if (i > offset) server.sendContent(",");
+        server.sendContent(output);
+    }
+    
+    server.sendContent("]}");
+    server.sendContent("");
 }
 
 void handleCreateRun() {
@@ -374,7 +664,7 @@ void handleCreateRun() {
 
     Serial.println("POST body: " + server.arg("plain"));
     
-    JsonDocument doc;
+    JsonDocument doc(arenaAllocator());
     DeserializationError error = deserializeJson(doc, server.arg("plain"));
     
     if (error) {
@@ -407,9 +697,16 @@ void handleUpdateRun() {
     }
     
     String runName = doc["name"].as<String>();
-    String notes = doc["notes"].as<String>();
+    // {"notes":"..."} and/or {"starred":true}
+    bool ok = true;
+    if (!doc["notes"].isNull()) {
+        ok = updateRunNotes(runName, doc["notes"].as<String>());
+    }
+    if (ok && !doc["starred"].isNull()) {
+        ok = setRunStarred(runName, doc["starred"].as<bool>());
+    }
     
-    if (updateRunNotes(runName, notes)) {
+    if (ok) {
         server.send(200, "application/json", "{\"success\":true}");
     } else {
         server.send(500, "text/plain", "Failed to update run");
@@ -430,9 +727,16 @@ void handleUpdateRunWithName(const String& runName) {
         return;
     }
     
-    String notes = doc["notes"].as<String>();
+    // {"notes":"..."} and/or {"starred":true}
+    bool ok = true;
+    if (!doc["notes"].isNull()) {
+        ok = updateRunNotes(runName, doc["notes"].as<String>());
+    }
+    if (ok && !doc["starred"].isNull()) {
+        ok = setRunStarred(runName, doc["starred"].as<bool>());
+    }
     
-    if (updateRunNotes(runName, notes)) {
+    if (ok) {
         server.send(200, "application/json", "{\"success\":true}");
     } else {
         server.send(500, "text/plain", "Failed to update run");
@@ -456,10 +760,19 @@ void handleStartRun() {
 }
 
 void handleStartRunWithName(const String& runName) {
-    if (startRun(runName)) {
-        server.send(200, "application/json", "{\"success\":true}");
-    } else {
+    StorageCheck storage = {true, false, 0, 0, ""};
+    bool started = startRun(runName, &storage);
+    if (!started && !storage.ok) {
+        server.send(507, "text/plain", storage.message);
+    } else if (!started) {
         server.send(500, "text/plain", "Failed to start run");
+    } else if (storage.warning) {
+        // Started, but the user should know when the run will stop
+        JsonResponse json;
+        json.beginObject().field("success", true).field("warning", storage.message).endObject();
+        json.send();
+    } else {
+        server.send(200, "application/json", "{\"success\":true}");
     }
 }
 
@@ -477,13 +790,13 @@ void handleGetDataFile() {
 }
 
 void handleGetDataFileWithName(const String& fileName) {
-    String content = readDataFile(fileName);
-    
-    if (content.length() > 0) {
-        server.send(200, "text/csv", content);
-    } else {
+    RunFileReader file(runFilePath(fileName).c_str());
+    if (!file || file.isDirectory() || file.size() == 0) {
         server.send(404, "text/plain", "File not found");
+        return;
     }
+    streamFileRange(file, "text/csv");
+    file.close();
 }
 
 void handleDeleteDataFile() {
@@ -492,6 +805,7 @@ void handleDeleteDataFile() {
 
 void handleDeleteDataFileWithName(const String& fileName) {
     if (deleteDataFile(fileName)) {
+        catalogPathChanged(String(runFilePath(fileName).c_str()));
         server.send(200, "application/json", "{\"success\":true}");
     } else {
         server.send(500, "text/plain", "Failed to delete file");
@@ -547,18 +861,18 @@ void handleStopRun() {
 }
 
 void handleGetCurrentRun() {
-    RunConfig run = getCurrentRun();
-    
-    JsonDocument doc;
-    doc["name"] = run.name;
-    doc["notes"] = run.notes;
-    doc["isActive"] = run.isActive;
-    doc["startTime"] = run.startTime;
-    doc["currentFileName"] = run.currentFileName;
+    const RunConfig& run = getCurrentRun();
     
-    String output;
-    serializeJson(doc, output);
-    server.send(200, "application/json", output);
+    // Polled throughout a run, so built without heap allocations
+    JsonResponse response;
+    response.beginObject()
+        .field("name", run.name)
+        .field("notes", run.notes)
+        .field("isActive", run.isActive)
+        .field("startTime", run.startTime)
+        .field("currentFileName", run.currentFileName)
+        .endObject();
+    response.send();
 }
 
 /*
@@ -608,7 +922,7 @@ void handleGenerateChartData() {
         return;
     }
     
-    JsonDocument doc;
+    JsonDocument doc(arenaAllocator());
     DeserializationError error = deserializeJson(doc, server.arg("plain"));
     
     if (error) {
@@ -629,16 +943,151 @@ void handleGenerateChartData() {
         fileNames[i] = filesArray[i].as<String>();
     }
     
-    String chartData = generateChartData(fileNames, fileCount);
-    server.send(200, "application/json", chartData);
+    ChartChannel channel = CHART_THRUST;
+    if (!doc["channel"].isNull() && !parseChartChannel(doc["channel"].as<String>(), channel)) {
+        server.send(400, "text/plain", "Unknown channel");
+        return;
+    }
+    
+    size_t length;
+    const char* chartData = generateChartData(fileNames, fileCount, length, channel);
+    if (!chartData) {
+        server.send(503, "text/plain", "Out of memory");
+        return;
+    }
+    server.setContentLength(length);
+    server.send(200, "application/json", "");
+    server.sendContent(chartData, length);
 }
-/*
+
+static void sendZipChunk(void*, const uint8_t* data, size_t length) {
+    server.sendContent((const char*)data, length);
+}
+
+static void zipJsonChunk(void* context, const char* data, size_t length) {
+    ((ZipStreamWriter*)context)->write((const uint8_t*)data, length);
+}
+
+// Copy a LittleFS file into the current ZIP entry
+static void zipFileContents(ZipStreamWriter& zip, const String& path) {
+    RunFileReader file(path.c_str());
+    uint8_t buffer[512];
+    size_t n;
+    while (file && (n = file.read(buffer, sizeof(buffer))) > 0) {
+        zip.write(buffer, n);
+    }
+}
+
+// Body: {"runs":["Run A"],"files":["Run B: 24-05-01_10:00:00.csv"],"channel":"thrust"}
+// Streams a ZIP as it is built: per run, its config and the data files asked
+// for (all of them for "runs"), then summary.json with each file's stats and
+// chart.json, the /api/charts/data dataset of the first 10 files.
 void handleExportChart() {
-    // TODO: Implement ZIP export functionality
-    // This requires a ZIP library or manual ZIP creation
-    server.send(501, "text/plain", "Export not yet implemented");
+    JsonDocument doc(arenaAllocator());
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    ChartChannel channel = CHART_THRUST;
+    if (!doc["channel"].isNull() && !parseChartChannel(doc["channel"].as<String>(), channel)) {
+        server.send(400, "text/plain", "Unknown channel");
+        return;
+    }
+    
+    // Selected files, grouped by run in catalog order
+    std::vector<std::pair<const RunListing*, const RunFileInfo*>> selected;
+    std::vector<const RunListing*> selectedRuns;
+    JsonArray runNames = doc["runs"];
+    JsonArray fileNames = doc["files"];
+    for (const RunListing& run : catalogRuns()) {
+        bool wholeRun = false;
+        for (JsonVariant name : runNames) {
+            wholeRun = wholeRun || run.name == name.as<String>();
+        }
+        bool any = wholeRun;
+        for (const RunFileInfo& f : run.files) {
+            bool picked = wholeRun;
+            for (JsonVariant name : fileNames) {
+                picked = picked || f.name == name.as<String>();
+            }
+            if (picked) {
+                selected.push_back(std::make_pair(&run, &f));
+                any = true;
+            }
+        }
+        if (any) {
+            selectedRuns.push_back(&run);
+        }
+    }
+    // Configs, files, summary and chart; the files get what the others leave
+    size_t maxFiles = selectedRuns.size() + 2 < EXPORT_MAX_ENTRIES ? EXPORT_MAX_ENTRIES - 2 - selectedRuns.size() : 0;
+    if (selected.empty() || selected.size() > maxFiles) {
+        server.send(400, "text/plain", "Select between 1 and " + String(maxFiles) + " files from " +
+                    String(selectedRuns.size()) + " runs: an export holds " + String(EXPORT_MAX_ENTRIES) +
+                    " entries, including a config per run, the summary and the chart");
+        return;
+    }
+    
+    server.sendHeader("Content-Disposition", "attachment; filename=\"thrustplotter-export.zip\"");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/zip", "");
+    ZipStreamWriter zip(sendZipChunk, nullptr);
+    
+    for (const RunListing* run : selectedRuns) {
+        String folder = sanitizeFilename(run->name) + "/";
+        zip.beginEntry((folder + "config.json").c_str());
+        zipFileContents(zip, String(CONFIGS_DIR) + "/" + sanitizeFilename(run->name) + ".json");
+        
+        for (const auto& entry : selected) {
+            if (entry.first != run) continue;
+            // ':' from the timestamp is not allowed in Windows file names
+            String name = entry.second->name;
+            name.replace(":", "-");
+            zip.beginEntry((folder + name).c_str());
+            zipFileContents(zip, String(runFilePath(entry.second->name).c_str()));
+        }
+    }
+    
+    zip.beginEntry("summary.json");
+    {
+        StackJsonWriter<256> json(zipJsonChunk, &zip);
+        json.beginArray();
+        for (const auto& entry : selected) {
+            const RunFileInfo& f = *entry.second;
+            json.beginObject()
+                .field("run", entry.first->name)
+                .field("file", f.name)
+                .field("size", (unsigned long)f.size);
+            if (f.hasStats) {
+                json.field("samples", f.stats.samples)
+                    .field("durationMs", f.stats.durationMs)
+                    .field("peakThrust", f.stats.peakThrust, 2);
+            }
+            json.endObject();
+        }
+        json.endArray();
+        json.flush();
+    }
+    
+    String chartFiles[10];
+    int chartFileCount = 0;
+    for (const auto& entry : selected) {
+        if (chartFileCount == 10) break;
+        chartFiles[chartFileCount++] = entry.second->name;
+    }
+    zip.beginEntry("chart.json");
+    {
+        StackJsonWriter<256> json(zipJsonChunk, &zip);
+        writeChartData(json, chartFiles, chartFileCount, channel);
+        json.flush();
+    }
+    
+    zip.finish();
+    server.sendContent("");
 }
-*/
+
 void streamFileJson(WebServer &server, String path) {
     File root = LittleFS.open(path);
     if (!root || !root.isDirectory()) return;
@@ -682,3 +1131,464 @@ void handleListFiles() {
     // 3. Send an empty string to signal the end of the response
     server.sendContent(""); 
 }
+
+// Body: {"ops":[{"op":"delete","path":"..."},{"op":"rename","path":"...","to":"..."},{"op":"archive","path":"..."}]}
+void handleFileBatch() {
+    if (!server.hasArg("plain")) {
+        server.send(400, "text/plain", "Missing body");
+        return;
+    }
+    
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    std::vector<FileOp> ops;
+    for (JsonObject item : doc["ops"].as<JsonArray>()) {
+        FileOp op;
+        if (!parseFileOpType(item["op"].as<String>(), op.type)) {
+            server.send(400, "text/plain", "Unknown op: " + item["op"].as<String>());
+            return;
+        }
+        op.path = item["path"].as<String>();
+        op.target = item["to"] | "";
+        op.done = false;
+        op.ok = false;
+        ops.push_back(op);
+    }
+    
+    if (ops.empty()) {
+        server.send(400, "text/plain", "No operations");
+        return;
+    }
+    
+    int batchId = submitFileBatch(ops);
+    
+    // Small batches finish inline; anything else is worked off in the background
+    if (ops.size() <= FILE_BATCH_INLINE_MAX && !isRunActive()) {
+        finishFileBatch(batchId);
+        server.send(200, "application/json", getFileBatchStatus(batchId));
+    } else {
+        server.send(202, "application/json", getFileBatchStatus(batchId));
+    }
+}
+
+void handleFileBatchStatus() {
+    String status = getFileBatchStatus(server.arg("id").toInt());
+    
+    if (status.length() > 0) {
+        server.send(200, "application/json", status);
+    } else {
+        server.send(404, "text/plain", "Batch not found");
+    }
+}
+
+void handleGetLoadCellSource() {
+    const SimLoadCellConfig& sim = getSimLoadCellConfig();
+    
+    JsonDocument doc;
+    doc["source"] = getLoadCellDriverName();
+    doc["ready"] = isLoadCellReady();
+    doc["tareCounts"] = getTareOffset();
+    ZeroTrackerStatus zero = getZeroTrackerStatus();
+    JsonObject zeroObj = doc["zeroTracking"].to<JsonObject>();
+    zeroObj["tracking"] = zero.tracking;
+    zeroObj["updates"] = zero.updates;
+    zeroObj["driftCounts"] = zero.driftCounts;
+    zeroObj["driftGrams"] = zero.driftGrams;
+    JsonObject simObj = doc["sim"].to<JsonObject>();
+    simObj["curve"] = simCurveName(sim.curve);
+    simObj["replay"] = sim.replayFile;
+    simObj["amplitude"] = sim.amplitude;
+    simObj["delay"] = sim.delayMs;
+    simObj["duration"] = sim.durationMs;
+    simObj["tau"] = sim.decayTauMs;
+    simObj["noise"] = sim.noiseGrams;
+    simObj["hum"] = sim.humGrams;
+    simObj["humHz"] = sim.humHz;
+    simObj["drift"] = sim.driftGramsPerMin;
+    simObj["dropout"] = sim.dropoutRate;
+    simObj["sps"] = sim.samplesPerSecond;
+    simObj["repeat"] = sim.repeat;
+    simObj["seed"] = sim.seed;
+    
+    String response;
+    serializeJson(doc, response);
+    server.send(200, "application/json", response);
+}
+
+// Body: {"source":"hx711"} or {"source":"sim","curve":"decay","amplitude":800,...};
+// omitted simulator fields keep their current values
+void handleSetLoadCellSource() {
+    if (isRunActive()) {
+        server.send(409, "text/plain", "Cannot change the load cell source during a run");
+        return;
+    }
+    
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    String source = doc["source"] | "sim";
+    if (source != "sim") {
+        setLoadCellDriver(hardwareLoadCellDriver());
+        handleGetLoadCellSource();
+        return;
+    }
+    
+    SimLoadCellConfig sim = getSimLoadCellConfig();
+    if (!doc["curve"].isNull() && !parseSimCurve(doc["curve"].as<String>(), sim.curve)) {
+        server.send(400, "text/plain", "Unknown curve: " + doc["curve"].as<String>());
+        return;
+    }
+    sim.replayFile = doc["replay"] | sim.replayFile;
+    sim.amplitude = doc["amplitude"] | sim.amplitude;
+    sim.delayMs = doc["delay"] | sim.delayMs;
+    sim.durationMs = doc["duration"] | sim.durationMs;
+    sim.decayTauMs = doc["tau"] | sim.decayTauMs;
+    sim.noiseGrams = doc["noise"] | sim.noiseGrams;
+    sim.humGrams = doc["hum"] | sim.humGrams;
+    sim.humHz = doc["humHz"] | sim.humHz;
+    sim.driftGramsPerMin = doc["drift"] | sim.driftGramsPerMin;
+    sim.dropoutRate = doc["dropout"] | sim.dropoutRate;
+    sim.samplesPerSecond = doc["sps"] | sim.samplesPerSecond;
+    sim.repeat = doc["repeat"] | sim.repeat;
+    sim.seed = doc["seed"] | sim.seed;
+    
+    if (!configureSimLoadCell(sim)) {
+        server.send(400, "text/plain", "Cannot load replay file");
+        return;
+    }
+    setLoadCellDriver(simLoadCellDriver());
+    handleGetLoadCellSource();
+}
+
+void handleGetTrigger() {
+    const RunTriggerConfig& config = getRunTriggerConfig();
+    
+    JsonResponse json;
+    json.beginObject()
+        .field("state", triggerStateName(getTriggerState()))
+        .field("runName", config.runName)
+        .field("startThreshold", config.startThreshold, 1)
+        .field("armAtBoot", config.armAtBoot)
+        .field("autoStop", config.autoStop)
+        .field("stopThreshold", config.stopThreshold, 1)
+        .field("stopHoldMs", config.stopHoldMs)
+        .field("clockSet", isClockSet())
+        .endObject();
+    json.send();
+}
+
+// Body: {"runName":"...","startThreshold":20,"armAtBoot":false,"autoStop":true,"stopThreshold":5,
+// "stopHoldMs":2000,"arm":true}; all fields optional
+void handleSetTrigger() {
+    JsonDocument doc(arenaAllocator());
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    RunTriggerConfig config = getRunTriggerConfig();
+    config.runName = doc["runName"] | config.runName;
+    config.startThreshold = doc["startThreshold"] | config.startThreshold;
+    config.armAtBoot = doc["armAtBoot"] | config.armAtBoot;
+    config.autoStop = doc["autoStop"] | config.autoStop;
+    config.stopThreshold = doc["stopThreshold"] | config.stopThreshold;
+    config.stopHoldMs = doc["stopHoldMs"] | config.stopHoldMs;
+    if (!setRunTriggerConfig(config)) {
+        server.send(400, "text/plain", "Invalid trigger settings");
+        return;
+    }
+    
+    if (!doc["arm"].isNull()) {
+        if (!doc["arm"].as<bool>()) {
+            disarmRunTrigger();
+        } else if (!armRunTrigger()) {
+            server.send(409, "text/plain", "A run is in progress");
+            return;
+        }
+    }
+    handleGetTrigger();
+}
+
+void handleGetChannels() {
+    const ChannelConfig& config = getChannelConfig();
+    
+    JsonResponse json;
+    json.beginObject()
+        .field("torque", config.torqueEnabled)
+        .field("torqueFactor", config.torqueFactor, 2)
+        .field("rpm", config.rpmEnabled)
+        .field("pulsesPerRev", config.pulsesPerRev);
+    json.key("columns").beginArray();
+    uint8_t channels = enabledChannels();
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (channels & CHANNEL_BIT(channel)) {
+            json.value(channelColumn((Channel)channel));
+        }
+    }
+    json.endArray();
+    json.endObject();
+    json.send();
+}
+
+// Body: {"torque":true,"torqueFactor":100,"rpm":true,"pulsesPerRev":2}; all fields optional.
+// Takes effect from the next run.
+void handleSetChannels() {
+    if (isRunActive()) {
+        server.send(409, "text/plain", "A run is in progress");
+        return;
+    }
+    
+    JsonDocument doc(arenaAllocator());
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    ChannelConfig config = getChannelConfig();
+    config.torqueEnabled = doc["torque"] | config.torqueEnabled;
+    config.torqueFactor = doc["torqueFactor"] | config.torqueFactor;
+    config.rpmEnabled = doc["rpm"] | config.rpmEnabled;
+    config.pulsesPerRev = doc["pulsesPerRev"] | config.pulsesPerRev;
+    if (!setChannelConfig(config)) {
+        server.send(400, "text/plain", "Invalid channel settings");
+        return;
+    }
+    handleGetChannels();
+}
+
+// Flash use, and how much the compression job (run_compression.h) saves on run files
+void handleGetStorage() {
+    RunStorageStats stats = getRunStorageStats();
+    StorageStats storage = getStorageStats();
+    const StorageConfig& config = getStorageConfig();
+    
+    JsonResponse json;
+    json.beginObject()
+        .field("totalBytes", storage.totalBytes)
+        .field("usedBytes", storage.usedBytes)
+        .field("freeBytes", storage.totalBytes - storage.usedBytes)
+        .field("fillPercent", storage.totalBytes ? 100.0 * storage.usedBytes / storage.totalBytes : 0.0, 1)
+        .field("runFiles", stats.files)
+        .field("compressedFiles", stats.compressedFiles)
+        .field("pendingFiles", stats.pendingFiles)
+        .field("dataBytes", stats.dataBytes)
+        .field("storedBytes", stats.storedBytes)
+        .field("compressionRatio",
+               stats.compressedStoredBytes ? (double)stats.compressedDataBytes / stats.compressedStoredBytes : 1.0, 2)
+        .field("availableBytes", storage.availableBytes)
+        .field("roomSeconds", storage.roomSeconds)
+        .field("maxRunSeconds", config.maxRunSeconds)
+        .field("quotaBytes", config.quotaBytes)
+        .field("reserveBytes", config.reserveBytes)
+        .field("retention", retentionModeName(config.retention))
+        .field("compressFirst", config.compressFirst)
+        .field("keepStarred", config.keepStarred)
+        .field("runsRefused", storage.runsRefused)
+        .field("runsWarned", storage.runsWarned)
+        .field("runsStoppedFull", storage.runsStoppedFull)
+        .field("filesDeleted", storage.filesDeleted);
+    // Estimated from bytes written (storage_manager.h)
+    json.key("wear").beginObject()
+        .field("bytesWritten", storage.bytesWritten)
+        .field("eraseCycles", storage.eraseCycles, 3)
+        .field("ratedCycles", FLASH_RATED_ERASE_CYCLES)
+        .field("percentUsed", 100.0 * storage.eraseCycles / FLASH_RATED_ERASE_CYCLES, 4)
+        .endObject();
+    json.endObject();
+    json.send();
+}
+
+// Body: {"maxRunSeconds":300,"quotaBytes":0,"reserveBytes":65536,"retention":"off|oldest",
+// "compressFirst":true,"keepStarred":true}; all fields optional
+void handleSetStorage() {
+    if (isRunActive()) {
+        server.send(409, "text/plain", "A run is in progress");
+        return;
+    }
+    
+    JsonDocument doc(arenaAllocator());
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    StorageConfig config = getStorageConfig();
+    config.maxRunSeconds = doc["maxRunSeconds"] | config.maxRunSeconds;
+    config.quotaBytes = doc["quotaBytes"] | config.quotaBytes;
+    config.reserveBytes = doc["reserveBytes"] | config.reserveBytes;
+    config.compressFirst = doc["compressFirst"] | config.compressFirst;
+    config.keepStarred = doc["keepStarred"] | config.keepStarred;
+    if (!doc["retention"].isNull() && !parseRetentionMode(doc["retention"].as<String>(), config.retention)) {
+        server.send(400, "text/plain", "Unknown retention policy");
+        return;
+    }
+    if (!setStorageConfig(config)) {
+        server.send(400, "text/plain", "Invalid storage settings");
+        return;
+    }
+    handleGetStorage();
+}
+
+void handleGetStream() {
+    const UdpStreamConfig& udp = getUdpStreamConfig();
+    UdpStreamStats stats = getUdpStreamStats();
+    
+    JsonResponse json;
+    json.beginObject()
+        .field("serial", isSerialStreaming())
+        .field("udp", udp.enabled)
+        .field("host", udp.host)
+        .field("port", udp.port)
+        .field("stand", udp.stand)
+        .field("datagrams", stats.datagrams)
+        .field("sendErrors", stats.sendErrors)
+        .endObject();
+    json.send();
+}
+
+// Body: {"serial":false,"udp":true,"host":"192.168.1.20","port":5005,"stand":"bench-2"}; all fields optional
+void handleSetStream() {
+    if (isRunActive()) {
+        server.send(409, "text/plain", "A run is in progress");
+        return;
+    }
+    
+    JsonDocument doc(arenaAllocator());
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(400, "text/plain", "Invalid JSON");
+        return;
+    }
+    
+    UdpStreamConfig udp = getUdpStreamConfig();
+    udp.enabled = doc["udp"] | udp.enabled;
+    udp.host = doc["host"] | udp.host;
+    udp.port = doc["port"] | udp.port;
+    udp.stand = doc["stand"] | udp.stand;
+    if (!setUdpStreamConfig(udp)) {
+        server.send(400, "text/plain", "Invalid stream settings");
+        return;
+    }
+    setSerialStreaming(doc["serial"] | isSerialStreaming());
+    handleGetStream();
+}
+
+// /api/sync?since=<cursor>&epoch=<epoch>: what changed in the run catalog after
+// cursor, for replicas that mirror the stand. Without since, from another epoch
+// or from before the horizon, "reset" is true and everything is listed: the
+// replica then drops whatever is not. The file being recorded is left out
+// until its run stops.
+void handleSync() {
+    CatalogSyncState state = catalogSyncState();
+    uint32_t since = strtoul(server.arg("since").c_str(), nullptr, 10);
+    uint32_t epoch = strtoul(server.arg("epoch").c_str(), nullptr, 10);
+    bool reset = !server.hasArg("since") || epoch != state.epoch || since < state.horizon || since > state.cursor;
+    if (reset) {
+        since = 0;
+    }
+    String activeFile = isRunActive() ? getCurrentRun().currentFileName : String();
+    
+    JsonResponse json;
+    json.beginObject()
+        .field("epoch", state.epoch)
+        .field("cursor", state.cursor)
+        .field("reset", reset);
+    
+    json.key("runs").beginArray();
+    for (const RunListing& run : catalogRuns()) {
+        if (run.changed > since) {
+            json.beginObject()
+                .field("name", run.name)
+                .field("notes", run.notes)
+                .field("created", run.created)
+                .field("changed", run.changed)
+                .endObject();
+        }
+    }
+    json.endArray();
+    
+    json.key("files").beginArray();
+    for (const RunListing& run : catalogRuns()) {
+        for (const RunFileInfo& f : run.files) {
+            if (f.changed > since && f.name != activeFile) {
+                json.beginObject()
+                    .field("name", f.name)
+                    .field("run", run.name)
+                    .field("size", (unsigned long)f.size)
+                    .field("changed", f.changed)
+                    .endObject();
+            }
+        }
+    }
+    json.endArray();
+    
+    json.key("deletedRuns").beginArray();
+    if (!reset) {
+        for (const CatalogTombstone& t : catalogTombstones()) {
+            if (t.isRun && t.changed > since) json.value(t.name);
+        }
+    }
+    json.endArray();
+    
+    json.key("deletedFiles").beginArray();
+    if (!reset) {
+        for (const CatalogTombstone& t : catalogTombstones()) {
+            if (!t.isRun && t.changed > since) json.value(t.name);
+        }
+    }
+    json.endArray();
+    
+    json.endObject();
+    json.send();
+}
+
+void handleGetTrace() {
+    // Pause recording so the ring holds still while it is sent
+    bool wasEnabled = isTraceEnabled();
+    setTraceEnabled(false);
+    
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    
+    size_t total = traceEventCount();
+    for (size_t from = 0; from < total; from += 32) {
+        if (from > 0) server.sendContent(",");
+        server.sendContent(traceEventsJson(from, 32));
+    }
+    server.sendContent("]}");
+    server.sendContent("");
+    
+    if (server.arg("clear") == "1") {
+        clearTrace();
+    }
+    if (server.hasArg("enable")) {
+        setTraceEnabled(server.arg("enable") != "0");
+    } else {
+        setTraceEnabled(wasEnabled);
+    }
+}
+
+void handleGetMetrics() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4", "");
+    
+    String chunk;
+    for (size_t i = 0; (chunk = metricsChunk(i)).length() > 0; i++) {
+        server.sendContent(chunk);
+    }
+    server.sendContent("");
+}
@@ -2,12 +2,16 @@
 #include "wifi_manager.h"
 #include "config_page.h"
 #include "config.h"
+#include "trace.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "load_cell.h"
+#include "calibration.h"
 #include <WebServer.h>
 #include <DNSServer.h>
 #include <Preferences.h>
 #include <ESPmDNS.h>
 #include <ArduinoJson.h>
-#include <HX711.h>
 
 // Configuration
 #define AP_SSID "ThrustPlotter-Config"
@@ -15,11 +19,13 @@
 #define DNS_PORT 53
 #define WEB_SERVER_PORT 80
 #define BUTTON_HOLD_TIME 3000  // 3 seconds to enter config mode
+#define WIFI_CONNECT_TIMEOUT_MS 15000  // Give up on an attempt and back off
+#define WIFI_RETRY_MIN_MS 1000
+#define WIFI_RETRY_MAX_MS 30000
 
 // Static objects
 static DNSServer dnsServer;
 static Preferences prefs;
-static HX711 configScale;  // Load cell for calibration in config mode
 
 // Shared objects 
 extern WebServer server;    // This is the only module sharing the WebServer instance - which is is declared in web_server.cpp
@@ -28,16 +34,19 @@ extern WebServer server;    // This is the only module sharing the WebServer ins
 static bool configMode = false;
 static unsigned long buttonPressStart = 0;
 static bool buttonWasPressed = false;
+static bool shortPressPending = false;
 static uint8_t buttonPin = 0;
 static uint8_t ledPin = 2;
 
-// Calibration state
-static bool calibrationInProgress = false;
-static int calibrationCurrentStep = 0;
-static String calibrationMessage = "";
-static float calibrationResult = 0.0;
-static float calibrationKnownWeight = 0.0;
-static unsigned long calibrationStepStart = 0;
+// Station link state. Events arrive on the WiFi task and are only flagged
+// there; handleWiFiManager() acts on them from loop().
+static WiFiLinkState linkState = WIFI_LINK_NO_CREDENTIALS;
+static volatile bool linkGotIp = false;
+static volatile bool linkLost = false;
+static unsigned long attemptStart = 0;
+static unsigned long retryDelay = WIFI_RETRY_MIN_MS;
+static bool servicesStarted = false;
+static bool timeSynced = false;
 
 // Forward declarations for internal functions
 static void checkConfigButton();
@@ -46,7 +55,7 @@ static void handleSave();
 static void handleGetCalibration();
 static void handleStartCalibration();
 static void handleCalibrationStatus();
-static void handleCalibrationProcess();
+static void handleLink();
 
 void initWiFiManager(uint8_t btnPin, uint8_t led) {
     buttonPin = btnPin;
@@ -62,11 +71,17 @@ void handleWiFiManager() {
     
     if (configMode) {
         // Handle captive portal
-        dnsServer.processNextRequest();
-        server.handleClient();
+        {
+            TRACE_SCOPE("dns");
+            dnsServer.processNextRequest();
+        }
+        {
+            TRACE_SCOPE("http");
+            server.handleClient();
+        }
         
-        // Handle calibration process if in progress
-        handleCalibrationProcess();
+        // Advance the calibration session if one is running
+        handleCalibration();
         
         // Blink LED in config mode
         static unsigned long lastBlink = 0;
@@ -74,87 +89,148 @@ void handleWiFiManager() {
             digitalWrite(ledPin, !digitalRead(ledPin));
             lastBlink = millis();
         }
+    } else {
+        handleLink();
     }
 }
 
+bool takeButtonPress() {
+    bool pressed = shortPressPending;
+    shortPressPending = false;
+    return pressed;
+}
+
 bool isInConfigMode() {
     return configMode;
 }
 
-bool connectToSavedWiFi() {
+WiFiLinkState getWiFiLinkState() {
+    return linkState;
+}
+
+bool isTimeSynced() {
+    return timeSynced;
+}
+
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        linkGotIp = true;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        linkLost = true;
+    }
+}
+
+bool startWiFi() {
+    // Bring the network stack up even without credentials, so the web server can bind
+    WiFi.mode(WIFI_STA);
+    
+    // Local time is right as soon as NTP answers
+    String savedTZ = prefs.getString("timezone", "GMT0");
+    setenv("TZ", savedTZ.c_str(), 1);
+    tzset();
+    
     String ssid = prefs.getString("ssid", "");
     String password = prefs.getString("password", "");
     
     if (ssid.length() == 0) {
         Serial.println("No saved WiFi credentials.");
+        linkState = WIFI_LINK_NO_CREDENTIALS;
         return false;
     }
     
     Serial.print("Connecting to: ");
     Serial.println(ssid);
     
-    //Serial.print("Password: ");
-    //Serial.println(password);
-    
-    WiFi.mode(WIFI_STA);
+    // Retries are paced by handleLink() instead
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent(onWiFiEvent);
     WiFi.begin(ssid.c_str(), password.c_str());
+    
+    linkState = WIFI_LINK_CONNECTING;
+    attemptStart = millis();
+    return true;
+}
 
-    for (int i=0; i < 5; i++) {
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
-        }
-        if (WiFi.status() == WL_CONNECTED) {
-            break;
-        }
-        WiFi.reconnect();
+static void startNetworkServices() {
+    if (!MDNS.begin("thrustplotter")) {
+        Serial.println("Error setting up MDNS responder!");
+    } else {
+        MDNS.addService("http", "tcp", 80);
+        Serial.println("mDNS responder started. Access at http://thrustplotter.local");
     }
     
-    if (WiFi.status() == WL_CONNECTED) {
-        if (!MDNS.begin("thrustplotter")) {
-            Serial.println("Error setting up MDNS responder!");
-        } else {
-            MDNS.addService("http", "tcp", 80); 
-            Serial.println("mDNS responder started. Access at http://thrustplotter.local");
-        }
-        
-        // Wait for things to settle
-        static bool hasSettled = false;
-        if (!hasSettled) {
-            delay(1000);
-            Serial.flush();
-            hasSettled = true;
-        }
+    // SNTP runs in the background; handleLink() notices when the clock is set
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+    // configTime() resets TZ to UTC
+    setenv("TZ", prefs.getString("timezone", "GMT0").c_str(), 1);
+    tzset();
+    servicesStarted = true;
+}
 
-        // Set Timezone
-        static bool timeSet = false;
-        if (!timeSet) {
-            String savedTZ = prefs.getString("timezone", "GMT0"); 
-            configTime(0, 0, "pool.ntp.org", "time.nist.gov"); 
-            setenv("TZ", savedTZ.c_str(), 1);
-            tzset();
-            timeSet = true;
-        }
+static void scheduleRetry() {
+    linkState = WIFI_LINK_RETRY_WAIT;
+    attemptStart = millis();
+    Serial.printf("WiFi not connected, retrying in %lu ms\n", retryDelay);
+}
 
-        // Print verification
+static void handleLink() {
+    bool gotIp = linkGotIp;
+    bool lost = linkLost;
+    linkGotIp = false;
+    linkLost = false;
+    
+    switch (linkState) {
+        case WIFI_LINK_CONNECTING:
+            if (gotIp) {
+                linkState = WIFI_LINK_UP;
+                retryDelay = WIFI_RETRY_MIN_MS;
+                metricMark(METRIC_WIFI_CONNECTED);
+                Serial.printf("Connected to WiFi after %lu ms. IP Address: %s\n", millis(), WiFi.localIP().toString().c_str());
+                if (!servicesStarted) {
+                    startNetworkServices();
+                }
+            } else if (lost || millis() - attemptStart > WIFI_CONNECT_TIMEOUT_MS) {
+                WiFi.disconnect();
+                scheduleRetry();
+            }
+            break;
+            
+        case WIFI_LINK_UP:
+            if (lost) {
+                Serial.println("WiFi link lost");
+                scheduleRetry();
+            }
+            break;
+            
+        case WIFI_LINK_RETRY_WAIT:
+            if (millis() - attemptStart >= retryDelay) {
+                retryDelay = min(retryDelay * 2, (unsigned long)WIFI_RETRY_MAX_MS);
+                WiFi.reconnect();
+                linkState = WIFI_LINK_CONNECTING;
+                attemptStart = millis();
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (servicesStarted && !timeSynced && time(nullptr) > TIME_VALID_EPOCH) {
+        timeSynced = true;
+        metricMark(METRIC_TIME_SYNCED);
+        
         struct tm timeinfo;
-        if (getLocalTime(&timeinfo)) {
+        if (getLocalTime(&timeinfo, 0)) {
             char locBuff[64];
             strftime(locBuff, sizeof(locBuff), "%A, %B %d %Y %H:%M:%S", &timeinfo);
-            
-            Serial.printf("IP Address: %s\n", WiFi.localIP().toString().c_str());
-            Serial.printf("Local Time: %s\n", locBuff);
-            Serial.println("--------------------------");
+            Serial.printf("Local Time: %s (NTP after %lu ms)\n", locBuff, millis());
         }
     }
-
-    return (WiFi.status() == WL_CONNECTED);
 }
 
 void enterConfigMode() {
     configMode = true;
+    linkState = WIFI_LINK_CONFIG_MODE;
     
     // Stop any existing WiFi connection
     WiFi.disconnect();
@@ -168,10 +244,6 @@ void enterConfigMode() {
     Serial.print("AP IP address: ");
     Serial.println(IP);
     
-    // Initialize load cell for calibration
-    configScale.begin(HX711_DOUT_PIN, HX711_SCK_PIN);
-    Serial.println("Load cell initialized for calibration");
-    
     // Start DNS server for captive portal
     dnsServer.start(DNS_PORT, "*", IP);
     
@@ -183,13 +255,14 @@ void enterConfigMode() {
         String timezone = prefs.getString("timezone", "GMT0");
         float calibrationFactor = prefs.getFloat("cal_factor", 0.0);
         
-        String json = "{";
-        json += "\"ssid\":\"" + ssid + "\",";
-        json += "\"timezone\":\"" + timezone + "\",";
-        json += "\"calibrationFactor\":" + String(calibrationFactor, 2);
-        json += "}";
+        StackJsonWriter<256> json;
+        json.beginObject()
+            .field("ssid", ssid)
+            .field("timezone", timezone)
+            .field("calibrationFactor", calibrationFactor, 2)
+            .endObject();
         
-        server.send(200, "application/json", json);
+        server.send(200, "application/json", json.c_str());
     });
     server.on("/api/calibration", HTTP_GET, handleGetCalibration);
     server.on("/api/calibration/start", HTTP_POST, handleStartCalibration);
@@ -214,8 +287,12 @@ static void checkConfigButton() {
         buttonPressStart = millis();
         buttonWasPressed = true;
     } else if (!buttonPressed && buttonWasPressed) {
-        // Button released
+        // Button released; anything shorter than the config-mode hold is a press for takeButtonPress()
         buttonWasPressed = false;
+        unsigned long held = millis() - buttonPressStart;
+        if (!configMode && held >= BUTTON_DEBOUNCE_MS && held < BUTTON_HOLD_TIME) {
+            shortPressPending = true;
+        }
     } else if (buttonPressed && buttonWasPressed) {
         // Button being held
         if (millis() - buttonPressStart >= BUTTON_HOLD_TIME && !configMode) {
@@ -256,14 +333,19 @@ static void handleSave() {
 }
 
 static void handleGetCalibration() {
-    float calibrationFactor = prefs.getFloat("cal_factor", 0.0);
+    LoadCellCurve curve = getLoadCellCurve();
     
-    String json = "{\"calibrationFactor\":" + String(calibrationFactor, 2) + "}";
-    server.send(200, "application/json", json);
+    StackJsonWriter<256> json;
+    json.beginObject()
+        .field("calibrationFactor", prefs.getFloat("cal_factor", 0.0), 2);
+    json.key("coefficients").beginArray().value(curve.c0).value(curve.c1).value(curve.c2).endArray();
+    json.endObject();
+    
+    server.send(200, "application/json", json.c_str());
 }
 
 static void handleStartCalibration() {
-    if (calibrationInProgress) {
+    if (isCalibrationRunning()) {
         server.send(400, "application/json", "{\"success\":false,\"message\":\"Calibration already in progress\"}");
         return;
     }
@@ -282,121 +364,35 @@ static void handleStartCalibration() {
         return;
     }
     
-    calibrationKnownWeight = doc["knownWeight"].as<float>();
+    // {"weights":[...],"degree":1|2}, or {"knownWeight":w} from older pages
+    std::vector<float> weights;
+    int degree = doc["degree"] | 1;
+    JsonArray list = doc["weights"];
+    if (!list.isNull()) {
+        for (JsonVariant weight : list) {
+            weights.push_back(weight.as<float>());
+        }
+    } else {
+        weights.push_back(doc["knownWeight"].as<float>());
+    }
     
-    if (calibrationKnownWeight <= 0) {
-        server.send(400, "application/json", "{\"success\":false,\"message\":\"Invalid weight\"}");
-        return;
+    for (float weight : weights) {
+        if (weight <= 0) {
+            server.send(400, "application/json", "{\"success\":false,\"message\":\"Invalid weight\"}");
+            return;
+        }
     }
     
-    // Check if load cell is ready
-    if (!configScale.is_ready()) {
-        server.send(500, "application/json", "{\"success\":false,\"message\":\"Load cell not ready\"}");
+    if (!startCalibration(weights, degree)) {
+        server.send(400, "application/json", "{\"success\":false,\"message\":\"Invalid weights\"}");
         return;
     }
     
-    // Start calibration process
-    calibrationInProgress = true;
-    calibrationCurrentStep = 1;
-    calibrationMessage = "Remove all weight...";
-    calibrationStepStart = millis();
-    calibrationResult = 0.0;
-    
-    Serial.println("Starting calibration with known weight: " + String(calibrationKnownWeight, 1) + "g");
-    
     server.send(200, "application/json", "{\"success\":true}");
 }
 
 static void handleCalibrationStatus() {
-    String json = "{";
-    json += "\"step\":" + String(calibrationCurrentStep) + ",";
-    json += "\"message\":\"" + calibrationMessage + "\",";
-    json += "\"complete\":" + String(calibrationInProgress ? "false" : "true") + ",";
-    json += "\"success\":" + String(calibrationResult > 0 ? "true" : "false");
-    
-    if (calibrationResult > 0) {
-        json += ",\"calibrationFactor\":" + String(calibrationResult, 2);
-    }
-    
-    json += "}";
-    
-    server.send(200, "application/json", json);
+    StackJsonWriter<1024> json;
+    writeCalibrationStatus(json);
+    server.send(200, "application/json", json.c_str());
 }
-
-static void handleCalibrationProcess() {
-    if (!calibrationInProgress) return;
-    
-    unsigned long elapsed = millis() - calibrationStepStart;
-    
-    switch (calibrationCurrentStep) {
-        case 1:  // Waiting to tare
-            if (elapsed < 5000) {
-                calibrationMessage = "Step 1/2: Remove all weight... (" + String(5 - (elapsed/1000)) + "s)";
-            } else {
-                // Tare the scale
-                Serial.println("Taring scale...");
-                configScale.set_scale();
-                configScale.tare();
-                calibrationCurrentStep = 2;
-                calibrationStepStart = millis();
-                calibrationMessage = "Place known weight on scale...";
-                Serial.println("Tare complete. Place weight on scale.");
-            }
-            break;
-            
-        case 2:  // Waiting to take measurements
-            if (elapsed < 5000) {
-                calibrationMessage = "Step 2/2: Place " + String(calibrationKnownWeight, 1) + "g weight... (" + String(5 - (elapsed/1000)) + "s)";
-            } else {
-                calibrationCurrentStep = 3;
-                calibrationResult = 0.0;  // Reset for accumulating readings
-                calibrationMessage = "Taking measurements (1/5)...";
-                calibrationStepStart = millis();
-                Serial.println("Starting measurements...");
-            }
-            break;
-            
-        case 3:  // Taking 5 measurements
-        case 4:
-        case 5:
-        case 6:
-        case 7: {
-            int measurementNum = calibrationCurrentStep - 2;
-            
-            if (elapsed < 1000) {
-                calibrationMessage = "Taking measurement " + String(measurementNum) + "/5...";
-            } else {
-                // Take one measurement
-                if (configScale.is_ready()) {
-                    long reading = configScale.get_units(10);  // Average of 10 reads
-                    calibrationResult += reading;
-                    Serial.println("Measurement " + String(measurementNum) + ": " + String(reading));
-                    
-                    if (calibrationCurrentStep < 7) {
-                        calibrationCurrentStep++;
-                        calibrationStepStart = millis();
-                    } else {
-                        // Calculate final calibration factor
-                        float averageReading = calibrationResult / 5.0;
-                        calibrationResult = averageReading / calibrationKnownWeight;
-                        
-                        Serial.println("Average reading: " + String(averageReading));
-                        Serial.println("Calibration factor: " + String(calibrationResult, 2));
-                        
-                        // Save to preferences
-                        prefs.putFloat("cal_factor", calibrationResult);
-                        
-                        calibrationMessage = "Calibration complete!";
-                        calibrationInProgress = false;
-                        
-                        Serial.println("Calibration saved to preferences");
-                    }
-                } else {
-                    Serial.println("Warning: Load cell not ready during measurement");
-                    calibrationStepStart = millis();  // Retry
-                }
-            }
-            break;
-        }
-    }
-}
\ No newline at end of file
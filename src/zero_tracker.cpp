@@ -0,0 +1,80 @@
+// src/zero_tracker.cpp
+#include "zero_tracker.h"
+#include "config.h"
+#include "load_cell.h"
+#include "run_manager.h"
+#include "run_trigger.h"
+#include <algorithm>
+
+static bool idle = false;
+static unsigned long idleSince = 0;
+static int windowCount = 0;
+static double windowSum = 0;
+static double windowSumSquares = 0;
+static ZeroTrackerStatus status = {false, 0, 0, 0.0, 0};
+
+static void resetWindow() {
+    windowCount = 0;
+    windowSum = 0;
+    windowSumSquares = 0;
+}
+
+static void finishWindow() {
+    double mean = windowSum / windowCount;
+    double spread = sqrt(std::max(0.0, windowSumSquares / windowCount - mean * mean));
+    resetWindow();
+
+    // Near zero the curve is its linear term
+    float gramsPerCount = fabsf(getLoadCellCurve().c1);
+    if (spread * gramsPerCount > ZERO_TRACK_MAX_NOISE_GRAMS || fabs(mean) * gramsPerCount > ZERO_TRACK_BAND_GRAMS) {
+        return;
+    }
+
+    long correction = lround(ZERO_TRACK_GAIN * mean);
+    if (correction == 0) {
+        return;
+    }
+    adjustTare(correction);
+    status.updates++;
+    status.driftCounts += correction;
+    status.driftGrams = status.driftCounts * getLoadCellCurve().c1;
+    status.lastUpdateMs = millis();
+}
+
+void zeroTrackerObserve(long netCounts) {
+    if (!idle || millis() - idleSince < ZERO_TRACK_SETTLE_MS) {
+        return;
+    }
+    windowSum += netCounts;
+    windowSumSquares += (double)netCounts * netCounts;
+    if (++windowCount >= ZERO_TRACK_WINDOW) {
+        finishWindow();
+    }
+}
+
+void handleZeroTracker() {
+    if (isRunActive()) {
+        idle = false;
+        resetWindow();
+        return;
+    }
+    if (!idle) {
+        idle = true;
+        idleSince = millis();
+    }
+
+    // The armed trigger reads the load cell itself and passes its readings on
+    if (getTriggerState() != TRIGGER_IDLE) {
+        return;
+    }
+    long counts;
+    if (readNetCounts(counts)) {
+        zeroTrackerObserve(counts);
+    }
+}
+
+ZeroTrackerStatus getZeroTrackerStatus() {
+    ZeroTrackerStatus current = status;
+    current.tracking = idle && millis() - idleSince >= ZERO_TRACK_SETTLE_MS;
+    return current;
+}
@@ -0,0 +1,145 @@
+// src/zip_stream.cpp
+#include "zip_stream.h"
+#include "config.h"
+#include <time.h>
+
+#define ZIP_LOCAL_HEADER 0x04034b50
+#define ZIP_DATA_DESCRIPTOR 0x08074b50
+#define ZIP_CENTRAL_HEADER 0x02014b50
+#define ZIP_END_OF_DIRECTORY 0x06054b50
+#define ZIP_VERSION 20              // 2.0: data descriptors
+#define ZIP_FLAGS 0x0808            // Sizes in a data descriptor, UTF-8 names
+
+// CRC-32 (IEEE), four bits at a time: a 64-byte table instead of 1 KB
+static const uint32_t crcNibbles[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crcNibbles[crc & 15];
+        crc = (crc >> 4) ^ crcNibbles[crc & 15];
+    }
+    return ~crc;
+}
+
+ZipStreamWriter::ZipStreamWriter(ZipSink sink, void* sinkContext)
+    : sink(sink), sinkContext(sinkContext), entryOpen(false), offset(0), buffered(0) {
+    // Entries are dated now; before the clock is set, 1980-01-01 (the DOS epoch)
+    time_t now = time(nullptr);
+    struct tm local;
+    if (now >= TIME_VALID_EPOCH && localtime_r(&now, &local)) {
+        dosTime = (local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2);
+        dosDate = ((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday;
+    } else {
+        dosTime = 0;
+        dosDate = (1 << 5) | 1;
+    }
+}
+
+void ZipStreamWriter::put(const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    offset += length;
+    while (length > 0) {
+        size_t n = sizeof(buffer) - buffered;
+        if (n > length) n = length;
+        memcpy(buffer + buffered, bytes, n);
+        buffered += n;
+        bytes += n;
+        length -= n;
+        if (buffered == sizeof(buffer)) flush();
+    }
+}
+
+void ZipStreamWriter::flush() {
+    if (buffered > 0) {
+        sink(sinkContext, buffer, buffered);
+        buffered = 0;
+    }
+}
+
+bool ZipStreamWriter::beginEntry(const char* name) {
+    endEntry();
+    if (entries.size() >= EXPORT_MAX_ENTRIES) {
+        return false;
+    }
+    entries.push_back(Entry{name, 0, 0, offset});
+
+    size_t nameLength = strlen(name);
+    putU32(ZIP_LOCAL_HEADER);
+    putU16(ZIP_VERSION);
+    putU16(ZIP_FLAGS);
+    putU16(0);              // Stored
+    putU16(dosTime);
+    putU16(dosDate);
+    putU32(0);              // CRC and sizes: in the data descriptor
+    putU32(0);
+    putU32(0);
+    putU16(nameLength);
+    putU16(0);              // No extra field
+    put(name, nameLength);
+    entryOpen = true;
+    return true;
+}
+
+void ZipStreamWriter::write(const uint8_t* data, size_t length) {
+    if (!entryOpen) {
+        return;
+    }
+    Entry& entry = entries.back();
+    entry.crc = crc32Update(entry.crc, data, length);
+    entry.size += length;
+    put(data, length);
+}
+
+void ZipStreamWriter::endEntry() {
+    if (!entryOpen) {
+        return;
+    }
+    const Entry& entry = entries.back();
+    putU32(ZIP_DATA_DESCRIPTOR);
+    putU32(entry.crc);
+    putU32(entry.size);     // Compressed and uncompressed sizes are the same when stored
+    putU32(entry.size);
+    entryOpen = false;
+}
+
+void ZipStreamWriter::finish() {
+    endEntry();
+
+    uint32_t directoryOffset = offset;
+    for (const Entry& entry : entries) {
+        putU32(ZIP_CENTRAL_HEADER);
+        putU16(ZIP_VERSION);    // Made by
+        putU16(ZIP_VERSION);    // Needed
+        putU16(ZIP_FLAGS);
+        putU16(0);
+        putU16(dosTime);
+        putU16(dosDate);
+        putU32(entry.crc);
+        putU32(entry.size);
+        putU32(entry.size);
+        putU16(entry.name.length());
+        putU16(0);              // Extra field
+        putU16(0);              // Comment
+        putU16(0);              // Disk
+        putU16(0);              // Internal attributes
+        putU32(0);              // External attributes
+        putU32(entry.headerOffset);
+        put(entry.name.c_str(), entry.name.length());
+    }
+    uint32_t directorySize = offset - directoryOffset;
+
+    putU32(ZIP_END_OF_DIRECTORY);
+    putU16(0);
+    putU16(0);
+    putU16(entries.size());
+    putU16(entries.size());
+    putU32(directorySize);
+    putU32(directoryOffset);
+    putU16(0);                  // Comment
+    flush();
+}
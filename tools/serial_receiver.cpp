@@ -0,0 +1,267 @@
+// tools/serial_receiver.cpp - bench PC receiver for the USB serial sample stream
+//
+// Reads the framed stream (include/stream_protocol.h) from the device's serial
+// port and writes each run to DIR in the device's own CSV format, so files
+// can be charted or uploaded like ones downloaded from /api/data. Optionally
+// sends commands first.
+//
+//   g++ -std=c++17 -O2 -Iinclude tools/serial_receiver.cpp -o serial_receiver
+//
+//   serial_receiver --port /dev/ttyUSB0 [--baud 921600] [--out DIR] [--stream on|off]
+//                   [--torque on|off] [--rpm on|off] [--start RUN] [--stop] [--once]
+//   serial_receiver --file CAPTURE [--out DIR]
+//
+// --file decodes a capture instead (e.g. the host build's stderr with
+// --stream). --once exits after the first run ends. Frames with a bad CRC
+// are counted and dropped; bytes outside frames (debug text) are ignored.
+#include "stream_protocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+// Column names and formats as the device writes them (channels.h, data_logger.cpp)
+static const char* const columnNames[] = {"thrust_grams", "torque_nmm", "rpm"};
+static const char* const columnFormats[] = {",%.2f", ",%.2f", ",%.0f"};
+static const int channelCount = 3;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static speed_t baudConstant(long baud) {
+    switch (baud) {
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return 0;
+    }
+}
+
+static int openPort(const char* path, long baud) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        perror("tcgetattr");
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, baudConstant(baud));
+    cfsetospeed(&tty, baudConstant(baud));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 2;  // Reads return every 200 ms so signals are noticed
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        perror("tcsetattr");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendCommand(int fd, uint8_t type, const StreamPayload& payload) {
+    uint8_t frame[STREAM_MAX_PAYLOAD + STREAM_FRAME_OVERHEAD];
+    size_t size = encodeStreamFrame(type, payload.data, payload.length, frame);
+    return write(fd, frame, size) == (ssize_t)size;
+}
+
+static uint8_t onOff(const std::string& value) {
+    return value == "on" ? 1 : 0;
+}
+
+// Device file names may hold characters the host does not want in a path
+static std::string hostFileName(const char* name) {
+    std::string out = name;
+    for (char& c : out) {
+        if (c == '/' || c == '\\') c = '_';
+    }
+    return out;
+}
+
+struct RunFile {
+    FILE* file = nullptr;
+    std::string path;
+    uint8_t channels = 0;
+    uint32_t samples = 0;
+    uint32_t lastTimestamp = 0;
+};
+
+static void startRun(RunFile& run, const std::string& outDir, StreamReader& reader) {
+    char name[256];
+    char comment[256];
+    run.channels = reader.getU8();
+    reader.getText(name, sizeof(name));
+    reader.getText(comment, sizeof(comment));
+    run.samples = 0;
+    run.path = outDir + "/" + hostFileName(name);
+
+    run.file = fopen(run.path.c_str(), "wb");
+    if (!run.file) {
+        perror(run.path.c_str());
+        return;
+    }
+    fprintf(run.file, "timestamp_ms");
+    for (int channel = 0; channel < channelCount; channel++) {
+        if (run.channels & (1u << channel)) fprintf(run.file, ",%s", columnNames[channel]);
+    }
+    fprintf(run.file, "\r\n");
+    if (comment[0]) fprintf(run.file, "# %s\r\n", comment);
+    fprintf(stderr, "run started: %s\n", run.path.c_str());
+}
+
+static void writeSample(RunFile& run, StreamReader& reader) {
+    if (!run.file) return;
+    run.lastTimestamp = reader.getU32();
+    fprintf(run.file, "%lu", (unsigned long)run.lastTimestamp);
+    for (int channel = 0; channel < channelCount; channel++) {
+        if (run.channels & (1u << channel)) fprintf(run.file, columnFormats[channel], reader.getFloat());
+    }
+    fprintf(run.file, "\r\n");
+    run.samples++;
+}
+
+static void finishRun(RunFile& run, uint32_t sent) {
+    if (!run.file) return;
+    fclose(run.file);
+    run.file = nullptr;
+    fprintf(stderr, "run ended: %s, %u samples received, %u sent%s\n", run.path.c_str(), run.samples, sent,
+            run.samples == sent ? "" : " (samples lost)");
+}
+
+int main(int argc, char** argv) {
+    std::string port, capture, outDir = ".", startName;
+    long baud = 921600;
+    bool stop = false, once = false;
+    uint8_t stream = 0xFF, torque = 0xFF, rpm = 0xFF;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--port" && hasValue) port = argv[++i];
+        else if (option == "--file" && hasValue) capture = argv[++i];
+        else if (option == "--baud" && hasValue) baud = atol(argv[++i]);
+        else if (option == "--out" && hasValue) outDir = argv[++i];
+        else if (option == "--stream" && hasValue) stream = onOff(argv[++i]);
+        else if (option == "--torque" && hasValue) torque = onOff(argv[++i]);
+        else if (option == "--rpm" && hasValue) rpm = onOff(argv[++i]);
+        else if (option == "--start" && hasValue) startName = argv[++i];
+        else if (option == "--stop") stop = true;
+        else if (option == "--once") once = true;
+        else {
+            fprintf(stderr, "usage: serial_receiver (--port DEV [--baud N] | --file CAPTURE) [--out DIR]\n"
+                            "                       [--stream on|off] [--torque on|off] [--rpm on|off]\n"
+                            "                       [--start RUN] [--stop] [--once]\n");
+            return 2;
+        }
+    }
+    if (port.empty() == capture.empty()) {
+        fprintf(stderr, "serial_receiver: give one of --port or --file\n");
+        return 2;
+    }
+
+    int fd;
+    if (!port.empty()) {
+        if (!baudConstant(baud)) {
+            fprintf(stderr, "serial_receiver: unsupported baud rate %ld\n", baud);
+            return 2;
+        }
+        fd = openPort(port.c_str(), baud);
+    } else {
+        fd = open(capture.c_str(), O_RDONLY);
+        if (fd < 0) perror(capture.c_str());
+    }
+    if (fd < 0) return 1;
+
+    if (!port.empty()) {
+        StreamPayload none;
+        sendCommand(fd, STREAM_CMD_PING, none);
+        if (stream != 0xFF || torque != 0xFF || rpm != 0xFF) {
+            StreamPayload config;
+            config.putU8(stream);
+            config.putU8(torque);
+            config.putU8(rpm);
+            sendCommand(fd, STREAM_CMD_CONFIG, config);
+        }
+        if (stop) {
+            sendCommand(fd, STREAM_CMD_STOP, none);
+        }
+        if (!startName.empty()) {
+            StreamPayload start;
+            start.put(startName.data(), startName.size());
+            sendCommand(fd, STREAM_CMD_START, start);
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    StreamDecoder decoder;
+    RunFile run;
+    uint8_t buffer[4096];
+    bool done = false;
+    while (!done && !stopRequested) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno != EINTR) {
+            perror("read");
+            break;
+        }
+        if (n == 0 && !capture.empty()) break;  // End of the capture
+
+        for (ssize_t i = 0; i < n && !done; i++) {
+            if (!decoder.feed(buffer[i])) continue;
+
+            StreamReader reader(decoder.payload, decoder.length);
+            switch (decoder.type) {
+                case STREAM_HELLO: {
+                    uint8_t version = reader.getU8();
+                    uint16_t periodMs = reader.getU16();
+                    uint8_t channels = reader.getU8();
+                    uint8_t streaming = reader.getU8();
+                    fprintf(stderr, "device: protocol %u, %u ms per sample, channels 0x%02x, streaming %s\n", version,
+                            periodMs, channels, streaming ? "on" : "off");
+                    break;
+                }
+                case STREAM_ACK: {
+                    uint8_t command = reader.getU8();
+                    uint8_t ok = reader.getU8();
+                    std::string message((const char*)decoder.payload + 2, decoder.length > 2 ? decoder.length - 2 : 0);
+                    fprintf(stderr, "command 0x%02x: %s (%s)\n", command, ok ? "ok" : "failed", message.c_str());
+                    break;
+                }
+                case STREAM_RUN_START:
+                    finishRun(run, run.samples);
+                    startRun(run, outDir, reader);
+                    break;
+                case STREAM_SAMPLE:
+                    writeSample(run, reader);
+                    break;
+                case STREAM_RUN_STOP:
+                    finishRun(run, reader.getU32());
+                    done = once;
+                    break;
+            }
+        }
+    }
+
+    if (run.file) {
+        fprintf(stderr, "stream ended inside a run\n");
+        finishRun(run, run.samples);
+    }
+    if (decoder.crcErrors) {
+        fprintf(stderr, "%u frames dropped with bad CRC\n", decoder.crcErrors);
+    }
+    close(fd);
+    return 0;
+}
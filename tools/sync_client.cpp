@@ -0,0 +1,487 @@
+// tools/sync_client.cpp - mirrors a stand's run files into a local directory
+//
+// Asks /api/sync what changed since the last sync and fetches only new or
+// changed data files; deleted ones are removed locally. An interrupted
+// download is kept as NAME.part-CURSOR and resumed with a Range request next
+// time, as long as the file has not changed on the stand since. The cursor is
+// saved in DIR/.sync-state only once everything it covers is mirrored, so a
+// sync that fails (the stand refuses downloads while a run is recorded) is
+// simply repeated.
+//
+//   g++ -std=c++17 -O2 tools/sync_client.cpp -o sync_client
+//
+//   sync_client --host thrustplotter.local[:80] --out DIR [--full]
+//
+// --full ignores the saved cursor and compares complete listings (names and
+// sizes), as after the stand's catalog is rebuilt. To try it without a
+// device, run the host build with --http 8080 and use --host 127.0.0.1:8080.
+#include <ctype.h>
+#include <dirent.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Just enough JSON for /api/sync
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    const Json& operator[](const char* key) const {
+        static const Json missing;
+        for (const auto& member : members) {
+            if (member.first == key) return member.second;
+        }
+        return missing;
+    }
+};
+
+struct JsonParser {
+    const char* p;
+    bool ok = true;
+
+    void skipSpace() {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    }
+
+    std::string parseString() {
+        std::string out;
+        p++;  // Opening quote
+        while (*p && *p != '"') {
+            if (*p != '\\') {
+                out += *p++;
+                continue;
+            }
+            p++;
+            switch (*p) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    unsigned code = strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+                    p += 4;
+                    if (code < 0x80) {
+                        out += (char)code;
+                    } else if (code < 0x800) {
+                        out += (char)(0xC0 | (code >> 6));
+                        out += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        out += (char)(0xE0 | (code >> 12));
+                        out += (char)(0x80 | ((code >> 6) & 0x3F));
+                        out += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: out += *p; break;  // \" \\ \/
+            }
+            if (*p) p++;
+        }
+        if (*p != '"') ok = false;
+        else p++;
+        return out;
+    }
+
+    Json parse() {
+        Json value;
+        skipSpace();
+        if (*p == '{') {
+            value.type = Json::OBJECT;
+            p++;
+            skipSpace();
+            while (ok && *p != '}') {
+                skipSpace();
+                if (*p != '"') { ok = false; break; }
+                std::string key = parseString();
+                skipSpace();
+                if (*p != ':') { ok = false; break; }
+                p++;
+                value.members.push_back({key, parse()});
+                skipSpace();
+                if (*p == ',') p++;
+                else if (*p != '}') ok = false;
+            }
+            if (ok) p++;
+        } else if (*p == '[') {
+            value.type = Json::ARRAY;
+            p++;
+            skipSpace();
+            while (ok && *p != ']') {
+                value.items.push_back(parse());
+                skipSpace();
+                if (*p == ',') p++;
+                else if (*p != ']') ok = false;
+            }
+            if (ok) p++;
+        } else if (*p == '"') {
+            value.type = Json::STRING;
+            value.text = parseString();
+        } else if (!strncmp(p, "true", 4) || !strncmp(p, "false", 5)) {
+            value.type = Json::BOOL;
+            value.boolean = *p == 't';
+            p += value.boolean ? 4 : 5;
+        } else if (!strncmp(p, "null", 4)) {
+            p += 4;
+        } else {
+            char* end;
+            value.type = Json::NUMBER;
+            value.number = strtod(p, &end);
+            if (end == p) ok = false;
+            p = end;
+        }
+        return value;
+    }
+};
+
+struct Response {
+    int status = 0;
+    std::string contentRange;
+    bool complete = false;   // Body ended where the headers said it would
+};
+
+static std::string host = "thrustplotter.local";
+static std::string port = "80";
+
+static int connectToStand() {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (error != 0) {
+        fprintf(stderr, "%s: %s\n", host.c_str(), gai_strerror(error));
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* a = found; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    if (fd < 0) perror(host.c_str());
+    return fd;
+}
+
+// Buffered reads from the connection
+struct Connection {
+    int fd;
+    char buffer[8192] = {};
+    size_t start = 0, end = 0;
+
+    bool fill() {
+        if (start < end) return true;
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) return false;
+        start = 0;
+        end = n;
+        return true;
+    }
+    bool readLine(std::string& line) {
+        line.clear();
+        while (fill()) {
+            char c = buffer[start++];
+            if (c == '\n') {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            line += c;
+        }
+        return false;
+    }
+    // Up to max bytes of what has arrived; 0 at the end of the connection
+    size_t readSome(char* out, size_t max) {
+        if (!fill()) return 0;
+        size_t n = end - start < max ? end - start : max;
+        memcpy(out, buffer + start, n);
+        start += n;
+        return n;
+    }
+};
+
+// GET path; response is filled in from the headers before the body goes to
+// sink as it arrives (plain, chunked, or until the connection closes)
+template <typename Sink>
+static void httpGet(const std::string& path, const std::string& range, Response& response, Sink sink) {
+    response = Response();
+    int fd = connectToStand();
+    if (fd < 0) return;
+
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n";
+    if (!range.empty()) request += "Range: " + range + "\r\n";
+    request += "\r\n";
+    if (write(fd, request.data(), request.size()) != (ssize_t)request.size()) {
+        close(fd);
+        return;
+    }
+
+    Connection connection{fd};
+    std::string line;
+    if (!connection.readLine(line) || sscanf(line.c_str(), "HTTP/%*s %d", &response.status) != 1) {
+        close(fd);
+        return;
+    }
+    long long contentLength = -1;
+    bool chunked = false;
+    while (connection.readLine(line) && !line.empty()) {
+        std::string name = line.substr(0, line.find(':'));
+        std::string value = line.find(':') == std::string::npos ? "" : line.substr(line.find(':') + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        if (!strcasecmp(name.c_str(), "Content-Length")) contentLength = atoll(value.c_str());
+        if (!strcasecmp(name.c_str(), "Transfer-Encoding")) chunked = value.find("chunked") != std::string::npos;
+        if (!strcasecmp(name.c_str(), "Content-Range")) response.contentRange = value;
+    }
+
+    char data[8192];
+    if (chunked) {
+        while (connection.readLine(line)) {
+            long long size = strtoll(line.c_str(), nullptr, 16);
+            if (size == 0) {
+                response.complete = true;
+                break;
+            }
+            while (size > 0) {
+                size_t n = connection.readSome(data, size < (long long)sizeof(data) ? size : sizeof(data));
+                if (n == 0) break;
+                sink(data, n);
+                size -= n;
+            }
+            if (size > 0 || !connection.readLine(line)) break;  // Cut off inside a chunk
+        }
+    } else {
+        long long received = 0;
+        size_t n;
+        while ((contentLength < 0 || received < contentLength) &&
+               (n = connection.readSome(data, sizeof(data))) > 0) {
+            if (contentLength >= 0 && received + (long long)n > contentLength) n = contentLength - received;
+            sink(data, n);
+            received += n;
+        }
+        response.complete = contentLength < 0 || received == contentLength;
+    }
+    close(fd);
+}
+
+static std::string urlEncode(const std::string& text) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += c;
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+static long long fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+// Device names may hold characters the host does not want in a path
+static std::string localName(const std::string& name) {
+    std::string out = name;
+    for (char& c : out) {
+        if (c == '/' || c == '\\') c = '_';
+    }
+    return out;
+}
+
+// Partial downloads of a file, from any version of it
+static std::vector<std::string> partsOf(const std::string& dir, const std::string& name) {
+    std::vector<std::string> parts;
+    std::string prefix = name + ".part-";
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(d)) {
+            if (!strncmp(entry->d_name, prefix.c_str(), prefix.size())) parts.push_back(dir + "/" + entry->d_name);
+        }
+        closedir(d);
+    }
+    return parts;
+}
+
+enum FetchResult { FETCHED, FETCH_FAILED, STAND_BUSY };
+
+static FetchResult fetchFile(const std::string& dir, const std::string& name, long long size, unsigned changed) {
+    std::string target = dir + "/" + localName(name);
+    std::string part = target + ".part-" + std::to_string(changed);
+
+    // Parts of older versions of the file cannot be resumed
+    for (const std::string& stale : partsOf(dir, localName(name))) {
+        if (stale != part) unlink(stale.c_str());
+    }
+
+    long long have = fileSize(part);
+    if (have < 0 || have > size) have = 0;
+    std::string range = have > 0 ? "bytes=" + std::to_string(have) + "-" : "";
+
+    FILE* file = nullptr;
+    bool resumed = false;
+    Response response;
+    httpGet("/download?path=" + urlEncode("/data/runs/" + name), range, response, [&](const char* data, size_t n) {
+        if (!file) {
+            // A stand that ignores the range sends the whole file
+            resumed = response.status == 206 && response.contentRange.find("bytes " + std::to_string(have) + "-") == 0;
+            if (response.status != 200 && !resumed) return;
+            file = fopen(part.c_str(), resumed ? "ab" : "wb");
+            if (!file) {
+                perror(part.c_str());
+                return;
+            }
+        }
+        fwrite(data, 1, n, file);
+    });
+    if (file) {
+        fclose(file);
+    }
+    if (response.status == 503) return STAND_BUSY;
+    if (response.status != 200 && !resumed) {
+        fprintf(stderr, "%s: HTTP %d\n", name.c_str(), response.status);
+        unlink(part.c_str());
+        return FETCH_FAILED;
+    }
+    if (!response.complete || fileSize(part) != size) {
+        fprintf(stderr, "%s: interrupted at %lld of %lld bytes, resumes next time\n", name.c_str(), fileSize(part),
+                size);
+        return FETCH_FAILED;
+    }
+    if (rename(part.c_str(), target.c_str()) != 0) {
+        perror(target.c_str());
+        return FETCH_FAILED;
+    }
+    if (resumed) {
+        printf("resumed %s (%lld bytes, %lld transferred)\n", name.c_str(), size, size - have);
+    } else {
+        printf("fetched %s (%lld bytes)\n", name.c_str(), size);
+    }
+    return FETCHED;
+}
+
+static void removeLocal(const std::string& dir, const std::string& name) {
+    std::string target = dir + "/" + localName(name);
+    if (unlink(target.c_str()) == 0) printf("deleted %s\n", name.c_str());
+    for (const std::string& part : partsOf(dir, localName(name))) unlink(part.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::string outDir;
+    bool full = false;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--host" && hasValue) host = argv[++i];
+        else if (option == "--out" && hasValue) outDir = argv[++i];
+        else if (option == "--full") full = true;
+        else {
+            outDir.clear();
+            break;
+        }
+    }
+    if (outDir.empty()) {
+        fprintf(stderr, "usage: sync_client [--host HOST[:PORT]] --out DIR [--full]\n");
+        return 2;
+    }
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(':') == colon) {
+        port = host.substr(colon + 1);
+        host = host.substr(0, colon);
+    }
+    mkdir(outDir.c_str(), 0755);
+
+    // Epoch and cursor of the last complete sync
+    std::string statePath = outDir + "/.sync-state";
+    unsigned long epoch = 0, cursor = 0;
+    bool haveState = false;
+    if (FILE* state = fopen(statePath.c_str(), "r")) {
+        haveState = fscanf(state, "%lu %lu", &epoch, &cursor) == 2 && !full;
+        fclose(state);
+    }
+
+    std::string feed;
+    std::string query = haveState ? "?since=" + std::to_string(cursor) + "&epoch=" + std::to_string(epoch) : "";
+    Response response;
+    httpGet("/api/sync" + query, "", response, [&](const char* data, size_t n) { feed.append(data, n); });
+    if (response.status != 200 || !response.complete) {
+        fprintf(stderr, "sync_client: /api/sync failed (HTTP %d)\n", response.status);
+        return 1;
+    }
+    JsonParser parser{feed.c_str()};
+    Json changes = parser.parse();
+    if (!parser.ok || changes.type != Json::OBJECT) {
+        fprintf(stderr, "sync_client: cannot parse the change feed\n");
+        return 1;
+    }
+    bool reset = changes["reset"].boolean;
+
+    for (const Json& run : changes["runs"].items) {
+        printf("run %s: %s\n", run["name"].text.c_str(), run["notes"].text.c_str());
+    }
+    for (const Json& name : changes["deletedRuns"].items) {
+        printf("run %s deleted\n", name.text.c_str());
+    }
+    for (const Json& name : changes["deletedFiles"].items) {
+        removeLocal(outDir, name.text);
+    }
+
+    // A full listing: what is not in it is gone from the stand
+    if (reset) {
+        if (DIR* d = opendir(outDir.c_str())) {
+            std::vector<std::string> gone;
+            while (dirent* entry = readdir(d)) {
+                std::string local = entry->d_name;
+                if (local[0] == '.' || local.find(".part-") != std::string::npos) continue;
+                bool listed = false;
+                for (const Json& f : changes["files"].items) {
+                    listed = listed || localName(f["name"].text) == local;
+                }
+                if (!listed) gone.push_back(local);
+            }
+            closedir(d);
+            for (const std::string& local : gone) removeLocal(outDir, local);
+        }
+    }
+
+    int fetched = 0, failed = 0;
+    bool busy = false;
+    for (const Json& f : changes["files"].items) {
+        const std::string& name = f["name"].text;
+        long long size = (long long)f["size"].number;
+        // Compared by size alone in a full listing; listed changes are always fetched
+        if (reset && fileSize(outDir + "/" + localName(name)) == size) continue;
+        FetchResult result = busy ? STAND_BUSY : fetchFile(outDir, name, size, (unsigned)f["changed"].number);
+        if (result == FETCHED) fetched++;
+        else failed++;
+        if (result == STAND_BUSY && !busy) {
+            fprintf(stderr, "sync_client: the stand is busy recording, try again later\n");
+            busy = true;
+        }
+    }
+
+    printf("%d files fetched, %d not, %s sync from cursor %lu to %lu\n", fetched, failed,
+           reset ? "full" : "incremental", reset ? 0ul : cursor, (unsigned long)changes["cursor"].number);
+    if (failed > 0) {
+        return 1;
+    }
+    if (FILE* state = fopen(statePath.c_str(), "w")) {
+        fprintf(state, "%lu %lu\n", (unsigned long)changes["epoch"].number, (unsigned long)changes["cursor"].number);
+        fclose(state);
+    }
+    return 0;
+}
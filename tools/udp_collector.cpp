@@ -0,0 +1,305 @@
+// tools/udp_collector.cpp - collects runs streamed over UDP by one or more stands
+//
+// Receives the batches of include/stream_protocol.h (STREAM_UDP_BATCH, sent
+// by src/udp_stream.cpp) and writes each run to DIR/STAND/ in the device's
+// own CSV format, so files can be charted or uploaded like ones downloaded
+// from /api/data. Batches are put back in sequence order before writing;
+// lost, reordered and duplicated datagrams are counted and reported per run.
+//
+//   g++ -std=c++17 -O2 -Iinclude tools/udp_collector.cpp -o udp_collector
+//
+//   udp_collector [--port 5005] [--out DIR] [--timeout S] [--once]
+//
+// A run is written once its end marker and every batch before it have
+// arrived, or, with batches missing, a second after the end marker; a run
+// that goes --timeout seconds (default 10) without a datagram is written
+// with what arrived. --once exits after the first run is written. To try it
+// without a device, point the host build at it:
+//
+//   udp_collector --out /tmp/collected --once &
+//   .pio/build/native/program --sim step --udp 127.0.0.1:5005 --stand bench-1
+#include "stream_protocol.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <map>
+#include <netinet/in.h>
+#include <poll.h>
+#include <set>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+// Column names and formats as the device writes them (channels.h, data_logger.cpp)
+static const char* const columnNames[] = {"thrust_grams", "torque_nmm", "rpm"};
+static const char* const columnFormats[] = {",%.2f", ",%.2f", ",%.0f"};
+static const int channelCount = 3;
+
+#define END_GRACE_MS 1000  // Wait after the end marker for batches that are still on their way
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static uint64_t nowMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Device names may hold characters the host does not want in a path
+static std::string hostFileName(const char* name) {
+    std::string out = name;
+    for (char& c : out) {
+        if (c == '/' || c == '\\') c = '_';
+    }
+    return out.empty() || out == "." || out == ".." ? "unnamed" : out;
+}
+
+struct Row {
+    uint32_t timestamp;
+    float value[channelCount];
+};
+
+struct Run {
+    std::string stand;
+    std::string name;
+    std::string comment;
+    uint8_t channels = 0;
+    std::map<uint32_t, std::vector<Row>> batches;   // By sequence number
+    uint32_t highestSequence = 0;
+    bool ended = false;
+    uint32_t endSequence = 0;
+    uint32_t samplesSent = 0;                       // Known once the end marker arrives
+    uint32_t reordered = 0;
+    uint32_t duplicates = 0;
+    uint64_t lastSeen = 0;
+    uint64_t endSeen = 0;
+};
+
+// stand, boot id, run number
+typedef std::pair<std::string, std::pair<uint32_t, uint32_t>> RunKey;
+
+static bool complete(const Run& run) {
+    return run.ended && run.batches.size() == (size_t)run.endSequence + 1;
+}
+
+static void writeRun(const Run& run, const std::string& outDir) {
+    std::string dir = outDir + "/" + hostFileName(run.stand.c_str());
+    mkdir(dir.c_str(), 0755);
+    std::string path = dir + "/" + hostFileName(run.name.c_str());
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        perror(path.c_str());
+        return;
+    }
+    fprintf(file, "timestamp_ms");
+    for (int channel = 0; channel < channelCount; channel++) {
+        if (run.channels & (1u << channel)) fprintf(file, ",%s", columnNames[channel]);
+    }
+    fprintf(file, "\r\n");
+    if (!run.comment.empty()) fprintf(file, "# %s\r\n", run.comment.c_str());
+
+    uint32_t samples = 0;
+    for (const auto& batch : run.batches) {
+        for (const Row& row : batch.second) {
+            fprintf(file, "%lu", (unsigned long)row.timestamp);
+            for (int channel = 0; channel < channelCount; channel++) {
+                if (run.channels & (1u << channel)) fprintf(file, columnFormats[channel], row.value[channel]);
+            }
+            fprintf(file, "\r\n");
+            samples++;
+        }
+    }
+    fclose(file);
+
+    // Batches missing below the highest sequence number seen are lost; past it
+    // they are only known about when the end marker came
+    uint32_t lastSequence = run.ended ? run.endSequence : run.highestSequence;
+    uint32_t lostBatches = lastSequence + 1 - (uint32_t)run.batches.size();
+    fprintf(stderr, "run written: %s, %u samples", path.c_str(), samples);
+    if (run.ended) fprintf(stderr, " of %u sent", run.samplesSent);
+    fprintf(stderr, ", %u datagrams lost, %u reordered, %u duplicated%s\n", lostBatches, run.reordered,
+            run.duplicates, run.ended ? "" : " (end marker not received, more may be lost)");
+}
+
+// Runs already written; their late datagrams (the second end marker) are dropped
+static std::set<RunKey> writtenRuns;
+static uint32_t lateDatagrams = 0;
+
+// Files a datagram; false if it is not a batch
+static bool receiveBatch(std::map<RunKey, Run>& runs, const uint8_t* datagram, size_t size, const char* sender) {
+    uint8_t type;
+    const uint8_t* payload;
+    uint16_t length;
+    if (!decodeStreamFrame(datagram, size, type, payload, length) || type != STREAM_UDP_BATCH) {
+        return false;
+    }
+
+    StreamReader reader(payload, length);
+    char stand[256], name[256], comment[256];
+    reader.getText(stand, sizeof(stand));
+    uint32_t bootId = reader.getU32();
+    uint32_t runNumber = reader.getU32();
+    uint32_t sequence = reader.getU32();
+    uint8_t flags = reader.getU8();
+    uint8_t channels = reader.getU8();
+    reader.getText(name, sizeof(name));
+    reader.getText(comment, sizeof(comment));
+    uint32_t firstSample = reader.getU32();
+    uint8_t count = reader.getU8();
+
+    std::vector<Row> rows(count);
+    for (Row& row : rows) {
+        row.timestamp = reader.getU32();
+        for (int channel = 0; channel < channelCount; channel++) {
+            row.value[channel] = (channels & (1u << channel)) ? reader.getFloat() : 0;
+        }
+    }
+    if (reader.pos > length) {
+        return false;  // Shorter than its sample count says
+    }
+
+    RunKey key(stand, std::make_pair(bootId, runNumber));
+    if (writtenRuns.count(key)) {
+        if (!(flags & STREAM_UDP_FLAG_END)) lateDatagrams++;
+        return true;
+    }
+    auto found = runs.find(key);
+    if (found == runs.end()) {
+        Run& run = runs[key];
+        run.stand = stand;
+        run.name = name;
+        run.comment = comment;
+        run.channels = channels;
+        run.highestSequence = sequence;
+        fprintf(stderr, "run started: %s from %s (%s)\n", name, stand, sender);
+        if (sequence > 0) {
+            fprintf(stderr, "  %s: datagrams 0-%u missing so far\n", stand, sequence - 1);
+        }
+        found = runs.find(key);
+    }
+
+    Run& run = found->second;
+    run.lastSeen = nowMs();
+    if (flags & STREAM_UDP_FLAG_END && !run.ended) {
+        run.ended = true;
+        run.endSequence = sequence;
+        run.samplesSent = firstSample + count;
+        run.endSeen = run.lastSeen;
+    }
+
+    if (run.batches.count(sequence)) {
+        // The end marker is sent twice on purpose
+        if (!(flags & STREAM_UDP_FLAG_END)) run.duplicates++;
+        return true;
+    }
+    if (sequence < run.highestSequence) {
+        run.reordered++;
+    } else if (sequence > run.highestSequence + 1 && !run.batches.empty()) {
+        fprintf(stderr, "  %s: datagrams %u-%u missing so far\n", stand, run.highestSequence + 1, sequence - 1);
+    }
+    if (sequence > run.highestSequence) run.highestSequence = sequence;
+    run.batches[sequence] = rows;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string outDir = ".";
+    int port = STREAM_UDP_PORT;
+    unsigned timeoutS = 10;
+    bool once = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--port" && hasValue) port = atoi(argv[++i]);
+        else if (option == "--out" && hasValue) outDir = argv[++i];
+        else if (option == "--timeout" && hasValue) timeoutS = atoi(argv[++i]);
+        else if (option == "--once") once = true;
+        else {
+            fprintf(stderr, "usage: udp_collector [--port N] [--out DIR] [--timeout S] [--once]\n");
+            return 2;
+        }
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&local, sizeof(local)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    // Room for bursts while runs are being written
+    int receiveBuffer = 1 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    fprintf(stderr, "listening on UDP port %d, writing to %s\n", port, outDir.c_str());
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    std::map<RunKey, Run> runs;
+    uint32_t rejected = 0;
+    bool done = false;
+    uint8_t datagram[65536];
+    while (!done && !stopRequested) {
+        pollfd waiting = {fd, POLLIN, 0};
+        int ready = poll(&waiting, 1, 200);  // Wake up to write runs that are finished or timed out
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        if (ready > 0) {
+            sockaddr_in from;
+            socklen_t fromLength = sizeof(from);
+            ssize_t n = recvfrom(fd, datagram, sizeof(datagram), 0, (sockaddr*)&from, &fromLength);
+            if (n >= 0) {
+                char sender[64];
+                snprintf(sender, sizeof(sender), "%s:%u", inet_ntoa(from.sin_addr), ntohs(from.sin_port));
+                if (!receiveBatch(runs, datagram, n, sender)) rejected++;
+            }
+        }
+
+        uint64_t now = nowMs();
+        for (auto it = runs.begin(); it != runs.end();) {
+            const Run& run = it->second;
+            bool finished = complete(run) || (run.ended && now - run.endSeen >= END_GRACE_MS) ||
+                            now - run.lastSeen >= timeoutS * 1000ull;
+            if (!finished) {
+                ++it;
+                continue;
+            }
+            writeRun(run, outDir);
+            writtenRuns.insert(it->first);
+            it = runs.erase(it);
+            done = once;
+        }
+    }
+
+    for (const auto& entry : runs) {
+        fprintf(stderr, "collector stopped inside a run\n");
+        writeRun(entry.second, outDir);
+    }
+    if (lateDatagrams) {
+        fprintf(stderr, "%u datagrams arrived after their run was written\n", lateDatagrams);
+    }
+    if (rejected) {
+        fprintf(stderr, "%u datagrams were not valid batches\n", rejected);
+    }
+    close(fd);
+    return 0;
+}